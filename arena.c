@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/**
+ * The arena translation unit implements a bump allocator. Every block
+ * starts with a header that chains it to the previous block, and pieces
+ * are cut from the end of the newest block until it is full.
+ */
+
+/**
+ * The alignment of every piece, enough for any of the types the
+ * assembler stores.
+ */
+union alignment {
+	long int integer;
+	double real;
+	void *pointer;
+};
+
+#define ALIGNMENT sizeof(union alignment) /* Every piece starts at a multiple of this. */
+#define ALIGN(size) (((size) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT) /* Rounds the given size up to the alignment. */
+
+/**
+ * Defining the block data structure.
+ * A single block of an arena, the pieces follow the header.
+ */
+struct block {
+	struct block *previous; /* The block that was allocated before this one. */
+	union alignment start; /* Aligns the first piece, the pieces start here. */
+};
+
+#define BLOCK_HEADER offsetof(struct block, start) /* The size of the header of a block. */
+
+/**
+ * Defining the arena data structure.
+ * A region of memory that hands out pieces of large blocks and frees
+ * all of them at once, for data that lives as long as a single source
+ * file is assembled.
+ */
+struct arena {
+	struct block *last; /* The newest block, null if there is none. */
+	size_t used; /* The used part of the newest block (in bytes, after the header). */
+	size_t size; /* The size of the newest block (in bytes, after the header). */
+	size_t blockSize; /* The size of a new block (in bytes, after the header). */
+};
+
+/**
+ * Creates a new empty arena that allocates blocks of the given size (in
+ * bytes), larger pieces get a block of their own.
+ * Returns a pointer to the new arena or a null pointer if the memory
+ * allocation had failed.
+ */
+Arena *createArena(size_t blockSize) {
+	Arena *arena = malloc(sizeof(Arena));
+
+	if (arena == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	arena->last = NULL;
+	arena->used = 0;
+	arena->size = 0;
+	arena->blockSize = ALIGN(blockSize);
+
+	return arena;
+}
+
+/**
+ * Allocates a piece of the given size (in bytes) from the given arena,
+ * aligned for any type. The piece cannot be freed on its own.
+ * Returns a pointer to the piece or a null pointer if the memory
+ * allocation had failed.
+ */
+void *allocArena(Arena *arena, size_t size) {
+	struct block *block;
+	size_t blockSize;
+
+	size = ALIGN(size);
+	if (arena->size - arena->used < size) { /* The newest block is full. */
+		blockSize = size > arena->blockSize ? size : arena->blockSize;
+		if ((block = malloc(BLOCK_HEADER + blockSize)) == NULL)
+			return NULL; /* Memory allocation failed. */
+		block->previous = arena->last;
+		arena->last = block;
+		arena->used = 0;
+		arena->size = blockSize;
+	}
+
+	arena->used += size;
+	return (char *)&arena->last->start + arena->used - size;
+}
+
+/**
+ * Copies the given string into the given arena.
+ * Returns a pointer to the copy or a null pointer if the memory
+ * allocation had failed.
+ */
+char *copyArenaString(Arena *arena, const char *str) {
+	const size_t length = strlen(str) + 1; /* +1 for a terminating character. */
+	char *copy = allocArena(arena, length);
+
+	if (copy != NULL)
+		memcpy(copy, str, length);
+	return copy;
+}
+
+/**
+ * Frees all the memory used by the given arena, including every piece
+ * that was allocated from it.
+ */
+void freeArena(Arena *arena) {
+	struct block *block;
+
+	while ((block = arena->last) != NULL) {
+		arena->last = block->previous;
+		free(block);
+	}
+	free(arena);
+}
@@ -0,0 +1,47 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ * An header file for the arena translation unit.
+ */
+
+/**
+ * Defining the arena data structure.
+ * A region of memory that hands out pieces of large blocks and frees
+ * all of them at once, for data that lives as long as a single source
+ * file is assembled.
+ */
+typedef struct arena Arena;
+
+/**
+ * Creates a new empty arena that allocates blocks of the given size (in
+ * bytes), larger pieces get a block of their own.
+ * Returns a pointer to the new arena or a null pointer if the memory
+ * allocation had failed.
+ */
+Arena *createArena(size_t blockSize);
+
+/**
+ * Allocates a piece of the given size (in bytes) from the given arena,
+ * aligned for any type. The piece cannot be freed on its own.
+ * Returns a pointer to the piece or a null pointer if the memory
+ * allocation had failed.
+ */
+void *allocArena(Arena *arena, size_t size);
+
+/**
+ * Copies the given string into the given arena.
+ * Returns a pointer to the copy or a null pointer if the memory
+ * allocation had failed.
+ */
+char *copyArenaString(Arena *arena, const char *str);
+
+/**
+ * Frees all the memory used by the given arena, including every piece
+ * that was allocated from it.
+ */
+void freeArena(Arena *arena);
+
+#endif
@@ -58,6 +58,8 @@ Flag extractJParam(char *sourceLine, const int startIndex, const int endIndex, c
 Flag rangeWord(char *sourceLine, Expectation *expecting, int *startIndex, int *endIndex);
 Flag extractWord(char *sourceLine, const int startIndex, const int endIndex, const Flag type, char *word);
 
+int localReferenceLength(const char *str);
+
 
 /**
  * Scans from a given position of a stream until a new line or terminating
@@ -783,10 +785,10 @@ Flag extractIParam(char *sourceLine, const int startIndex, const int endIndex, c
 		/* Skipping to the label. */
 		while (!isalnum(*pointer))
 			pointer++;
-		if (isdigit(*pointer))
-			return IllegalSymbolFlag; /* Label symbols cannot start with a digit. */
 		/* Allocating memory for the label's symbol. */
 		symbolSize = endIndex - (pointer - sourceLine) + 2;
+		if (isdigit(*pointer) && localReferenceLength(pointer) != symbolSize - 1)
+			return IllegalSymbolFlag; /* Label symbols cannot start with a digit, unless they refer to a numeric local label. */
 		if (symbolSize > MAX_REGISTER + 1) /* + 1 for a terminating character. */
 			return IllegalSymbolFlag; /* Label symbols cannot be longer than 31. */
 
@@ -870,6 +872,7 @@ Flag rangeJParam(char *sourceLine, Expectation *expecting, char *isRegister, int
 	char c; /* For readability purposes. */
 	char isSpaceAllowed = 1; /* To track parts were spaces or tabs can be. */
 	char isLineEmpty = 1; /* To track if this part of the line is empty or not. */
+	int length; /* The length of a reference to a numeric local label. */
 	Flag endStatus = NoIssueFlag; /* To detect issues in the source code. */
 
 	*expecting = ExpectDollarSign; /* Expecting the beginning of the operand, but it is not necessarily a register. */
@@ -909,6 +912,12 @@ Flag rangeJParam(char *sourceLine, Expectation *expecting, char *isRegister, int
 			continue;
 		}
 		if (isdigit(c)) { /* Current character is a digit. */
+			if (*expecting == ExpectDollarSign && (length = localReferenceLength(sourceLine + index)) != 0 && !isalnum(sourceLine[index + length])) {
+				index += length - 1; /* A reference to a numeric local label, skipping to its suffix. */
+				*expecting = ExpectLabel; /* The operand is a label. */
+				isLineEmpty = 0; /* The line is not empty. */
+				continue;
+			}
 			if (*expecting != ExpectDigit && *expecting != ExpectLabel && *expecting != ExpectDigitOrEnd) {
 				if (*expecting == ExpectDollarSign)
 					endStatus = IllegalSymbolFlag; /* A label symbol cannot start with a digit. */
@@ -1046,6 +1055,7 @@ Flag rangeWord(char *sourceLine, Expectation *expecting, int *startIndex, int *e
 	char c; /* For readability purposes. */
 	char isSpaceAllowed = 1; /* To track parts were spaces or tabs can be. */
 	char isLineEmpty = 1; /* To track if this part of the line is empty or not. */
+	int digits; /* The number of a numeric local label. */
 	Flag endStatus = OperatorFlag; /* The word is an operator by default. */
 
 	*expecting = ExpectWord; /* Expecting the beginning of the source line. */
@@ -1097,6 +1107,11 @@ Flag rangeWord(char *sourceLine, Expectation *expecting, int *startIndex, int *e
 			continue;
 		}
 		if (isdigit(c)) { /* Current character is a digit. */
+			if (*expecting == ExpectWord && (digits = localLabelLength(sourceLine + index)) != 0 && sourceLine[index + digits] == COLON) {
+				index += digits - 1; /* A numeric local label, the colon comes next. */
+				isLineEmpty = 0; /* The line is not empty. */
+				continue;
+			}
 			if (*expecting != ExpectAlphanum) {
 				if (*expecting == ExpectWord)
 					endStatus = IllegalSymbolFlag; /* A label symbol cannot start with a digit. */
@@ -1197,6 +1212,44 @@ Flag getWord(char *sourceLine, Expectation *expecting, int *index, char *word) {
 	return endStatus;
 }
 
+/**
+ * Checks if the given string begins with the number of a numeric local
+ * label, that is 1 to MAX_LOCAL_DIGITS decimal digits.
+ * Returns the number of digits, or 0 if it does not.
+ */
+int localLabelLength(const char *str) {
+	int length = 0;
+
+	while (isdigit(str[length]))
+		length++;
+	return length <= MAX_LOCAL_DIGITS ? length : 0;
+}
+
+/**
+ * Checks if the given string begins with a reference to a numeric local
+ * label, a number followed by BACKWARD_SUFFIX or FORWARD_SUFFIX.
+ * Returns the length of the reference, suffix included, or 0 if it does
+ * not.
+ */
+int localReferenceLength(const char *str) {
+	const int digits = localLabelLength(str);
+
+	if (digits == 0 || (str[digits] != BACKWARD_SUFFIX && str[digits] != FORWARD_SUFFIX))
+		return 0; /* Not a reference. */
+	return digits + 1; /* +1 for the suffix. */
+}
+
+/**
+ * Checks if the given symbol is a reference to a numeric local label,
+ * a number followed by BACKWARD_SUFFIX or FORWARD_SUFFIX.
+ * Returns SUCCESS if it is and ERROR otherwise.
+ */
+Code isLocalReference(const char *symbol) {
+	const int length = localReferenceLength(symbol);
+
+	return (length != 0 && symbol[length] == TERMINATING_CHAR) ? SUCCESS : ERROR;
+}
+
 /**
  * Checks if the extension of the given file's name is an assembly source
  * code file, in other words if the given string ends with ".as".
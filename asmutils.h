@@ -18,6 +18,10 @@
 /* Others. */
 #define FILE_EXTENSION ".as" /* The extension for the assembly source files. */
 #define FILE_EXTENSION_LEN 3 /* The length of the assembly source file extension. */
+/* Numeric local labels. */
+#define MAX_LOCAL_DIGITS 4 /* The maximum number of digits of a numeric local label. */
+#define BACKWARD_SUFFIX 'b' /* Refers to the nearest definition of a numeric local label at or before the line. */
+#define FORWARD_SUFFIX 'f' /* Refers to the nearest definition of a numeric local label after the line. */
 
 /**
  * The error code data type can be ERROR or SUCCESS and is returned by
@@ -189,6 +193,20 @@ Flag getJParam(char *sourceLine, Expectation *expecting, int *index, char *reg,
  */
 Flag getWord(char *sourceLine, Expectation *expecting, int *index, char *word);
 
+/**
+ * Checks if the given string begins with the number of a numeric local
+ * label, that is 1 to MAX_LOCAL_DIGITS decimal digits.
+ * Returns the number of digits, or 0 if it does not.
+ */
+int localLabelLength(const char *str);
+
+/**
+ * Checks if the given symbol is a reference to a numeric local label,
+ * a number followed by BACKWARD_SUFFIX or FORWARD_SUFFIX.
+ * Returns SUCCESS if it is and ERROR otherwise.
+ */
+Code isLocalReference(const char *symbol);
+
 /**
  * Checks if the extension of the given file's name is an assembly source
  * code file, in other words if the given string ends with ".as".
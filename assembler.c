@@ -5,6 +5,8 @@
 #include "asmutils.h"
 #include "keywords.h"
 #include "errmsg.h"
+#include "options.h"
+#include "exports.h"
 
 /**
  * Assembles the content of the source files, provided as arguments, from assembly
@@ -16,11 +18,21 @@
  * arguments. The main function is responsible for opening the assembly source files
  * as streams and passing them forward to where they will be assembled. At the end
  * it closes every stream.
+ * Arguments that start with a dash are options, they apply to every source file
+ * no matter where they appear.
+ * In resolve mode the external labels of the source files are checked against
+ * the entry labels of the whole batch once every file was assembled, and the
+ * exit status tells if any of them could not be resolved.
+ * In check mode the exit status tells if any of the source files had issues.
  */
 int main(int argc, char const *argv[]) {
 
-	int index;
+	int index, optionIndex;
+	int status = EXIT_SUCCESS; /* The exit status. */
 	FILE *file; /* Used for accessing files as streams. */
+	Options *options; /* The settings given on the command line. */
+	Exports *exports = NULL; /* The entry labels of the batch, in resolve mode only. */
+	char *isSourceFile; /* Marks the arguments that are source file names. */
 
 	/* Initializing the assembly keywords container. */
 	if (initasmKeywords() == ERROR) {
@@ -28,13 +40,35 @@ int main(int argc, char const *argv[]) {
 		errFatal();
 	}
 
+	if ((options = createOptions()) == NULL || (isSourceFile = calloc(argc, sizeof(char))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	/* Parsing the options before assembling anything. */
+	for (index = 1; index < argc; index++) {
+		if (isOption(argv[index]) == ERROR) {
+			isSourceFile[index] = 1; /* Will be assembled after all the options are known. */
+			continue;
+		}
+		optionIndex = index; /* The option may consume the next argument. */
+		if (parseOption(options, argc, argv, &index) == ERROR)
+			/* Ignoring the option, the rest can still be used. */
+			printf("%s%s\n", "Invalid option: ", argv[optionIndex]);
+	}
+
+	if (isResolving(options) == SUCCESS && (exports = createExports()) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
 	/* Relevant arguments starts at 1. */
 	for (index = 1; index < argc; index++) {
 
+		if (!isSourceFile[index])
+			continue; /* Options were already handled. */
+
 		/* Checking if the file extension is valid. */
 		if (isValid(argv[index]) == ERROR) {
 			/* Skipping the file if it is not an assembly source code file. */
 			printf("%s%s\n", "Invalid file type: ", argv[index]);
+			status = EXIT_FAILURE;
 			continue;
 		}
 
@@ -43,16 +77,30 @@ int main(int argc, char const *argv[]) {
 		if (file == NULL) {
 			/* Skipping the file if it is not accessible. */
 			printf("%s%s\n", "Could not access this file: ", argv[index]);
+			status = EXIT_FAILURE;
 			continue;
 		}
 		/* Assembling the file. */
-		assemble(file, argv[index]);
+		if (assemble(file, argv[index], options, exports) == ERROR)
+			status = EXIT_FAILURE;
 		/* Closing the file. */
 		fclose(file);
 	}
 
+	if (isCheckOnly(options) == ERROR)
+		status = EXIT_SUCCESS; /* Only check mode reports the issues of the source files trough the exit status. */
+
+	/* Resolving the external labels of the batch, which always reports its issues trough the exit status. */
+	if (exports != NULL) {
+		if (checkExports(exports) == ERROR)
+			status = EXIT_FAILURE;
+		freeExports(exports);
+	}
+
 	/* Freeing all the memory used by the assembly keywords container. */
 	clearasmKeywords();
+	freeOptions(options);
+	free(isSourceFile);
 
-	return 0;
+	return status;
 }
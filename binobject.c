@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "binobject.h"
+#include "symboltable.h"
+#include "converter.h"
+#include "errmsg.h"
+#include "utils.h"
+
+/**
+ * The binary object translation unit writes the optional binary object
+ * file, the same program as the object file in a layout that can be
+ * used straight from memory.
+ */
+
+#define INITIAL_EXTERNS 64 /* The initial capacity of the extern records array. */
+#define WORD_SIZE 4 /* The size of every number and code word in the file (in bytes). */
+
+/**
+ * Defining the binary record data structure.
+ * An entry or extern record before it is written.
+ */
+struct binrecord {
+	unsigned long int address; /* The address of the label, or the address that uses it. */
+	Label label; /* The label. */
+};
+
+/**
+ * Defining the binary object data structure.
+ * Holds the stream of a binary object file and the extern records until
+ * the tables are written.
+ */
+struct binobject {
+	FILE *output; /* The binary object file. */
+	unsigned long int ic, dc; /* The size of the code segment and the size of the data segment. */
+	struct binrecord *externs; /* The extern records in the order of use. */
+	unsigned long int externCount; /* The number of extern records. */
+	unsigned long int externCapacity; /* The capacity of the extern records array. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+void writeBinaryHeader(BinaryObject *object, unsigned long int entryCount, unsigned long int stringsSize);
+unsigned long int addBinaryString(SymbolTable *symbolTable, Label label, unsigned long int *offsets, Label *order, unsigned long int *count, unsigned long int *size);
+int compareBinaryRecords(const void *first, const void *second);
+
+/**
+ * Creates a new binary object that writes into the given stream, which
+ * should not have been written yet, a program with the given size of
+ * the code segment and the given size of the data segment.
+ * Returns a pointer to the new binary object or a null pointer if the
+ * memory allocation had failed.
+ */
+BinaryObject *createBinaryObject(FILE *output, unsigned long int ic, unsigned long int dc) {
+	BinaryObject *object = calloc(1, sizeof(BinaryObject)); /* Every field starts empty. */
+
+	if (object == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	object->output = output;
+	object->ic = ic;
+	object->dc = dc;
+	writeBinaryHeader(object, 0, 0); /* The counts are known only once the tables are written. */
+
+	return object;
+}
+
+/**
+ * Writes the given bit field as the next word of the code segment.
+ */
+void writeBinaryCode(BinaryObject *object, unsigned long int data) {
+	writeWord(object->output, data);
+}
+
+/**
+ * Adds an extern record for the given external label, used by the code
+ * word at the given address.
+ */
+void addBinaryExtern(BinaryObject *object, Label label, unsigned long int address) {
+	struct binrecord *record; /* The new record. */
+
+	if (object->externCount == object->externCapacity) { /* Making room for the record. */
+		object->externCapacity = object->externCapacity ? object->externCapacity * 2 : INITIAL_EXTERNS;
+		if ((record = realloc(object->externs, object->externCapacity * sizeof(struct binrecord))) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		object->externs = record;
+	}
+	record = object->externs + object->externCount++;
+	record->address = address;
+	record->label = label;
+}
+
+/**
+ * Writes the given data segment, the entry labels of the given symbol
+ * table and the extern records after the code segment and completes the
+ * header. Should be called once, after the whole code segment was
+ * written.
+ */
+void writeBinaryTables(BinaryObject *object, SymbolTable *symbolTable, const char *dataSegment) {
+	struct binrecord *entries; /* The entry records. */
+	unsigned long int *offsets; /* The offset of the symbol of every label in the string table, zero if it is not there. */
+	Label *order; /* The labels of the string table in the order of their symbols. */
+	unsigned long int entryCount = 0, labelCount = 0, stringCount = 0, stringsSize = 1; /* The string table starts with an empty string. */
+	unsigned long int index;
+	Label label; /* To loop trough the labels. */
+
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label)) {
+		if (hasAttribute(symbolTable, label, EntryLabel) == SUCCESS)
+			entryCount++;
+		if (label > labelCount)
+			labelCount = label;
+	}
+
+	if ((entries = malloc((entryCount + 1) * sizeof(struct binrecord))) == NULL ||
+		(offsets = calloc(labelCount + 1, sizeof(unsigned long int))) == NULL ||
+		(order = malloc((labelCount + 1) * sizeof(Label))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	for (label = getFirst(symbolTable), index = 0; label != NO_LABEL; label = getNext(symbolTable, label)) {
+		if (hasAttribute(symbolTable, label, EntryLabel) == SUCCESS) {
+			entries[index].address = getAddress(symbolTable, label);
+			entries[index++].label = label;
+		}
+	}
+	qsort(entries, entryCount, sizeof(struct binrecord), compareBinaryRecords);
+
+	/* The data segment, padded so the records start on a word boundary. */
+	fwrite(dataSegment, 1, object->dc, object->output);
+	for (index = object->dc; index % WORD_SIZE != 0; index++)
+		fputc(0, object->output);
+
+	for (index = 0; index < entryCount; index++) {
+		writeWord(object->output, entries[index].address);
+		writeWord(object->output, addBinaryString(symbolTable, entries[index].label, offsets, order, &stringCount, &stringsSize));
+	}
+	for (index = 0; index < object->externCount; index++) {
+		writeWord(object->output, object->externs[index].address);
+		writeWord(object->output, addBinaryString(symbolTable, object->externs[index].label, offsets, order, &stringCount, &stringsSize));
+	}
+
+	fputc('\0', object->output); /* The empty string. */
+	for (index = 0; index < stringCount; index++)
+		fwrite(getSymbol(symbolTable, order[index]), 1, strlen(getSymbol(symbolTable, order[index])) + 1, object->output);
+
+	writeBinaryHeader(object, entryCount, stringsSize);
+	free(entries);
+	free(offsets);
+	free(order);
+}
+
+/**
+ * Frees all the memory used by the given binary object, the stream is
+ * not closed.
+ */
+void freeBinaryObject(BinaryObject *object) {
+	free(object->externs);
+	free(object);
+}
+
+/**
+ * Returns the offset of the symbol of the given label in the string
+ * table. A symbol that is not in the table yet is placed at its end:
+ * its offset is kept in the offsets array, its label is added to the
+ * order array and the number of symbols and the size of the table are
+ * updated.
+ */
+unsigned long int addBinaryString(SymbolTable *symbolTable, Label label, unsigned long int *offsets, Label *order, unsigned long int *count, unsigned long int *size) {
+	if (offsets[label] == 0) { /* The first use of the symbol, no symbol is at the empty string. */
+		offsets[label] = *size;
+		order[(*count)++] = label;
+		*size += strlen(getSymbol(symbolTable, label)) + 1; /* +1 for a terminating character. */
+	}
+	return offsets[label];
+}
+
+/**
+ * Compares two binary records by their addresses, records with the same
+ * address keep the order of the symbol table. Used for sorting.
+ */
+int compareBinaryRecords(const void *first, const void *second) {
+	const struct binrecord *firstRecord = first, *secondRecord = second;
+
+	if (firstRecord->address != secondRecord->address)
+		return firstRecord->address < secondRecord->address ? -1 : 1;
+	return firstRecord->label < secondRecord->label ? -1 : firstRecord->label > secondRecord->label;
+}
+
+/**
+ * Writes the header of the binary object file, at the beginning of its
+ * stream, with the given number of entry records and the given size of
+ * the string table. The stream is left at its end.
+ */
+void writeBinaryHeader(BinaryObject *object, unsigned long int entryCount, unsigned long int stringsSize) {
+	rewind(object->output);
+	fwrite(BINARY_MAGIC, 1, strlen(BINARY_MAGIC), object->output);
+	writeWord(object->output, BINARY_VERSION);
+	writeWord(object->output, MEMORY_START_ADDRESS);
+	writeWord(object->output, object->ic);
+	writeWord(object->output, object->dc);
+	writeWord(object->output, entryCount);
+	writeWord(object->output, object->externCount);
+	writeWord(object->output, stringsSize);
+	fseek(object->output, 0, SEEK_END);
+}
@@ -0,0 +1,68 @@
+#ifndef BINOBJECT_H
+#define BINOBJECT_H
+
+#include <stdio.h>
+
+#include "symboltable.h"
+
+/**
+ * An header file for the binary object translation unit.
+ */
+
+#define BINARY_MAGIC "BOBJ" /* The first four bytes of a binary object file. */
+#define BINARY_VERSION 1 /* The version of the binary object layout. */
+#define BINARY_HEADER_SIZE 32 /* The size of the header of a binary object file (in bytes). */
+#define BINARY_RECORD_SIZE 8 /* The size of every entry and extern record (in bytes). */
+
+/**
+ * Defining the binary object data structure.
+ * Writes the assembled program into a binary object file that a loader
+ * can map into memory and use without parsing. Every number in the file
+ * is a 32 bit little endian word, in this order:
+ * A header of the magic, the version, the start address, the size of
+ * the code segment, the size of the data segment, the number of entry
+ * records, the number of extern records and the size of the string
+ * table. Then the code segment and the data segment, padded with zeros
+ * to a multiple of 4 bytes. Then the entry records sorted by address and
+ * the extern records in the order of use, both made of an address and
+ * the offset of the symbol in the string table. Then the string table,
+ * every symbol once and terminated by a null character, which starts
+ * with an empty string.
+ */
+typedef struct binobject BinaryObject;
+
+/**
+ * Creates a new binary object that writes into the given stream, which
+ * should not have been written yet, a program with the given size of
+ * the code segment and the given size of the data segment.
+ * Returns a pointer to the new binary object or a null pointer if the
+ * memory allocation had failed.
+ */
+BinaryObject *createBinaryObject(FILE *output, unsigned long int ic, unsigned long int dc);
+
+/**
+ * Writes the given bit field as the next word of the code segment.
+ */
+void writeBinaryCode(BinaryObject *object, unsigned long int data);
+
+/**
+ * Adds an extern record for the given external label, used by the code
+ * word at the given address.
+ */
+void addBinaryExtern(BinaryObject *object, Label label, unsigned long int address);
+
+/**
+ * Writes the given data segment, the entry labels of the given symbol
+ * table and the extern records after the code segment and completes the
+ * header. Should be called once, after the whole code segment was
+ * written.
+ */
+void writeBinaryTables(BinaryObject *object, SymbolTable *symbolTable, const char *dataSegment);
+
+/**
+ * Frees all the memory used by the given binary object, the stream is
+ * not closed.
+ */
+void freeBinaryObject(BinaryObject *object);
+
+#endif
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <pthread.h>
 
 #include "converter.h"
 #include "utils.h"
@@ -8,6 +10,16 @@
 #include "asmutils.h"
 #include "keywords.h"
 #include "errmsg.h"
+#include "options.h"
+#include "queue.h"
+#include "incremental.h"
+#include "parallel.h"
+#include "symbolmap.h"
+#include "exports.h"
+#include "hexwriter.h"
+#include "binobject.h"
+#include "elfobject.h"
+#include "segment.h"
 
 /**
  * The converter translation unit is responsible for managing the assembling
@@ -17,25 +29,248 @@
 #define OUTPUT_OB_EXTENTION ".ob" /* Output object file extension for assembled source files. */
 #define OUTPUT_ENT_EXTENTION ".ent" /* Output entries file extension for assembled source files. */
 #define OUTPUT_EXT_EXTENTION ".ext" /* Output externals file extension for assembled source files. */
+#define OUTPUT_MAP_EXTENTION ".map" /* Output symbol map file extension for assembled source files. */
+#define OUTPUT_MAP_INDEX_EXTENTION ".mapidx" /* Output binary symbol map file extension for assembled source files. */
+#define OUTPUT_BIN_EXTENTION ".obj" /* Output binary object file extension for assembled source files. */
+#define OUTPUT_ELF_EXTENTION ".o" /* Output ELF relocatable object file extension for assembled source files. */
+#define SPILL_EXTENTION ".segXXXXXX" /* The template of the file a spilled data segment is kept in, removed once it is mapped. */
+
+#define INITIAL_ACTIONS 64 /* The initial capacity of the deferred label actions array. */
+#define INITIAL_POOL 1024 /* The initial capacity of the deferred strings pool. */
+#define INITIAL_REFERENCES 64 /* The initial capacity of the kept label references array. */
+#define INITIAL_LOCAL_USES 64 /* The initial capacity of the local label uses array. */
+#define DECIMAL 10 /* Decimal base, used for conversion from text to integer. */
+#define PIPELINE_QUEUE_SIZE 1024 /* The number of items every queue between two pipeline stages holds. */
+#define PIPELINE_WRITE_BATCH 1024 /* The number of code lines the writing stage of the pipeline keeps before it writes them. */
 
-#define MAX_LABEL_SIZE 31 /* The maximum number of characters allowed in a symbol. */
-#define MEMORY_START_ADDRESS 100 /* The memory address from which the program should be loaded. */
+/**
+ * Label actions taken by the first pass.
+ * The first pass touches the symbol table only trough these actions,
+ * that way they can be applied on the spot or recorded and applied
+ * later in line order.
+ */
+typedef enum {
+	DefineAction, /* A label at the beginning of a line. */
+	CodeAction, /* The label of the line is a code label. */
+	DataAction, /* The label of the line is a data label. */
+	UseAction, /* A label operand. */
+	EntryAction, /* An entry instruction. */
+	ExternAction, /* An extern instruction. */
+	LocalAction, /* A numeric local label at the beginning of a code line. */
+	LocalUseAction, /* A numeric local label operand. */
+	LineEndAction /* The end of a line that recorded actions, only recorded while deferring. */
+} LabelAction;
+
+/**
+ * Defining the deferred label action data structure.
+ * Stores a label action along with everything needed to apply it
+ * later, the strings are stored as offsets into the strings pool of
+ * the first pass state that recorded it.
+ */
+struct action {
+	LabelAction action; /* The action to apply. */
+	unsigned long int line; /* The line number of the action. */
+	unsigned long int value; /* The address or line number the action uses, counters are relative to the state. */
+	long int offset; /* The size of the messages stream when the action was recorded. */
+	unsigned long int symbol; /* The offset of the symbol in the strings pool. */
+	unsigned long int sourceLine; /* The offset of the source line in the strings pool. */
+};
+
+/**
+ * Defining the local label use data structure.
+ * A numeric local label operand, kept until the whole file was mapped
+ * so forward references can be checked as well.
+ */
+struct localuse {
+	unsigned long int address; /* The address of the code line. */
+	unsigned long int line; /* The line number, for error messaging purposes. */
+	unsigned long int reference; /* The offset of the reference in the strings pool. */
+};
+
+/**
+ * Defining the first pass state data structure.
+ * This structure holds everything the first pass tracks between the
+ * lines of a source file. A deferring state does not own a symbol table,
+ * it records the label actions of its lines instead so they can be
+ * replayed into another state later.
+ */
+struct mapstate {
+	const char *fileName; /* The name of the source file, for messages. */
+	SymbolTable *symbolTable; /* The symbol table, null while deferring. */
+	Label edit; /* The label at the beginning of the current line. */
+	unsigned long int ic; /* Operator line counter (instruction counter). */
+	unsigned long int dc; /* Data instruction counter (data counter). */
+	Code code; /* To track if output file should be created. */
+	char *word; /* A variable to store the labels\Instructors\Operators returned from getWord. */
+	char *symbol; /* A variable to store the label operand of I\J operators. */
+	char *str; /* A variable to store the string returned from "getAscizParam" function from asmutils. */
+	long int *args; /* To use the "getDataParam" function from asmutils. */
+	FILE *messages; /* The stream messages are printed into while deferring, null otherwise. */
+	struct action *actions; /* The deferred label actions. */
+	unsigned long int actionCount; /* The number of deferred label actions. */
+	unsigned long int actionCapacity; /* The capacity of the deferred label actions array. */
+	char *pool; /* The strings used by the deferred label actions. */
+	unsigned long int poolSize; /* The used part of the strings pool. */
+	unsigned long int poolCapacity; /* The capacity of the strings pool. */
+	unsigned long int pooledLine; /* The line number of the last source line in the pool. */
+	unsigned long int pooledLineOffset; /* The offset of that source line in the pool. */
+	struct localuse *localUses; /* The numeric local label operands. */
+	unsigned long int localUseCount; /* The number of local label operands. */
+	unsigned long int localUseCapacity; /* The capacity of the local label uses array. */
+	unsigned long int errors; /* The number of lines with errors. */
+	unsigned long int maxErrors; /* The number of errors after which mapping stops, zero for no limit. */
+	unsigned long int lastLine; /* The line number of the last mapped line. */
+	unsigned long int skipped; /* The number of lines that were not mapped because of the error limit. */
+};
+
+/**
+ * Defining the source line data structure.
+ * A single source line as it was read by the reading stage of the
+ * pipeline, along with the results of the extractSourceLine function.
+ */
+struct sourceline {
+	char text[SOURCE_LINE_LENGTH + 1]; /* The source line. */
+	int length; /* The length of the line if it was too long, -1 otherwise. */
+	Flag status; /* EndFileFlag for the last line of the file. */
+};
+
+/**
+ * Defining the parsed code line data structure.
+ * The operator and operands of a code line, everything that is needed to
+ * encode it without looking at the source line again.
+ */
+struct instruction {
+	unsigned long int address; /* The address of the code line. */
+	const Operator *operator; /* The operator of the line. */
+	char rs, rt, rd; /* The registers of R and I operators. */
+	char isRegister; /* The register flag of J operators. */
+	short immed; /* The immediate value of I operators. */
+	unsigned long int addressValue; /* The address (or register) of J operators. */
+	Label operand; /* The label operand of the line, NO_LABEL if there is none. */
+	Label label; /* An external label the line references, NO_LABEL otherwise. */
+	char isLast; /* Marks the end of the pipeline, every other field is meaningless. */
+};
+
+/**
+ * Defining the encoded code line data structure.
+ * A code line as it comes out of the encoding stage of the pipeline,
+ * ready to be written.
+ */
+struct encoded {
+	unsigned long int address; /* The address of the code line. */
+	Word data; /* The bit field of the code line. */
+	Label label; /* An external label the line references, NO_LABEL otherwise. */
+	char isLast; /* Marks the end of the pipeline, every other field is meaningless. */
+};
+
+/**
+ * Defining the pipeline data structure.
+ * Everything the stages of the pipeline share. Every queue is written by
+ * a single stage and read by the single stage that comes after it.
+ */
+struct pipeline {
+	FILE *file; /* The source file, read by the reading stage only. */
+	ConvertState *state; /* The state of the parsing stage. */
+	Queue *lines; /* From the reading stage to the parsing (or mapping) stage. */
+	Queue *instructions; /* From the parsing stage to the encoding stage. */
+	Queue *words; /* From the encoding stage to the writing stage. */
+};
+
+/**
+ * Defining the label reference data structure.
+ * A code line that references an external label, kept until it can be
+ * written into the externals file.
+ */
+struct reference {
+	Label label; /* The referenced label. */
+	unsigned long int address; /* The address of the code line. */
+};
+
+/**
+ * Defining the entry data structure.
+ * An entry label with its address, for sorting the entries file.
+ */
+struct entry {
+	unsigned long int address; /* The address of the label. */
+	Label label; /* The label. */
+};
+
+/**
+ * Defining the second pass state data structure.
+ * This structure holds everything the second pass tracks between the
+ * lines of a source file. The encoded code lines and the label
+ * references are kept in the state, a state with output files writes
+ * them once the whole code segment was encoded, or a batch at a time
+ * as they are encoded by the pipeline.
+ */
+struct convertstate {
+	SymbolTable *symbolTable; /* The symbol table made by the first pass. */
+	unsigned long int address; /* To track the memory address of the assembled operators. */
+	char *dataSegment; /* Points to the array that stores all the assembled data instructors parameters. */
+	unsigned long int dataSegmentIndex; /* Index variable for the data segment array. */
+	char *word; /* A variable to store the labels\Instructors\Operators returned from getWord. */
+	char *symbol; /* A variable to store the label operand of I\J operators. */
+	char *str; /* A variable to store and access asciz strings. */
+	long int *args; /* To store and access db\dh\dw arguments. */
+	FILE *outputObj; /* The main output file, null if the state has no output files. */
+	HexWriter *obWriter; /* Formats the lines of the main output file, null if it is filled in place. */
+	int inPlaceJobs; /* The number of threads that fill the main output file in place, zero if it is written trough the hex writer. */
+	FILE *outputBin; /* The binary object output file, null if it should not be written. */
+	BinaryObject *binObject; /* Lays out the binary object output file. */
+	FILE *outputElf; /* The ELF object output file, null if it should not be written. */
+	ElfObject *elfObject; /* Lays out the ELF object output file. */
+	FILE *outputExt; /* The externals output file, created on the first reference. */
+	char *entFileName, *extFileName; /* The names of the entries and externals output files. */
+	char *mapFileName, *mapIndexFileName; /* The names of the map files, null if they should not be written. */
+	char isGroupedExt; /* To write the external label references grouped by label. */
+	Word *codeSegment; /* The kept code lines, the code segment of a state with output files. */
+	unsigned long int codeCount; /* The number of kept code lines. */
+	unsigned long int codeWritten; /* The number of kept code lines that were written into the output files. */
+	struct reference *references; /* The kept external label references. */
+	unsigned long int referenceCount; /* The number of kept label references. */
+	unsigned long int referencesWritten; /* The number of kept label references that were written into the output files. */
+	unsigned long int referenceCapacity; /* The capacity of the kept label references array. */
+};
 
 /**
  * The following functions should not be used outside this translation unit.
  */
 Code checkSymbolTabel(const char *fileName, SymbolTable *symbolTable, Code code);
-Code map(FILE *file, const char *fileName, SymbolTable **symboltable, char *sourceLine, unsigned long int *ic, unsigned long int *dc);
+Code checkLocalLabels(MapState *state, Code code);
+void addLocalUse(MapState *state, const char *reference, unsigned long int address, unsigned long int lineNum);
+void mapSourceLine(MapState *state, char *sourceLine, unsigned long int lineNum, int length, Flag status);
+Code labelAction(MapState *state, LabelAction action, const char *symbol, unsigned long int value, const char *sourceLine, unsigned long int lineNum);
+Code executeLabelAction(MapState *state, LabelAction action, const char *symbol, unsigned long int value, const char *sourceLine, unsigned long int lineNum);
+void recordLabelAction(MapState *state, LabelAction action, const char *symbol, unsigned long int value, const char *sourceLine, unsigned long int lineNum);
+unsigned long int poolString(MapState *state, const char *str);
 void increaseDataCounterByData(unsigned long int *dc, const int count, Expectation sizeExpectation);
-void convert(FILE *file, const char *fileName, SymbolTable *symboltable, char *sourceLine, const unsigned long int ic, const unsigned long int dc);
-void extractOutputFileNames(const char *sourceFileName, char *obFileName, char *entFileName, char *extFileName);
-void assembleR(FILE *output, unsigned long int address, Operator *op, char rs, char rt, char rd);
-void assembleI(FILE *output, unsigned long int address, Operator *op, char rs, char rt, short immed);
-void assembleJ(FILE *output, unsigned long int address, Operator *op, char isRegister, unsigned long int addressValue);
+void mapPipelined(MapState *state, FILE *file);
+void convert(FILE *file, const char *fileName, SymbolTable *symboltable, char *sourceLine, const unsigned long int ic, const unsigned long int dc, Chunks *chunks, Options *options);
+ConvertState *openOutputs(const char *fileName, SymbolTable *symboltable, char *dataSegment, const unsigned long int ic, const unsigned long int dc, Options *options);
+void closeOutputs(ConvertState *state, const unsigned long int dc);
+void convertLine(ConvertState *state, char *sourceLine);
+void convertPipelined(ConvertState *state, FILE *file);
+Flag parseLine(ConvertState *state, char *sourceLine, struct instruction *instruction);
+Word encodeInstruction(struct instruction *instruction);
+void startStage(pthread_t *thread, void *(*stage)(void *), struct pipeline *pipeline);
+void *readStage(void *pipeline);
+void *parseStage(void *pipeline);
+void *encodeStage(void *pipeline);
+void emitCode(ConvertState *state, Word data);
+void emitReference(ConvertState *state, Label label);
+void writeEntries(ConvertState *state);
+void writeGroupedExterns(ConvertState *state);
+void writeCodeSegment(ConvertState *state);
+void fillObject(ConvertState *state, const unsigned long int dc);
+int compareReferences(const void *first, const void *second);
+int compareEntries(const void *first, const void *second);
+char *outputFileName(const char *sourceFileName, const char *extension);
+Word encodeR(const Operator *op, char rs, char rt, char rd);
+Word encodeI(const Operator *op, char rs, char rt, short immed);
+Word encodeJ(const Operator *op, char isRegister, unsigned long int addressValue);
 void assembleAsciz(char *dataSegment, char *str, unsigned long int *startIndex);
 void assembleData(char *dataSegment, unsigned long int *startIndex, const Expectation expecting, const int count, long int *args);
 void writePlain(FILE *output, char *symbol, unsigned long int address);
-void writeDataSegment(FILE *output ,const unsigned long int dc, char *dataSegment, unsigned long int address);
 
 /**
  * Takes in an assembly source file as a stream and assembles
@@ -45,38 +280,92 @@ void writeDataSegment(FILE *output ,const unsigned long int dc, char *dataSegmen
  * assembled and error messages would be printed for the user
  * to see. The error messages can tell the user what are the
  * issues with his code.
+ * Large source files are mapped in chunks on multiple threads
+ * if the given options allow it, otherwise the options may
+ * run the stages of the assembler on separate threads.
+ * In incremental mode only the lines that were changed since
+ * the last successful run are assembled, if that is possible.
+ * In check mode the file is only checked for issues and no
+ * output files are created.
+ * If the exports parameter is not null the entry and external
+ * labels of the file are published into it.
+ * Returns SUCCESS if the file has no issues and ERROR otherwise.
  */
-void assemble(FILE *sourceFile, const char *fileName) {
-	unsigned long int ic = MEMORY_START_ADDRESS; /* Operator line counter (instruction counter). */
-	unsigned long int dc = 0; /* Data instruction counter (data counter). */
+Code assemble(FILE *sourceFile, const char *fileName, Options *options, Exports *exports) {
+	unsigned long int ic; /* Operator line counter (instruction counter). */
+	unsigned long int dc; /* Data instruction counter (data counter). */
 	Code code; /* To track if output file should be created. */
-	SymbolTable *symbolTable, *edit; /* Symbol table variables, the first is to point to the symbol table and the second is to point to a specific label. */
-	char *sourceLine = malloc(SOURCE_LINE_LENGTH + 1); /* A pointer to every source line, used for scanning the file line by line. */
+	SymbolTable *symbolTable; /* The symbol table made by the first pass. */
+	Label edit; /* To loop trough the labels. */
+	MapState *state; /* The state of the first pass. */
+	Chunks *chunks = NULL; /* The chunks of the source file, if it was split. */
+	FILE *messages = NULL, *output = NULL; /* In incremental mode the messages are kept, to know if there were any. */
+	char isCached = 0; /* Tells if the state of the file should be cached. */
+	char *sourceLine; /* A pointer to every source line, used for scanning the file line by line. */
+
+	if (isIncremental(options) == SUCCESS && isCheckOnly(options) == ERROR) {
+		if (assembleIncremental(sourceFile, fileName, options, exports) == SUCCESS)
+			return SUCCESS; /* Only the changed lines had to be assembled. */
+		if ((messages = tmpfile()) == NULL)
+			errFatal(); /* Cannot continue without the stream. */
+		output = getMessageStream();
+		setMessageStream(messages);
+	}
 
-	if (sourceLine == NULL)
+	if ((sourceLine = malloc(SOURCE_LINE_LENGTH + 1)) == NULL || (state = createMapState(fileName, NULL)) == NULL)
 		errFatal(); /* Cannot continue without memory for the line. */
+	state->maxErrors = getMaxErrors(options);
 
-	/* Mapping the source file for labels and errors. */
-	code = map(sourceFile, fileName, &symbolTable, sourceLine, &ic, &dc);
+	/* Mapping the source file for labels and errors, in parallel if it is worth it. Chunks are always mapped to their end, so not with an error limit. */
+	if (getJobs(options) > 1 && state->maxErrors == 0 && (chunks = splitSource(sourceFile, fileName, getJobs(options))) != NULL)
+		mapChunks(chunks, state);
+	else if (isPipelined(options) == SUCCESS)
+		mapPipelined(state, sourceFile);
+	else
+		mapLines(state, sourceFile, sourceLine, 1, 0);
+
+	code = state->code;
+	ic = state->ic;
+	dc = state->dc;
+	symbolTable = state->symbolTable;
+
+	edit = getFirst(symbolTable); /* Starting from the first label */
+	while (edit != NO_LABEL) { /* Looping through all of the labels in the symbol table. */
+		if (hasAttribute(symbolTable, edit, DataLabel) == SUCCESS)
+			setAddress(symbolTable, edit, getAddress(symbolTable, edit) + ic); /* All data labels should be positioned after the code segment. */
+		edit = getNext(symbolTable, edit); /* Getting the next label. */
+	}
 
-	edit = symbolTable; /* Starting from the first label */
-	while (edit != NULL) { /* Looping through all of the labels in the symbol table. */
-		if (hasAttribute(edit, DataLabel) == SUCCESS)
-			setAddress(edit, getAddress(edit) + ic); /* All data labels should be positioned after the code segment. */
-		edit = getNext(edit); /* Getting the next label. */
+	if (isErrorLimitReached(state) == SUCCESS) /* The rest of the file was not mapped, so the symbol table is not complete. */
+		errTooManyErrors(fileName, state->lastLine, state->errors, state->skipped);
+	else { /* Looking for undeclared labels. */
+		code = checkSymbolTabel(fileName, symbolTable, code);
+		code = checkLocalLabels(state, code);
+		if (exports != NULL)
+			publishSymbols(exports, symbolTable, fileName); /* For the check at the end of the batch. */
 	}
 
-	/* Looking for undeclared labels. */
-	code = checkSymbolTabel(fileName, getNext(symbolTable), code); /* Ignoring the first impossible initializing label. */
+	if (messages != NULL) { /* Printing the kept messages. */
+		setMessageStream(output);
+		rewind(messages);
+		isCached = copyStream(output, messages, -1) == 0; /* The messages of a cached file would not be printed again. */
+		fclose(messages);
+	}
 
-	if (code == SUCCESS) { /* If the source file had no issues it can be assembled. */
+	if (code == SUCCESS && isCheckOnly(options) == ERROR) { /* If the source file had no issues it can be assembled. */
 		rewind(sourceFile); /* Preparing to re-scan the file from the beginning. */
-		convert(sourceFile, fileName, symbolTable, sourceLine, ic - MEMORY_START_ADDRESS, dc); /* Creating the output files. */
+		convert(sourceFile, fileName, symbolTable, sourceLine, ic - MEMORY_START_ADDRESS, dc, chunks, options); /* Creating the output files. */
+		if (isCached)
+			saveIncremental(sourceFile, fileName, symbolTable, ic - MEMORY_START_ADDRESS, dc); /* For the next incremental run. */
 	}
 
 	/* Freeing the memory. */
 	free(sourceLine);
-	freeSymbolTable(symbolTable);
+	if (chunks != NULL)
+		freeChunks(chunks);
+	freeMapState(state); /* The symbol table is freed with it. */
+
+	return code;
 }
 
 /**
@@ -87,288 +376,567 @@ void assemble(FILE *sourceFile, const char *fileName) {
  * a success code would be returned instead.
  */
 Code checkSymbolTabel(const char *fileName, SymbolTable *symbolTable, Code code) {
-	while (symbolTable != NULL) {
-		if (isDeclared(symbolTable) == ERROR && hasAttribute(symbolTable, ExternLabel) == ERROR) { /* Checking the label. */
-			errUndeclaredLabel(fileName, symbolTable); /* Printing an error message, the label is not fine. */
+	Label label = getFirst(symbolTable); /* Starting from the first label. */
+
+	while (label != NO_LABEL) {
+		if (isDeclared(symbolTable, label) == ERROR && hasAttribute(symbolTable, label, ExternLabel) == ERROR) { /* Checking the label. */
+			errUndeclaredLabel(fileName, symbolTable, label); /* Printing an error message, the label is not fine. */
+			code = ERROR; /* Setting the return value to error. */
+		}
+		label = getNext(symbolTable, label); /* Checking the next label. */
+	}
+	return code;
+}
+
+/**
+ * Checks that every numeric local label operand that was mapped into the
+ * given first pass state has a definition in its direction. If one does
+ * not an error message would be printed for it and an error code would
+ * be returned, otherwise the given code is returned.
+ */
+Code checkLocalLabels(MapState *state, Code code) {
+	struct localuse *use; /* Every local label operand. */
+	unsigned long int address; /* Not needed, the definition only has to exist. */
+
+	for (use = state->localUses; use < state->localUses + state->localUseCount; use++) {
+		if (searchLocalLabel(getLocalLabels(state->symbolTable), state->pool + use->reference, use->address, &address) == ERROR) {
+			errUndefinedLocalLabel(state->fileName, state->pool + use->reference, use->line);
 			code = ERROR; /* Setting the return value to error. */
 		}
-		symbolTable = getNext(symbolTable); /* Checking the next label. */
 	}
 	return code;
 }
 
 /**
- * Maps the given source file for labels and errors.
- * This function initializes the given symbol table
- * and assigns to it all the labels found in the
- * given source files. In addition this function
- * check that the given source file is valid
- * meaning, it has no syntax errors or other similar
- * issues and it can be assembled.
+ * Keeps the given numeric local label operand of the code line at the
+ * given address in the given first pass state, to be checked once the
+ * whole file was mapped.
+ */
+void addLocalUse(MapState *state, const char *reference, unsigned long int address, unsigned long int lineNum) {
+	struct localuse *use; /* The new use. */
+
+	if (state->localUseCount == state->localUseCapacity) { /* Making room for the use. */
+		state->localUseCapacity = state->localUseCapacity ? state->localUseCapacity * 2 : INITIAL_LOCAL_USES;
+		if ((use = realloc(state->localUses, state->localUseCapacity * sizeof(struct localuse))) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		state->localUses = use;
+	}
+
+	use = state->localUses + state->localUseCount++;
+	use->address = address;
+	use->line = lineNum;
+	use->reference = poolString(state, reference);
+}
+
+/**
+ * Creates a new first pass state for the given source file.
+ * If the second parameter is null the state owns an empty symbol table
+ * and its instruction counter starts at the memory start address.
+ * Otherwise the state defers its label actions, its counters start at
+ * zero and every message printed while mapping into it is expected to
+ * be written into the given stream.
+ * Returns a pointer to the new state or a null pointer if the memory
+ * allocation had failed.
+ */
+MapState *createMapState(const char *fileName, FILE *deferredMessages) {
+	MapState *state = calloc(1, sizeof(MapState)); /* Every field starts empty. */
+
+	if (state == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	state->fileName = fileName;
+	state->code = SUCCESS; /* No issues were found yet. */
+	state->messages = deferredMessages;
+
+	if ((state->word = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
+		(state->symbol = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
+		(state->str = malloc(SOURCE_LINE_LENGTH)) == NULL || /* An asciz string cannot be longer than that. */
+		(state->args = calloc(sizeof(long int) ,(SOURCE_LINE_LENGTH / 2) + 1)) == NULL) { /* A line of db or dh or dw will never have more arguments than that. */
+		freeMapState(state);
+		return NULL; /* Memory allocation failed. */
+	}
+
+	if (deferredMessages == NULL) {
+		state->ic = MEMORY_START_ADDRESS; /* The code segment starts at the memory start address. */
+		if ((state->symbolTable = createSymbolTable()) == NULL) {
+			freeMapState(state);
+			return NULL; /* Memory allocation failed. */
+		}
+	}
+
+	return state;
+}
+
+/**
+ * Maps the source lines of the given stream, starting from its current
+ * position, into the given first pass state. The first line is given
+ * the line number on the fourth parameter. If the last parameter is
+ * zero the stream is mapped until its end, otherwise only that number
+ * of lines are mapped.
+ * Expects the third parameter to be a buffer SOURCE_LINE_LENGTH + 1 long.
+ */
+void mapLines(MapState *state, FILE *file, char *sourceLine, unsigned long int firstLine, unsigned long int lineCount) {
+	unsigned long int lineNum = firstLine; /* To track the line number. */
+	int length; /* Used as length check for extractSourceLine. */
+	Flag status; /* To catch the end of the file. */
+
+	do {
+		length = -1; /* The length is set only for lines that are too long. */
+		status = extractSourceLine(file, sourceLine, &length);
+		mapLine(state, sourceLine, lineNum, length, status);
+		lineNum++; /* The next line. */
+	} while (status != EndFileFlag && (lineCount == 0 || lineNum - firstLine < lineCount) && isErrorLimitReached(state) == ERROR);
+
+	if (status != EndFileFlag && isErrorLimitReached(state) == SUCCESS)
+		state->skipped = countLines(file); /* Only counting the rest of the lines. */
+}
+
+/**
+ * Maps a single source line into the given first pass state, using the
+ * results of the extractSourceLine function on the last two parameters.
+ * While deferring, the end of a line that recorded label actions is
+ * recorded as well so that a failed action can skip the rest of its
+ * line when replayed.
+ */
+void mapLine(MapState *state, char *sourceLine, unsigned long int lineNum, int length, Flag status) {
+	const Code code = state->code; /* To count the lines with errors. */
+
+	state->code = SUCCESS;
+	mapSourceLine(state, sourceLine, lineNum, length, status);
+	if (state->code == ERROR)
+		state->errors++; /* This line has an error. */
+	else
+		state->code = code;
+	state->lastLine = lineNum;
+
+	if (state->messages != NULL && state->pooledLine == lineNum)
+		recordLabelAction(state, LineEndAction, NULL, 0, sourceLine, lineNum); /* This line recorded label actions. */
+}
+
+/**
+ * Maps the given source line for labels and errors.
+ * This function assigns to the symbol table of the
+ * given state all the labels found in the line, trough
+ * label actions. In addition this function checks that
+ * the line is valid meaning, it has no syntax errors or
+ * other similar issues and it can be assembled.
  * Also this function counts the size of the code
- * segment and data segment via the last two
- * parameters and prints out a message for the user
- * for every error found in the source file.
- * Returns an error code that indicates if the
- * given file should be assembled (meaning it has no
- * issues). If an assembled output file(s) should be
- * created this function would return SUCCESS and
- * if no assembled output files should be created
- * ERROR would be returned instead.
- * Note: the given symbol table is initialized to an
- * impossible label that should be ignored.
- */
-Code map(FILE *file, const char *fileName, SymbolTable **symbolTable, char *sourceLine, unsigned long int *ic, unsigned long int *dc) {
+ * segment and data segment via the counters of the
+ * given state and prints out a message for the user
+ * for every error found in the line.
+ * If an assembled output file(s) should not be created
+ * the code of the given state would be set to ERROR.
+ */
+void mapSourceLine(MapState *state, char *sourceLine, unsigned long int lineNum, int length, Flag status) {
 	const char codeLineSize = 4; /* The size of an assembled code line, used for address tracking. */
 	const char *stopOperator = "stop"; /* Special case keyword, no operands. */
 	const char *jmpOperator = "jmp"; /* Special case keyword, the only J operator that can receive a register as operand. */
 	const char beginLabelArgSetI = 15; /* The opcode of the I operator from which a label operand is required. */
 	const char endLabelArgSetI = 18; /* The opcode of the I operator until which a label operand is required. */
 	const char nullTermination = '\0', space = ' ', tab = '\t'; /* Syntax characters. */
-	Code code = SUCCESS; /* Error code to track issues. */
-	char shouldStop = 0; /* To track when the loop should stop meaning, the source file has ended */
-	char isLabelLine; /* To track if there was a label at the beginning of the line. */
+	const char *fileName = state->fileName; /* For messages. */
+	char isLabelLine = 0; /* To track if there was a label at the beginning of the line. */
+	char isLocalLine = 0; /* To track if that label is a numeric local label. */
 	int index; /* An index to track the position on the line. */
-	unsigned long int lineNum = 0; /* To track the line number. */
-	char *word; /* A variable to store the labels\Instructors\Operators returned from getWord. */
-	char *symbol; /* A variable to store the label operand of I\J operators. */
-	char *str; /* A variable to store the string returned from "getAscizParam" function from asmutils. */
-	long int *args; /* To use the "getDataParam" function from asmutils. */
-	char rs, rt, rd; /* Variables to use some of the "get" functions from asmutils. */
+	char *word = state->word; /* A variable to store the labels\Instructors\Operators returned from getWord. */
+	char *symbol = state->symbol; /* A variable to store the label operand of I\J operators. */
+	char *str = state->str; /* A variable to store the string returned from "getAscizParam" function from asmutils. */
+	long int *args = state->args; /* To use the "getDataParam" function from asmutils. */
+	char rs = 0, rt = 0, rd = 0; /* Variables to use some of the "get" functions from asmutils. */
 	short immed = 0; /* A variable to use the "getIParam" function from asmutils. */
 	int count; /* Used for counting arguments for db and dh and dw data instructors. */
 	char isLabeledArgSet = 0; /* To track I\J operators required argument sets. */
-	Operator *operator; /* To hold operators. */
-	Instructor *instructor; /* To hold instructors. */
-	SymbolTable *front; /* The symbol table. */
-	SymbolTable *edit; /* Used for editing the symbol table. */
+	const Operator *operator; /* To hold operators. */
+	const Instructor *instructor; /* To hold instructors. */
 	Expectation expecting; /* To differentiate different situations and catch issues. */
 	Expectation dataExpectation; /* Used for holding the expectation of a data instructor. */
-	Flag status; /* To differentiate different situations and catch issues. */
-
-	if ((edit = front = addSymbol(NULL, "!", 0)) == NULL) /* Initializing the symbol table with an impossible label. */
-		errFatal(); /* Memory allocation failed, cannot continue the program. */
-
-	if ((word = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
-		(symbol = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
-		(str = malloc(SOURCE_LINE_LENGTH)) == NULL || /* An asciz string cannot be longer than that. */
-		(args = calloc(sizeof(long int) ,(SOURCE_LINE_LENGTH / 2) + 1)) == NULL) /* A line of db or dh or dw will never have more arguments than that. */
-	errFatal(); /* Cannot continue without memory. */
-
-	while (!shouldStop) {
-		isLabelLine = 0; /* The line is not labeled. */
-		index = -1; /* Using this variable as length check for extractSourceLine. */
-		rs = rt = rd = 0; /* Avoiding potential issues on "if" statement. */
-		lineNum++; /* This is a new line. */
-
-		if ((status = extractSourceLine(file, sourceLine, &index)) == EndFileFlag)
-			shouldStop = 1; /* This is the last line in the source file. */
-		if (errCheckLine(fileName, sourceLine, lineNum, index, status) == EEvent) { /* Checking and handling source file issues. */
-			code = ERROR; /* No output should be created for this source file. */
-			continue; /* The line is corrupted. */
-		}
-		index = 0; /* Setting the index to the beginning of the line. */
 
-		if ((status = getWord(sourceLine, &expecting, &index, word)) == LabelFlag) { /* If the returned flag is LabelFlag then there are no errors to check for. */
-			if (errCheckSymbol(front, fileName, sourceLine, word, lineNum) == EEvent) { /* Checking the symbol. */
-				code = ERROR; /* No output should be created for this source file. */
-				continue; /* The line is corrupted. */
-			}
-			if ((edit = searchLabel(front, word)) == NULL)
-				if ((edit = addSymbol(front, word, 0)) == NULL) /* Creating the next label if it is not in the symbol table. */
-					errFatal(); /* Memory allocation for this label had failed, cannot continue the program. */
-			isLabelLine = 1; /* The line is labeled. */
-
-			status = getWord(sourceLine, &expecting, &index, word); /* Extracting the next part of the source line. */
-		} else if (status == CommentLineFlag)
-			continue; /* Skipping a comment line. */
-		if (status == OperatorFlag && expecting == ExpectWord) { /* This combination indicates that the line is empty. */
-			if (isLabelLine) {
-				errLonelyLabel(fileName, sourceLine, lineNum); /* A label cannot be alone in a line. */
-				code = ERROR; /* No output should be created for this source file. */
-			}
-			continue; /* The line is corrupted or empty. */
-		}
-		if (errCheckWord(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
-			code = ERROR; /* No output should be created for this source file. */
-			continue; /* The line is corrupted. */
+	if (errCheckLine(fileName, sourceLine, lineNum, length, status) == EEvent) { /* Checking and handling source file issues. */
+		state->code = ERROR; /* No output should be created for this source file. */
+		return; /* The line is corrupted. */
+	}
+	index = 0; /* Setting the index to the beginning of the line. */
+
+	if ((status = getWord(sourceLine, &expecting, &index, word)) == LabelFlag) { /* If the returned flag is LabelFlag then there are no errors to check for. */
+		if (isdigit(word[0])) { /* A numeric local label, it is defined once the line is known to be a code line. */
+			strcpy(symbol, word); /* The next word would overwrite it. */
+			isLocalLine = 1;
+		} else if (labelAction(state, DefineAction, word, 0, sourceLine, lineNum) == ERROR) /* Checking the symbol and adding it if it is not in the symbol table. */
+			return; /* The line is corrupted. */
+		isLabelLine = 1; /* The line is labeled. */
+
+		status = getWord(sourceLine, &expecting, &index, word); /* Extracting the next part of the source line. */
+	} else if (status == CommentLineFlag)
+		return; /* Skipping a comment line. */
+	if (status == OperatorFlag && expecting == ExpectWord) { /* This combination indicates that the line is empty. */
+		if (isLabelLine) {
+			errLonelyLabel(fileName, sourceLine, lineNum); /* A label cannot be alone in a line. */
+			state->code = ERROR; /* No output should be created for this source file. */
 		}
+		return; /* The line is corrupted or empty. */
+	}
+	if (errCheckWord(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
+		state->code = ERROR; /* No output should be created for this source file. */
+		return; /* The line is corrupted. */
+	}
 
-		/* Beginning arguments scanning. */
-		if (status == OperatorFlag) { /* The word is an operator. */
-			if (isLabelLine) {
-				addAttribute(edit, CodeLabel); /* Previous checks prevent this from failing. */
-				setAddress(edit, *ic); /* Stetting the address of this label. */
+	/* Beginning arguments scanning. */
+	if (status == OperatorFlag) { /* The word is an operator. */
+		if (isLocalLine)
+			labelAction(state, LocalAction, symbol, state->ic, sourceLine, lineNum); /* Defining the local label at this address. */
+		else if (isLabelLine)
+			labelAction(state, CodeAction, NULL, state->ic, sourceLine, lineNum); /* Stetting the address of this label, previous checks prevent this from failing. */
+		operator = searchOperatorByString(word); /* Getting the operator. */
+		if (operator == NULL) {
+			errInvalidKeyword(fileName, sourceLine, word, lineNum); /* The operator is invalid. */
+			state->code = ERROR; /* No output should be created for this source file. */
+			return; /* The line is corrupted. */
+		}
+		state->ic += codeLineSize;
+		if (getType(operator) == R) { /* Handling R type operators. */
+			if (getOpcode(operator))
+				/* Extracting 2 operands. */
+				status = getRParam(sourceLine, &expecting, R2, &index, &rs, &rt, &rd);
+			else
+				/* Extracting 3 operands. */
+				status = getRParam(sourceLine, &expecting, R3, &index, &rs, &rt, &rd);
+			if (errCheckR(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
+				state->code = ERROR; /* No output should be created for this source file. */
+				return; /* The line is corrupted. */
 			}
-			operator = searchOperatorByString(word); /* Getting the operator. */
-			if (operator == NULL) {
-				errInvalidKeyword(fileName, sourceLine, word, lineNum); /* The operator is invalid. */
-				code = ERROR; /* No output should be created for this source file. */
-				continue; /* The line is corrupted. */
+		} else if (getType(operator) == I) { /* Handling I type operators. */
+			/* Extracting the data from the line as operand set for I operators. */
+			status = getIParam(sourceLine, &expecting, &index, &rs, &rt, &immed, &isLabeledArgSet, symbol);
+			if (errCheckI(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
+				state->code = ERROR;
+				return;
 			}
-			(*ic) += codeLineSize;
-			if (getType(operator) == R) { /* Handling R type operators. */
-				if (getOpcode(operator))
-					/* Extracting 2 operands. */
-					status = getRParam(sourceLine, &expecting, R2, &index, &rs, &rt, &rd);
-				else
-					/* Extracting 3 operands. */
-					status = getRParam(sourceLine, &expecting, R3, &index, &rs, &rt, &rd);
-				if (errCheckR(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-			} else if (getType(operator) == I) { /* Handling I type operators. */
-				/* Extracting the data from the line as operand set for I operators. */
-				status = getIParam(sourceLine, &expecting, &index, &rs, &rt, &immed, &isLabeledArgSet, symbol);
-				if (errCheckI(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
-					code = ERROR;
-					continue;
-				}
-				if (isLabeledArgSet) { /* One of the operands is a label. */
-					if (getOpcode(operator) < beginLabelArgSetI || getOpcode(operator) > endLabelArgSetI) { /* Checking if this is a valid argument set. */
-						errInvalidArgumentSet(fileName, sourceLine, lineNum, I, 0); /* The argument set is invalid. */
-						code = ERROR; /* No output should be created for this source file. */
-						continue; /* The line is corrupted. */
-					}
-					if (errCheckSymbol(NULL, fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking if the symbol is a reserved keyword. */
-						code = ERROR; /* No output should be created for this source file. */
-						continue; /* The line is corrupted. */
-					}
-					if (searchLabel(front, symbol) == NULL) /* Extracting the label. */
-						if (addSymbol(front, symbol, lineNum) == NULL) /* Line number as address for error messaging purposes. */
-							errFatal(); /* Memory allocation for this label had failed, cannot continue the program. */
-				} else { /* There is no label, the middle operand is an immediate value. */
-					if (getOpcode(operator) >= beginLabelArgSetI && getOpcode(operator) <= endLabelArgSetI) { /* Checking if this is a valid argument set. */
-						errInvalidArgumentSet(fileName, sourceLine, lineNum, I, 1); /* The argument set is invalid. */
-						code = ERROR; /* No output should be created for this source file. */
-						continue; /* The line is corrupted. */
-					}
+			if (isLabeledArgSet) { /* One of the operands is a label. */
+				if (getOpcode(operator) < beginLabelArgSetI || getOpcode(operator) > endLabelArgSetI) { /* Checking if this is a valid argument set. */
+					errInvalidArgumentSet(fileName, sourceLine, lineNum, I, 0); /* The argument set is invalid. */
+					state->code = ERROR; /* No output should be created for this source file. */
+					return; /* The line is corrupted. */
 				}
-			} else if (strcmp(getOperatorKeyword(operator), stopOperator) != 0) { /* The remaining operators must be of type J. */
-				/* Extracting the data from the line. */
-				status = getJParam(sourceLine, &expecting, &index, &rs, &isLabeledArgSet, symbol);
-				if (errCheckJ(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-				if (isLabeledArgSet) { /* The operand is a label. */
-					if (errCheckSymbol(NULL, fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking if the symbol is a reserved keyword. */
-						code = ERROR; /* No output should be created for this source file. */
-						continue; /* The line is corrupted. */
-					}
-					if (searchLabel(front, symbol) == NULL) /* Extracting the label. */
-						if (addSymbol(front, symbol, lineNum) == NULL) /* Line number as address for error messaging purposes. */
-							errFatal(); /* Memory allocation for this label had failed, cannot continue the program. */
-				} else { /* The operand is a register */
-					if (strcmp(getOperatorKeyword(operator), jmpOperator) != 0) { /* the "jmp" operator is the only one that can take a register as operand. */
-						errInvalidArgumentSet(fileName, sourceLine, lineNum, J, 0);
-						code = ERROR; /* No output should be created for this source file. */
-						continue; /* The line is corrupted. */
-					}
+				if (isLocalReference(symbol) == SUCCESS)
+					labelAction(state, LocalUseAction, symbol, state->ic - codeLineSize, sourceLine, lineNum); /* Checked once the whole file was mapped. */
+				else if (errCheckSymbol(searchKeyword(symbol), fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking if the symbol is a reserved keyword. */
+					state->code = ERROR; /* No output should be created for this source file. */
+					return; /* The line is corrupted. */
+				} else
+					labelAction(state, UseAction, symbol, lineNum, sourceLine, lineNum); /* Line number as address for error messaging purposes. */
+			} else { /* There is no label, the middle operand is an immediate value. */
+				if (getOpcode(operator) >= beginLabelArgSetI && getOpcode(operator) <= endLabelArgSetI) { /* Checking if this is a valid argument set. */
+					errInvalidArgumentSet(fileName, sourceLine, lineNum, I, 1); /* The argument set is invalid. */
+					state->code = ERROR; /* No output should be created for this source file. */
+					return; /* The line is corrupted. */
 				}
-			} /* Special case, the "stop" keyword, expecting no operands. */
-		} else if (status == InstructorFlag) { /* The word is a data instructor. */
-			if (isLabelLine) {
-				addAttribute(edit, DataLabel); /* Previous checks prevent this from failing. */
-				setAddress(edit, *dc); /* Stetting the address of this label. */
 			}
-			instructor = searchInstructorByString(word); /* Getting the instructor. */
-			if (instructor == NULL) {
-				errInvalidKeyword(fileName, sourceLine, word, lineNum); /* The instructor is invalid. */
-				code = ERROR; /* No output should be created for this source file. */
-				continue; /* The line is corrupted. */
+		} else if (strcmp(getOperatorKeyword(operator), stopOperator) != 0) { /* The remaining operators must be of type J. */
+			/* Extracting the data from the line. */
+			status = getJParam(sourceLine, &expecting, &index, &rs, &isLabeledArgSet, symbol);
+			if (errCheckJ(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) { /* Checking and handling source file issues. */
+				state->code = ERROR; /* No output should be created for this source file. */
+				return; /* The line is corrupted. */
 			}
-			dataExpectation = getExpectation(instructor); /* Saving the expectation. */
-			if (dataExpectation == ExpectString) { /* This is an asciz data instructor. */
-				status = getAscizParam(sourceLine, &expecting, &index, str);
-				if (errCheckAsciz(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) {
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-				/* Adding the size of the string to the data counter. */
-				(*dc) += strlen(str) + 1; /* +1 for a terminating character. */
-			} else if (dataExpectation == ExpectLabelEntry) { /* This is an entry instructor. */
-				if (isLabelLine) { /* Unnecessary label at the beginning of the line. */
-					wrnLabeledLine(fileName, sourceLine, lineNum, dataExpectation); /* Printing a warning message. */
-					removeSymbol(&front, edit); /* The assembler will ignore this label. */
-				}
-				/* Extracting the label from the line. */
-				status = getWord(sourceLine, &expecting, &index, symbol);
-				/* Checking and handling source file issues. */
-				if (errCheckExpectLabel(fileName, sourceLine, symbol, lineNum, index, expecting, status) == EEvent ||
-					errCheckSymbol(NULL, fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking the symbol. */
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-				if ((edit = searchLabel(front, symbol)) == NULL)
-					if ((edit = addSymbol(front, symbol, 0)) == NULL) /* Creating the next label if it is not in the symbol table. */
-						errFatal(); /* Memory allocation for this label had failed, cannot continue the program. */
-				if (hasAttribute(edit, ExternLabel) == SUCCESS) { /* A label cannot be both entry and external. */
-					errBothEntryAndExtern(fileName, sourceLine, lineNum, dataExpectation);
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-				addAttribute(edit, EntryLabel); /* This is an entry label, previous checks prevent this from failing */
-				if (isDeclared(edit) == ERROR)
-					setAddress(edit, lineNum); /* If the label is not declared it should be ready for an error message. */
-			} else if (dataExpectation == ExpectLabelExternal) { /* This is an extern instructor. */
-				if (isLabelLine) { /* Unnecessary label at the beginning of the line. */
-					wrnLabeledLine(fileName, sourceLine, lineNum, dataExpectation); /* Printing a warning message. */
-					removeSymbol(&front, edit); /* The assembler will ignore this label. */
-				}
-				/* Extracting the label from the line. */
-				status = getWord(sourceLine, &expecting, &index, symbol);
-				/* Checking and handling source file issues. */
-				if (errCheckExpectLabel(fileName, sourceLine, symbol, lineNum, index, expecting, status) == EEvent ||
-					errCheckSymbol(NULL, fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking the symbol. */
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-				if ((edit = searchLabel(front, symbol)) == NULL)
-					if ((edit = addSymbol(front, symbol, 0)) == NULL) /* Creating the next label if it is not in the symbol table. */
-						errFatal(); /* Memory allocation for this label had failed, cannot continue the program. */
-				if (hasAttribute(edit, EntryLabel) == SUCCESS) { /* A label cannot be both entry and external. */
-					errBothEntryAndExtern(fileName, sourceLine, lineNum, dataExpectation);
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-				if (isDeclared(edit) == SUCCESS) { /* An external label cannot be declared locally. */
-					errDeclaredExtern(fileName, sourceLine, getSymbol(edit), lineNum); /* Printing relevant error message. */
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
-				}
-				addAttribute(edit, ExternLabel); /* This is an external label, previous checks prevent this from failing */
-				setAddress(edit, 0); /* External labels have no address. */
-			} else if (dataExpectation == Expect8BitParams || dataExpectation == Expect16BitParams || dataExpectation == Expect32BitParams) {
-				expecting = dataExpectation; /* The "getDataParam" function requires the expectation. */
-				status = getDataParam(sourceLine, &expecting, &index, &count, args); /* Extracting the arguments. */
-				if (errCheckData(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) {
-					code = ERROR; /* No output should be created for this source file. */
-					continue; /* The line is corrupted. */
+			if (isLabeledArgSet) { /* The operand is a label. */
+				if (isLocalReference(symbol) == SUCCESS)
+					labelAction(state, LocalUseAction, symbol, state->ic - codeLineSize, sourceLine, lineNum); /* Checked once the whole file was mapped. */
+				else if (errCheckSymbol(searchKeyword(symbol), fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking if the symbol is a reserved keyword. */
+					state->code = ERROR; /* No output should be created for this source file. */
+					return; /* The line is corrupted. */
+				} else
+					labelAction(state, UseAction, symbol, lineNum, sourceLine, lineNum); /* Line number as address for error messaging purposes. */
+			} else { /* The operand is a register */
+				if (strcmp(getOperatorKeyword(operator), jmpOperator) != 0) { /* the "jmp" operator is the only one that can take a register as operand. */
+					errInvalidArgumentSet(fileName, sourceLine, lineNum, J, 0);
+					state->code = ERROR; /* No output should be created for this source file. */
+					return; /* The line is corrupted. */
 				}
-				increaseDataCounterByData(dc, count, dataExpectation); /* Incrementing the data counter based on the instruction and the number of arguments. */
 			}
+		} /* Special case, the "stop" keyword, expecting no operands. */
+	} else if (status == InstructorFlag) { /* The word is a data instructor. */
+		if (isLocalLine) {
+			errLocalLabelLine(fileName, sourceLine, lineNum); /* Local labels only mark branch targets. */
+			state->code = ERROR; /* No output should be created for this source file. */
+			return; /* The line is corrupted. */
+		}
+		if (isLabelLine)
+			labelAction(state, DataAction, NULL, state->dc, sourceLine, lineNum); /* Stetting the address of this label, previous checks prevent this from failing. */
+		instructor = searchInstructorByString(word); /* Getting the instructor. */
+		if (instructor == NULL) {
+			errInvalidKeyword(fileName, sourceLine, word, lineNum); /* The instructor is invalid. */
+			state->code = ERROR; /* No output should be created for this source file. */
+			return; /* The line is corrupted. */
 		}
-		while (sourceLine[index] != nullTermination) {/* Checking for unexpected characters that might have bean missed by some "get" functions from asmutils. */
-			if (sourceLine[index] != space && sourceLine[index] != tab) {
-				errUnexpectedToken(fileName, sourceLine, lineNum, index);
-				code = ERROR; /* No output should be created for this source file. */
-				break; /* One message like this per line is enough. */
+		dataExpectation = getExpectation(instructor); /* Saving the expectation. */
+		if (dataExpectation == ExpectString) { /* This is an asciz data instructor. */
+			status = getAscizParam(sourceLine, &expecting, &index, str);
+			if (errCheckAsciz(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) {
+				state->code = ERROR; /* No output should be created for this source file. */
+				return; /* The line is corrupted. */
+			}
+			/* Adding the size of the string to the data counter. */
+			state->dc += strlen(str) + 1; /* +1 for a terminating character. */
+		} else if (dataExpectation == ExpectLabelEntry || dataExpectation == ExpectLabelExternal) { /* This is an entry or an extern instructor. */
+			if (isLabelLine) { /* Unnecessary label at the beginning of the line. */
+				wrnLabeledLine(fileName, sourceLine, lineNum, dataExpectation); /* Printing a warning message, the label stays in the symbol table without a code or a data attribute. */
+			}
+			/* Extracting the label from the line. */
+			status = getWord(sourceLine, &expecting, &index, symbol);
+			/* Checking and handling source file issues. */
+			if (errCheckExpectLabel(fileName, sourceLine, symbol, lineNum, index, expecting, status) == EEvent ||
+				errCheckSymbol(searchKeyword(symbol), fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking the symbol. */
+				state->code = ERROR; /* No output should be created for this source file. */
+				return; /* The line is corrupted. */
+			}
+			/* Marking the label, a label cannot be both entry and external. */
+			if (labelAction(state, dataExpectation == ExpectLabelEntry ? EntryAction : ExternAction, symbol, lineNum, sourceLine, lineNum) == ERROR)
+				return; /* The line is corrupted. */
+		} else if (dataExpectation == Expect8BitParams || dataExpectation == Expect16BitParams || dataExpectation == Expect32BitParams) {
+			expecting = dataExpectation; /* The "getDataParam" function requires the expectation. */
+			status = getDataParam(sourceLine, &expecting, &index, &count, args); /* Extracting the arguments. */
+			if (errCheckData(fileName, sourceLine, lineNum, index, expecting, status) == EEvent) {
+				state->code = ERROR; /* No output should be created for this source file. */
+				return; /* The line is corrupted. */
 			}
-		index++; /* Incrementing the index. */
+			increaseDataCounterByData(&state->dc, count, dataExpectation); /* Incrementing the data counter based on the instruction and the number of arguments. */
+		}
+	}
+	while (sourceLine[index] != nullTermination) {/* Checking for unexpected characters that might have bean missed by some "get" functions from asmutils. */
+		if (sourceLine[index] != space && sourceLine[index] != tab) {
+			errUnexpectedToken(fileName, sourceLine, lineNum, index);
+			state->code = ERROR; /* No output should be created for this source file. */
+			break; /* One message like this per line is enough. */
+		}
+	index++; /* Incrementing the index. */
+	}
+}
+
+/**
+ * Applies the given label action on the symbol table of the given state,
+ * or records it if the state is deferring.
+ * Returns ERROR if the action failed and the rest of the line should be
+ * skipped, SUCCESS otherwise. A recorded action always succeeds.
+ */
+Code labelAction(MapState *state, LabelAction action, const char *symbol, unsigned long int value, const char *sourceLine, unsigned long int lineNum) {
+	if (state->messages == NULL)
+		return executeLabelAction(state, action, symbol, value, sourceLine, lineNum);
+
+	recordLabelAction(state, action, symbol, value, sourceLine, lineNum);
+	return SUCCESS; /* The action will be checked when it is replayed. */
+}
+
+/**
+ * Applies the given label action on the symbol table of the given state.
+ * Code and data actions take the address of the label from the value
+ * parameter, use actions take the line number for error messaging
+ * purposes from it.
+ * Prints an error message and sets the code of the given state to ERROR
+ * if the action failed.
+ * Returns ERROR if the action failed and the rest of the line should be
+ * skipped, SUCCESS otherwise.
+ */
+Code executeLabelAction(MapState *state, LabelAction action, const char *symbol, unsigned long int value, const char *sourceLine, unsigned long int lineNum) {
+	Label label; /* The label the action is applied on. */
+	NameKind kind; /* What the symbol is. */
+
+	if (action == CodeAction || action == DataAction) {
+		addAttribute(state->symbolTable, state->edit, action == CodeAction ? CodeLabel : DataLabel); /* Previous checks prevent this from failing. */
+		setAddress(state->symbolTable, state->edit, value); /* Stetting the address of this label. */
+		return SUCCESS;
+	}
+	if (action == LocalAction) {
+		if (addLocalLabel(getLocalLabels(state->symbolTable), strtoul(symbol, NULL, DECIMAL), value) == ERROR)
+			errFatal(); /* Memory allocation for this label had failed, cannot continue the program. */
+		return SUCCESS;
+	}
+	if (action == LocalUseAction) {
+		addLocalUse(state, symbol, value, lineNum); /* Checked once the whole file was mapped. */
+		return SUCCESS;
+	}
+	kind = searchSymbol(state->symbolTable, symbol, &label); /* One probe tells if the symbol is reserved, a label or new. */
+	if (action == DefineAction && errCheckSymbol(kind, state->fileName, sourceLine, symbol, lineNum) == EEvent) { /* Checking the symbol. */
+		state->code = ERROR; /* No output should be created for this source file. */
+		return ERROR; /* The line is corrupted. */
+	}
+
+	if (kind == UnknownName) /* Creating the label if it is not in the symbol table, use actions keep the line number for error messaging purposes. */
+		if ((label = addSymbol(state->symbolTable, symbol, action == UseAction ? value : 0)) == NO_LABEL)
+			errFatal(); /* Memory allocation for this label had failed, cannot continue the program. */
+	if (action == UseAction)
+		return SUCCESS; /* Label operands only have to be in the symbol table. */
+	state->edit = label;
+
+	if (action == EntryAction) {
+		if (hasAttribute(state->symbolTable, label, ExternLabel) == SUCCESS) { /* A label cannot be both entry and external. */
+			errBothEntryAndExtern(state->fileName, sourceLine, lineNum, ExpectLabelEntry);
+			state->code = ERROR; /* No output should be created for this source file. */
+			return ERROR; /* The line is corrupted. */
 		}
+		addAttribute(state->symbolTable, label, EntryLabel); /* This is an entry label, previous checks prevent this from failing */
+		if (isDeclared(state->symbolTable, label) == ERROR)
+			setAddress(state->symbolTable, label, lineNum); /* If the label is not declared it should be ready for an error message. */
+	} else if (action == ExternAction) {
+		if (hasAttribute(state->symbolTable, label, EntryLabel) == SUCCESS) { /* A label cannot be both entry and external. */
+			errBothEntryAndExtern(state->fileName, sourceLine, lineNum, ExpectLabelExternal);
+			state->code = ERROR; /* No output should be created for this source file. */
+			return ERROR; /* The line is corrupted. */
+		}
+		if (isDeclared(state->symbolTable, label) == SUCCESS) { /* An external label cannot be declared locally. */
+			errDeclaredExtern(state->fileName, sourceLine, getSymbol(state->symbolTable, label), lineNum); /* Printing relevant error message. */
+			state->code = ERROR; /* No output should be created for this source file. */
+			return ERROR; /* The line is corrupted. */
+		}
+		addAttribute(state->symbolTable, label, ExternLabel); /* This is an external label, previous checks prevent this from failing */
+		setAddress(state->symbolTable, label, 0); /* External labels have no address. */
 	}
+	return SUCCESS;
+}
 
-	*symbolTable = front; /* Returning the symbol table trough a parameter. */
+/**
+ * Records the given label action in the deferred actions of the given
+ * state, along with the position of its messages stream. The source
+ * line is stored once for all the actions of the same line.
+ */
+void recordLabelAction(MapState *state, LabelAction action, const char *symbol, unsigned long int value, const char *sourceLine, unsigned long int lineNum) {
+	struct action *record; /* The new record. */
+
+	if (state->actionCount == state->actionCapacity) { /* Making room for the new record. */
+		state->actionCapacity = state->actionCapacity ? state->actionCapacity * 2 : INITIAL_ACTIONS;
+		if ((record = realloc(state->actions, state->actionCapacity * sizeof(struct action))) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		state->actions = record;
+	}
+	if (state->pooledLine != lineNum) { /* The first action of this line. */
+		state->pooledLineOffset = poolString(state, sourceLine);
+		state->pooledLine = lineNum;
+	}
 
-	/* Avoiding memory leak. */
-	free(word);
-	free(symbol);
-	free(str);
-	free(args);
+	record = state->actions + state->actionCount++;
+	record->action = action;
+	record->line = lineNum;
+	record->value = value;
+	record->offset = ftell(state->messages);
+	record->sourceLine = state->pooledLineOffset;
+	record->symbol = (symbol != NULL) ? poolString(state, symbol) : 0;
+}
 
-	return code;
+/**
+ * Copies the given string, terminating character included, to the end
+ * of the strings pool of the given state.
+ * Returns the offset of the copy in the pool.
+ */
+unsigned long int poolString(MapState *state, const char *str) {
+	unsigned long int length = strlen(str) + 1; /* +1 for a terminating character. */
+	unsigned long int offset = state->poolSize; /* The copy goes at the end. */
+	char *pool; /* The pool after resizing. */
+
+	while (state->poolSize + length > state->poolCapacity) { /* Making room for the string. */
+		state->poolCapacity = state->poolCapacity ? state->poolCapacity * 2 : INITIAL_POOL;
+		if ((pool = realloc(state->pool, state->poolCapacity)) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		state->pool = pool;
+	}
+
+	memcpy(state->pool + offset, str, length);
+	state->poolSize += length;
+	return offset;
+}
+
+/**
+ * Replays the deferred label actions of the chunk state on the second
+ * parameter into the given state, in the order they were recorded, while
+ * copying the messages of the chunk into the message stream in between.
+ * The counters of the chunk are relative, so its code and data labels
+ * are positioned after everything that was mapped into the given state
+ * so far, and the counters of the given state are then advanced by the
+ * counters of the chunk.
+ * A failed action skips the rest of its line, its actions and messages,
+ * just like it would have if it was applied on the spot.
+ */
+void replayMapState(MapState *state, MapState *chunk) {
+	const unsigned long int codeBase = state->ic, dataBase = state->dc; /* Where the chunk begins. */
+	unsigned long int index; /* To loop trough the records. */
+	unsigned long int value; /* The value of every action after positioning it. */
+	long int position = 0; /* The part of the messages stream that was handled. */
+	char isSkipping = 0; /* To track when the rest of a line should be skipped. */
+	struct action *record; /* Every record. */
+	FILE *messages = getMessageStream(); /* The messages of the chunk go where the messages of the state go. */
+
+	rewind(chunk->messages); /* Reading the messages from the beginning. */
+
+	for (index = 0; index < chunk->actionCount; index++) {
+		record = chunk->actions + index;
+
+		if (isSkipping) { /* Dropping everything until the end of the line. */
+			if (record->action == LineEndAction) {
+				fseek(chunk->messages, record->offset, SEEK_SET);
+				position = record->offset;
+				isSkipping = 0;
+			}
+			continue;
+		}
+
+		/* Printing the messages that came before the action. */
+		position += copyStream(messages, chunk->messages, record->offset - position);
+		if (record->action == LineEndAction)
+			continue; /* Nothing to apply. */
+
+		value = record->value;
+		if (record->action == CodeAction || record->action == LocalAction || record->action == LocalUseAction)
+			value += codeBase; /* Positioning the code label, or the code line of a local label. */
+		else if (record->action == DataAction)
+			value += dataBase; /* Positioning the data label. */
+
+		if (executeLabelAction(state, record->action, chunk->pool + record->symbol, value, chunk->pool + record->sourceLine, record->line) == ERROR)
+			isSkipping = 1; /* The line is corrupted. */
+	}
+	copyStream(messages, chunk->messages, -1); /* Printing the rest of the messages. */
+
+	/* The next chunk begins after this one. */
+	state->ic += chunk->ic;
+	state->dc += chunk->dc;
+	if (chunk->code == ERROR)
+		state->code = ERROR; /* No output should be created for this source file. */
+}
+
+/**
+ * Checks if the given first pass state had as many errors as its limit.
+ * Returns SUCCESS if it had and ERROR otherwise.
+ */
+Code isErrorLimitReached(MapState *state) {
+	return (state->maxErrors != 0 && state->errors >= state->maxErrors) ? SUCCESS : ERROR;
+}
+
+/**
+ * Returns the instruction counter of the given first pass state.
+ */
+unsigned long int getInstructionCounter(MapState *state) {
+	return state->ic;
+}
+
+/**
+ * Returns the data counter of the given first pass state.
+ */
+unsigned long int getDataCounter(MapState *state) {
+	return state->dc;
+}
+
+/**
+ * Frees all the memory used by the given first pass state, its symbol
+ * table included.
+ */
+void freeMapState(MapState *state) {
+	if (state->symbolTable != NULL)
+		freeSymbolTable(state->symbolTable);
+	free(state->word);
+	free(state->symbol);
+	free(state->str);
+	free(state->args);
+	free(state->actions);
+	free(state->pool);
+	free(state->localUses);
+	free(state);
 }
 
 /**
@@ -392,313 +960,797 @@ void increaseDataCounterByData(unsigned long int *dc, const int count, Expectati
  * the given source file to contain no issues and the
  * given symbol table to be initialized and set with
  * all labels from the file in it. In addition the
- * last two parameters are expected to equal the size
+ * ic and dc parameters are expected to equal the size
  * of the code segment and the size of the data
  * segment respectively.
  * This function will create an .ob file for all the
  * assembled data and .ent or .ext files if the
  * source file contains entry or external labels
  * respectively.
+ * If the chunks parameter is not null the chunks are
+ * encoded on multiple threads and written in order,
+ * otherwise the given options may run the stages of
+ * the assembling on separate threads.
+ * In spill mode the data segment is kept in a file
+ * mapped into memory rather than on the heap.
+ */
+void convert(FILE *file, const char *fileName, SymbolTable *symboltable, char *sourceLine, const unsigned long int ic, const unsigned long int dc, Chunks *chunks, Options *options) {
+	char *dataSegment; /* Points to the array that stores all the assembled data instructors parameters. */
+	char *spillFileName = outputFileName(fileName, SPILL_EXTENTION); /* Used only if the data segment is spilled, made unique by createSegment. */
+	ConvertState *state; /* Writes the assembled lines into the output files. */
+
+	if ((dataSegment = createSegment(dc, spillFileName, isSpilled(options) == SUCCESS)) == NULL) { /* Allocating memory for the data segment. */
+		errFatal(); /* Cannot continue without memory. */
+	}
+	free(spillFileName);
+	state = openOutputs(fileName, symboltable, dataSegment, ic, dc, options);
+
+	if (chunks != NULL)
+		convertChunks(chunks, symboltable, dataSegment, state); /* Encoding the chunks in parallel and writing them in order. */
+	else if (isPipelined(options) == SUCCESS)
+		convertPipelined(state, file);
+	else
+		convertLines(state, file, sourceLine, 0);
+
+	closeOutputs(state, dc);
+	freeSegment(dataSegment, dc, isSpilled(options) == SUCCESS);
+}
+
+/**
+ * Writes the output files of the given source file from the code lines
+ * and label references kept in the given second pass state, and the
+ * given data segment. The ic and dc parameters are expected to equal
+ * the size of the code segment and the size of the data segment
+ * respectively. The given options choose the format of the output files.
+ */
+void writeAssembled(const char *fileName, ConvertState *assembled, char *dataSegment, const unsigned long int ic, const unsigned long int dc, Options *options) {
+	ConvertState *state = openOutputs(fileName, assembled->symbolTable, dataSegment, ic, dc, options);
+
+	writeConvertState(state, assembled);
+	closeOutputs(state, dc);
+}
+
+/**
+ * Creates the object file of the given source file and writes its
+ * header. Returns a second pass state that writes into the output files,
+ * starting from the memory start address, in the format the given
+ * options choose. The entries and externals files are created only if
+ * there is something to write into them.
+ */
+ConvertState *openOutputs(const char *fileName, SymbolTable *symboltable, char *dataSegment, const unsigned long int ic, const unsigned long int dc, Options *options) {
+	char *obFileName = outputFileName(fileName, OUTPUT_OB_EXTENTION); /* The name of the object file. */
+	char *binFileName; /* The name of the binary object file. */
+	char *elfFileName; /* The name of the ELF object file. */
+	ConvertState *state; /* Writes the assembled lines into the output files. */
+
+	if ((state = createConvertState(symboltable, dataSegment, MEMORY_START_ADDRESS, 0, ic)) == NULL) /* The whole code segment is kept, the object file may need it in one piece. */
+		errFatal(); /* Cannot continue without memory. */
+
+	state->outputObj = fopen(obFileName, "w+"); /* Creating/recreating the output file. */
+	if (state->outputObj == NULL)
+		errFatal(); /* cannot continue without the output file. */
+	if (isInPlace(options) == SUCCESS)
+		state->inPlaceJobs = getJobs(options); /* The object file is filled when the outputs are closed. */
+	else if ((state->obWriter = createHexWriter(state->outputObj)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	state->entFileName = outputFileName(fileName, OUTPUT_ENT_EXTENTION); /* Created only if there is something to write. */
+	state->extFileName = outputFileName(fileName, OUTPUT_EXT_EXTENTION); /* Created only if there is something to write. */
+	state->isGroupedExt = isGroupedExt(options) == SUCCESS;
+	if (isMapped(options) == SUCCESS) { /* The map files are written when the outputs are closed. */
+		state->mapFileName = outputFileName(fileName, OUTPUT_MAP_EXTENTION);
+		state->mapIndexFileName = outputFileName(fileName, OUTPUT_MAP_INDEX_EXTENTION);
+	}
+	if (isBinary(options) == SUCCESS) { /* The binary object file is written along with the object file. */
+		binFileName = outputFileName(fileName, OUTPUT_BIN_EXTENTION);
+		if ((state->outputBin = fopen(binFileName, "wb+")) == NULL) /* Creating\recreating the output file. */
+			errFatal(); /* should not happen but, just in case. */
+		if ((state->binObject = createBinaryObject(state->outputBin, ic, dc)) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		free(binFileName);
+	}
+	if (isElf(options) == SUCCESS) { /* The ELF object file is written along with the object file. */
+		elfFileName = outputFileName(fileName, OUTPUT_ELF_EXTENTION);
+		if ((state->outputElf = fopen(elfFileName, "wb+")) == NULL) /* Creating\recreating the output file. */
+			errFatal(); /* should not happen but, just in case. */
+		if ((state->elfObject = createElfObject(state->outputElf, ic, dc)) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		free(elfFileName);
+	}
+	free(obFileName);
+
+	if (state->obWriter != NULL)
+		writeHexHeader(state->obWriter, ic, dc);
+
+	return state;
+}
+
+/**
+ * Writes the rest of the code segment and the data segment of the given
+ * second pass state, and the entries file and the map files from its symbol table,
+ * closes its output files and frees it.
+ */
+void closeOutputs(ConvertState *state, const unsigned long int dc) {
+	writeCodeSegment(state);
+	if (state->obWriter != NULL)
+		writeHexData(state->obWriter, state->dataSegment, dc, state->address); /* Writing the data segment to the output file. */
+	else
+		fillObject(state, dc);
+	writeEntries(state);
+	if (state->mapFileName != NULL)
+		writeSymbolMap(state->mapFileName, state->mapIndexFileName, state->symbolTable, state->address - MEMORY_START_ADDRESS, dc);
+	if (state->isGroupedExt)
+		writeGroupedExterns(state);
+	if (state->binObject != NULL)
+		writeBinaryTables(state->binObject, state->symbolTable, state->dataSegment);
+	if (state->elfObject != NULL)
+		writeElfTables(state->elfObject, state->symbolTable, state->dataSegment);
+
+	/* Closing used file streams. */
+	if (state->obWriter != NULL)
+		freeHexWriter(state->obWriter); /* Writing the rest of the object file. */
+	fclose(state->outputObj);
+	if (state->outputExt != NULL)
+		fclose(state->outputExt);
+	if (state->binObject != NULL) {
+		freeBinaryObject(state->binObject);
+		fclose(state->outputBin);
+	}
+	if (state->elfObject != NULL) {
+		freeElfObject(state->elfObject);
+		fclose(state->outputElf);
+	}
+	/* Freeing memory. */
+	free(state->entFileName);
+	free(state->extFileName);
+	free(state->mapFileName);
+	free(state->mapIndexFileName);
+	freeConvertState(state);
+}
+
+/**
+ * Creates a new second pass state that encodes the code lines starting
+ * from the given address, and assembles data instructors into the given
+ * data segment starting from the given index.
+ * The encoded code lines and the external label references
+ * are kept in the state, the last parameter is the size of the code
+ * they take (in bytes).
+ * Returns a pointer to the new state or a null pointer if the memory
+ * allocation had failed.
  */
-void convert(FILE *file, const char *fileName, SymbolTable *symboltable, char *sourceLine, const unsigned long int ic, const unsigned long int dc) {
+ConvertState *createConvertState(SymbolTable *symbolTable, char *dataSegment, unsigned long int address, unsigned long int dataIndex, unsigned long int codeSize) {
 	const char assembledLineSize = 4; /* The size for the bit field in the output file. */
-	const char *stopOperator = "stop"; /* Special case keyword, no operands. */
-	int index; /* An index to track the position on the line. */
+	ConvertState *state = calloc(1, sizeof(ConvertState)); /* Every field starts empty. */
+
+	if (state == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	state->symbolTable = symbolTable;
+	state->dataSegment = dataSegment;
+	state->address = address;
+	state->dataSegmentIndex = dataIndex;
+
+	if ((state->word = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
+		(state->symbol = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
+		(state->str = malloc(SOURCE_LINE_LENGTH)) == NULL || /* An asciz string cannot be longer than that. */
+		(state->args = calloc(sizeof(long int) ,(SOURCE_LINE_LENGTH / 2) + 1)) == NULL || /* A line of db or dh or dw will never have more arguments than that. */
+		(codeSize > 0 && (state->codeSegment = malloc(codeSize / assembledLineSize * sizeof(Word))) == NULL)) {
+		freeConvertState(state);
+		return NULL; /* Memory allocation failed. */
+	}
+
+	return state;
+}
+
+/**
+ * Assembles the source lines of the given stream, starting from its
+ * current position, into the given second pass state. If the last
+ * parameter is zero the stream is assembled until its end, otherwise
+ * only that number of lines are assembled.
+ * Expects the third parameter to be a buffer SOURCE_LINE_LENGTH + 1 long.
+ */
+void convertLines(ConvertState *state, FILE *file, char *sourceLine, unsigned long int lineCount) {
+	unsigned long int lines = 0; /* The number of lines that were assembled. */
 	int lengthCheck = -1; /* A variable to use the extractSourceLine function. */
+	Flag status; /* To catch the end of the file. */
+
+	do {
+		status = extractSourceLine(file, sourceLine, &lengthCheck);
+		convertLine(state, sourceLine);
+		lines++;
+	} while (status != EndFileFlag && (lineCount == 0 || lines < lineCount));
+}
+
+/**
+ * Assembles the given source line into the given second pass state.
+ * Code lines are encoded at the address of the state and data
+ * instructors are copied into its data segment.
+ */
+void convertLine(ConvertState *state, char *sourceLine) {
+	struct instruction instruction; /* The parsed code line. */
+
+	if (parseLine(state, sourceLine, &instruction) == OperatorFlag) /* Only code lines are encoded. */
+		addCode(state, encodeInstruction(&instruction), instruction.label); /* Assembling the line. */
+}
+
+/**
+ * Assembles the given source line at the address of the given second
+ * pass state, just like convertLine, but hands the result back instead
+ * of writing it. Data instructors are copied into the data segment of
+ * the state and the address of the state is not updated.
+ * Returns OperatorFlag for a code line, in that case the bit field is
+ * set into the third parameter, the label operand of the line (or
+ * NO_LABEL) into the fourth and the last parameter tells if the operand
+ * is relative to the address of the line. Returns IllegalSymbolFlag for
+ * a code line with a label operand that is not in the symbol table and
+ * NoIssueFlag for any other line.
+ */
+Flag encodeLine(ConvertState *state, char *sourceLine, unsigned long int *data, Label *operand, char *isRelative) {
+	struct instruction instruction; /* The parsed code line. */
+	Flag status = parseLine(state, sourceLine, &instruction);
+
+	if (status == OperatorFlag) {
+		*data = encodeInstruction(&instruction);
+		*operand = instruction.operand;
+		*isRelative = getType(instruction.operator) == I;
+	}
+	return status;
+}
+
+/**
+ * Adds the given encoded code line at the current address of the given
+ * second pass state, along with a reference to the given external label
+ * if it is not NO_LABEL, and advances the address.
+ */
+void addCode(ConvertState *state, Word data, Label label) {
+	const char assembledLineSize = 4; /* The size for the bit field in the output file. */
+
+	if (label != NO_LABEL)
+		emitReference(state, label); /* Writing to the extern file. */
+	emitCode(state, data);
+	state->address += assembledLineSize; /* Updating the code address tracker, every line takes exactly 4 bytes. */
+}
+
+/**
+ * Parses the given source line using the given second pass state.
+ * If the line is a code line its operands are extracted into the last
+ * parameter, positioned at the address of the state, and OperatorFlag
+ * is returned, or IllegalSymbolFlag if its label operand is not in the
+ * symbol table. Otherwise NoIssueFlag is returned and if the line is a
+ * data instructor line its data is copied into the data segment of the
+ * state. The address of the state is not updated by this function.
+ */
+Flag parseLine(ConvertState *state, char *sourceLine, struct instruction *instruction) {
+	const char *stopOperator = "stop"; /* Special case keyword, no operands. */
+	int index = 0; /* The line start at index 0. */
 	int count; /* Used for counting arguments for db, dh, and dw keywords. */
-	unsigned long int address = MEMORY_START_ADDRESS; /* To track the memory address of the assembled operators in the output file. */
-	char shouldStop = 0; /* To track when the loop should stop meaning, the source file has ended */
 	char isLabeledArgSet = 0; /* To use the "getIParam" and "getJParam" functions from asmutils. */
-	char *word; /* A variable to store the labels\Instructors\Operators returned from getWord. */
-	char *symbol; /* A variable to store the label operand of I\J operators. */
-	char *str; /* A variable to store and access asciz strings. */
-	long int *args; /* To store and access db\dh\dw arguments. */
-	char rs, rt, rd; /* Variables to store register addresses. */
-	short immed; /* A variable to store the immediate value for I operators. */
-	char *dataSegment; /* Points to the array that stores all the assembled data instructors parameters. */
-	unsigned long int dataSegmentIndex = 0; /* Index variable for the data segment array. */
-	FILE *outputObj; /* The main output file. */
-	FILE *outputEnt = NULL, *outputExt = NULL; /* Entries and externals output files. */
-	char *obFileName, *entFileName, *extFileName; /* pointers to the names of the output files. */
-	SymbolTable *label; /* A variable for label handling. */
-	Operator *operator; /* To hold operators. */
-	Instructor *instructor; /* To hold instructors. */
+	char *word = state->word; /* A variable to store the labels\Instructors\Operators returned from getWord. */
+	char *symbol = state->symbol; /* A variable to store the label operand of I\J operators. */
+	char *str = state->str; /* A variable to store and access asciz strings. */
+	long int *args = state->args; /* To store and access db\dh\dw arguments. */
+	Label label; /* A variable for label handling. */
+	unsigned long int address; /* The address of a numeric local label operand. */
+	const Instructor *instructor; /* To hold instructors. */
 	Expectation expecting; /* To use functions and track data instruction expectation. */
 	Expectation sizeExpectation; /* Used for extracting data arguments. */
-	Flag status; /* To differentiate different situations and catch memory allocation issues. */
+	Flag status; /* To differentiate different situations. */
+
+	if ((status = getWord(sourceLine, &expecting, &index, word)) == LabelFlag) { /* Extracting the beginning of the line. */
+		status = getWord(sourceLine, &expecting, &index, word); /* Extracting again if it was a label. */
+	} else if (status == CommentLineFlag || (status == OperatorFlag && expecting == ExpectWord))
+		return NoIssueFlag; /* Skipping a comment line or an empty line. */
+
+	if (status == OperatorFlag) {
+		/* Every operand starts empty. */
+		instruction->address = state->address;
+		instruction->operator = searchOperatorByString(word); /* Getting the operator. */
+		instruction->rs = instruction->rt = instruction->rd = 0;
+		instruction->isRegister = 0;
+		instruction->immed = 0;
+		instruction->addressValue = 0;
+		instruction->operand = NO_LABEL;
+		instruction->label = NO_LABEL;
+		instruction->isLast = 0;
+
+		if (getType(instruction->operator) == R) { /* Handling R type operators. */
+			if (getOpcode(instruction->operator))
+				/* Extracting 2 operands. */
+				getRParam(sourceLine, &expecting, R2, &index, &instruction->rs, &instruction->rt, &instruction->rd);
+			else
+				/* Extracting 3 operands. */
+				getRParam(sourceLine, &expecting, R3, &index, &instruction->rs, &instruction->rt, &instruction->rd);
+		} else if (getType(instruction->operator) == I) { /* Handling I type operators. */
+			/* Extracting the data from the line as operand set for I operators. */
+			getIParam(sourceLine, &expecting, &index, &instruction->rs, &instruction->rt, &instruction->immed, &isLabeledArgSet, symbol);
+			if (isLabeledArgSet && isLocalReference(symbol) == SUCCESS) { /* A numeric local label, found by the address of the line. */
+				if (searchLocalLabel(getLocalLabels(state->symbolTable), symbol, state->address, &address) == ERROR)
+					return IllegalSymbolFlag; /* Cannot be encoded. */
+				instruction->immed = address - state->address; /* Calculating the difference into the immediate field. */
+			} else if (isLabeledArgSet) { /* If one of the operands is a label. */
+				if ((label = searchLabel(state->symbolTable, symbol)) == NO_LABEL) /* Extracting the label. */
+					return IllegalSymbolFlag; /* Cannot be encoded. */
+				instruction->operand = label;
+				instruction->immed = getAddress(state->symbolTable, label) - state->address; /* Calculating the difference into the immediate field. */
+			} /* If there was no label no special treatment is required. */
+		} else if (strcmp(word, stopOperator) != 0) { /* The remaining operators must be of type J, the "stop" keyword takes no operands. */
+			/* Extracting the data from the line. */
+			getJParam(sourceLine, &expecting, &index, &instruction->rs, &isLabeledArgSet, symbol);
+			if (isLabeledArgSet && isLocalReference(symbol) == SUCCESS) { /* A numeric local label, found by the address of the line. */
+				if (searchLocalLabel(getLocalLabels(state->symbolTable), symbol, state->address, &address) == ERROR)
+					return IllegalSymbolFlag; /* Cannot be encoded. */
+				instruction->addressValue = address; /* Assembling the line with a local label. */
+			} else if (isLabeledArgSet) { /* If the operand is a label. */
+				if ((label = searchLabel(state->symbolTable, symbol)) == NO_LABEL) /* Extracting the label from the symbol table. */
+					return IllegalSymbolFlag; /* Cannot be encoded. */
+				instruction->operand = label;
+				if (hasAttribute(state->symbolTable, label, ExternLabel) == SUCCESS)
+					instruction->label = label; /* The reference should be written as well. */
+				instruction->addressValue = getAddress(state->symbolTable, label); /* Assembling the line with a label. */
+			} else {
+				instruction->isRegister = 1; /* Assembling the line with a register. */
+				instruction->addressValue = instruction->rs;
+			}
+		}
+		return OperatorFlag;
+	}
+
+	/* At this point the line can only be a data instruction line. */
+	instructor = searchInstructorByString(word); /* Getting the instructor. */
+	expecting = getExpectation(instructor); /* To know what should be the next part of the line. */
+	if (expecting == ExpectString) {
+		getAscizParam(sourceLine, &expecting, &index, str); /* Extracting the string. */
+		assembleAsciz(state->dataSegment, str, &state->dataSegmentIndex); /* Copying the string to the data segment, it will be added to the output file at the end. */
+	} else if (expecting == Expect8BitParams || expecting == Expect16BitParams || expecting == Expect32BitParams) { /* The instructor is db, dh, or dw. */
+		count = 0; /* Initializing the argument counting variable. */
+		sizeExpectation = expecting; /* Keeping that expectation for the assembling part since getDataParam will modify it. */
+		getDataParam(sourceLine, &expecting, &index, &count, args); /* Extracting the arguments. */
+		assembleData(state->dataSegment, &state->dataSegmentIndex, sizeExpectation, count, args); /* Copying the argument to the data segment. */
+	}
+	return NoIssueFlag;
+}
 
+/**
+ * Encodes the given parsed code line into a bit field and returns it.
+ */
+Word encodeInstruction(struct instruction *instruction) {
+	if (getType(instruction->operator) == R)
+		return encodeR(instruction->operator, instruction->rs, instruction->rt, instruction->rd);
+	if (getType(instruction->operator) == I)
+		return encodeI(instruction->operator, instruction->rs, instruction->rt, instruction->immed);
+	return encodeJ(instruction->operator, instruction->isRegister, instruction->addressValue);
+}
 
-	/* Allocating memory for the strings that should store the output file names. */
-	if ((obFileName = malloc(strlen(fileName) - FILE_EXTENSION_LEN + strlen(OUTPUT_OB_EXTENTION) + 1)) == NULL)
-		errFatal(); /* Cannot continue without memory. */
-	if ((entFileName = malloc(strlen(fileName) - FILE_EXTENSION_LEN + strlen(OUTPUT_ENT_EXTENTION) + 1)) == NULL)
-		errFatal(); /* Cannot continue without memory. */
-	if ((extFileName = malloc(strlen(fileName) - FILE_EXTENSION_LEN + strlen(OUTPUT_EXT_EXTENTION) + 1)) == NULL)
+/**
+ * Assembles the given stream, starting from its current position until
+ * its end, into the given second pass state which is expected to have
+ * output files. Reading, parsing and encoding run on their own threads
+ * while the calling thread writes the encoded lines in order, a batch
+ * at a time, so formatting them overlaps the stages before it.
+ */
+void convertPipelined(ConvertState *state, FILE *file) {
+	struct pipeline pipeline; /* Shared by the stages. */
+	struct encoded word; /* Every encoded line. */
+	pthread_t reader, parser, encoder; /* A thread for every stage but the last. */
+
+	pipeline.file = file;
+	if ((pipeline.state = createConvertState(state->symbolTable, state->dataSegment, state->address, state->dataSegmentIndex, 0)) == NULL ||
+		(pipeline.lines = createQueue(PIPELINE_QUEUE_SIZE, sizeof(struct sourceline))) == NULL ||
+		(pipeline.instructions = createQueue(PIPELINE_QUEUE_SIZE, sizeof(struct instruction))) == NULL ||
+		(pipeline.words = createQueue(PIPELINE_QUEUE_SIZE, sizeof(struct encoded))) == NULL)
 		errFatal(); /* Cannot continue without memory. */
 
-	/* Getting the names of the output files. */
-	extractOutputFileNames(fileName, obFileName, entFileName, extFileName);
+	startStage(&reader, readStage, &pipeline);
+	startStage(&parser, parseStage, &pipeline);
+	startStage(&encoder, encodeStage, &pipeline);
 
-	outputObj = fopen(obFileName, "w+"); /* Creating/recreating the output file. */
-	if (outputObj == NULL)
-		errFatal(); /* cannot continue without the output file. */
-	if ((dataSegment = malloc(dc)) == NULL) { /* Allocating memory for the data segment. */
+	/* Writing the encoded lines in the order they were read. */
+	for (popQueue(pipeline.words, &word); !word.isLast; popQueue(pipeline.words, &word)) {
+		state->address = word.address;
+		addCode(state, word.data, word.label);
+		if (state->codeCount - state->codeWritten == PIPELINE_WRITE_BATCH)
+			writeCodeSegment(state);
+	}
+
+	pthread_join(reader, NULL);
+	pthread_join(parser, NULL);
+	pthread_join(encoder, NULL);
+
+	state->address = pipeline.state->address; /* The address after the last code line. */
+	state->dataSegmentIndex = pipeline.state->dataSegmentIndex;
+
+	freeConvertState(pipeline.state);
+	freeQueue(pipeline.lines);
+	freeQueue(pipeline.instructions);
+	freeQueue(pipeline.words);
+}
+
+/**
+ * Maps the given stream, starting from its current position until its
+ * end, into the given first pass state while the source lines are read
+ * on another thread.
+ */
+void mapPipelined(MapState *state, FILE *file) {
+	struct pipeline pipeline; /* Shared by the stages. */
+	struct sourceline line; /* Every source line. */
+	unsigned long int lineNum = 1; /* To track the line number. */
+	pthread_t reader; /* The reading stage. */
+
+	pipeline.file = file;
+	if ((pipeline.lines = createQueue(PIPELINE_QUEUE_SIZE, sizeof(struct sourceline))) == NULL)
 		errFatal(); /* Cannot continue without memory. */
+
+	startStage(&reader, readStage, &pipeline);
+
+	do {
+		popQueue(pipeline.lines, &line);
+		if (isErrorLimitReached(state) == ERROR)
+			mapLine(state, line.text, lineNum, line.length, line.status);
+		else
+			state->skipped++; /* The reading stage cannot be stopped, so the rest of the lines are only counted. */
+		lineNum++; /* The next line. */
+	} while (line.status != EndFileFlag);
+
+	pthread_join(reader, NULL);
+	freeQueue(pipeline.lines);
+}
+
+/**
+ * Starts the given pipeline stage on a new thread.
+ */
+void startStage(pthread_t *thread, void *(*stage)(void *), struct pipeline *pipeline) {
+	if (pthread_create(thread, NULL, stage, pipeline) != 0)
+		errFatal(); /* Cannot continue without the thread. */
+}
+
+/**
+ * The reading stage of the pipeline, reads the source lines of the file
+ * into the lines queue until the end of the file.
+ * Used as a thread routine.
+ */
+void *readStage(void *argument) {
+	struct pipeline *pipeline = argument;
+	struct sourceline line; /* Every source line. */
+
+	do {
+		line.length = -1; /* The length is set only for lines that are too long. */
+		line.status = extractSourceLine(pipeline->file, line.text, &line.length);
+		pushQueue(pipeline->lines, &line);
+	} while (line.status != EndFileFlag);
+
+	return NULL;
+}
+
+/**
+ * The parsing stage of the pipeline, parses the source lines from the
+ * lines queue into the instructions queue. Data instructors are copied
+ * into the data segment on the way.
+ * Used as a thread routine.
+ */
+void *parseStage(void *argument) {
+	const char assembledLineSize = 4; /* The size for the bit field in the output file. */
+	struct pipeline *pipeline = argument;
+	struct sourceline line; /* Every source line. */
+	struct instruction instruction; /* Every parsed code line. */
+
+	do {
+		popQueue(pipeline->lines, &line);
+		if (parseLine(pipeline->state, line.text, &instruction) == OperatorFlag) {
+			pushQueue(pipeline->instructions, &instruction);
+			pipeline->state->address += assembledLineSize; /* Every line takes exactly 4 bytes. */
+		}
+	} while (line.status != EndFileFlag);
+
+	instruction.isLast = 1; /* Telling the next stage that it is done. */
+	pushQueue(pipeline->instructions, &instruction);
+	return NULL;
+}
+
+/**
+ * The encoding stage of the pipeline, encodes the code lines from the
+ * instructions queue into the words queue.
+ * Used as a thread routine.
+ */
+void *encodeStage(void *argument) {
+	struct pipeline *pipeline = argument;
+	struct instruction instruction; /* Every parsed code line. */
+	struct encoded word; /* Every encoded line. */
+
+	for (popQueue(pipeline->instructions, &instruction); !instruction.isLast; popQueue(pipeline->instructions, &instruction)) {
+		word.address = instruction.address;
+		word.data = encodeInstruction(&instruction);
+		word.label = instruction.label;
+		word.isLast = 0;
+		pushQueue(pipeline->words, &word);
 	}
 
-	if ((word = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
-		(symbol = malloc(MAX_LABEL_SIZE + 1)) == NULL || /* +1 for a terminating character. */
-		(str = malloc(SOURCE_LINE_LENGTH)) == NULL || /* An asciz string cannot be longer than that. */
-		(args = calloc(sizeof(long int) ,(SOURCE_LINE_LENGTH / 2) + 1)) == NULL) /* A line of db or dh or dw will never have more arguments than that. */
-	errFatal(); /* Cannot continue without memory. */
-
-	fprintf(outputObj, "     %ld %ld\n", ic, dc);
-
-	while (!shouldStop) {
-		index = 0; /* The line start at index 0. */
-		rs = rt = rd = 0; /* Avoid problems in functions that use registers. */
-
-		if ((status = extractSourceLine(file, sourceLine, &lengthCheck)) == EndFileFlag)
-			shouldStop = 1; /* This is the last line in the source file. */
-
-		if ((status = getWord(sourceLine, &expecting, &index, word)) == LabelFlag) { /* Extracting the beginning of the line. */
-			status = getWord(sourceLine, &expecting, &index, word); /* Extracting again if it was a label. */
-		} else if (status == CommentLineFlag || (status == OperatorFlag && expecting == ExpectWord))
-			continue; /* Skipping a comment line or an empty line. */
-
-		if (status == OperatorFlag) {
-			operator = searchOperatorByString(word); /* Getting the operator. */
-			if (getType(operator) == R) { /* Handling R type operators. */
-				if (getOpcode(operator))
-					/* Extracting 2 operands. */
-					getRParam(sourceLine, &expecting, R2, &index, &rs, &rt, &rd);
-				else
-					/* Extracting 3 operands. */
-					getRParam(sourceLine, &expecting, R3, &index, &rs, &rt, &rd);
-				assembleR(outputObj, address, operator, rs, rt, rd); /* Assembling the line. */
-			} else if (getType(operator) == I) { /* Handling I type operators. */
-				/* Extracting the data from the line as operand set for I operators. */
-				status = getIParam(sourceLine, &expecting, &index, &rs, &rt, &immed, &isLabeledArgSet, symbol);
-				if (isLabeledArgSet) { /* If one of the operands is a label. */
-					label = searchLabel(symboltable, symbol); /* Extracting the label. */
-					immed = getAddress(label) - address; /* Calculating the difference into the immediate field. */
-				} /* If there was no label no special treatment is required. */
-				assembleI(outputObj, address, operator, rs, rt, immed); /* Assembling the line. */
-			} else if (strcmp(word, stopOperator) == 0) { /* Special case, the "stop" keyword. */
-				assembleJ(outputObj, address, operator, 0, 0); /* The "stop" keyword takes no operands. */
-			} else { /* The remaining operators must be of type J. */
-				/* Extracting the data from the line. */
-				status = getJParam(sourceLine, &expecting, &index, &rs, &isLabeledArgSet, symbol);
-				if (isLabeledArgSet) { /* If the operand is a label. */
-					label = searchLabel(symboltable, symbol); /* Extracting the label from the symbol table. */
-					if (hasAttribute(label, EntryLabel) == SUCCESS) { /* This may be an entry label. */
-						if (outputEnt == NULL) { /* If that file was not created yet then it would be created. */
-							outputEnt = fopen(entFileName, "w+"); /* Creating\recreating the output file. */
-							if (outputEnt == NULL)
-								errFatal(); /* should not happen but, just in case. */
-						}
-						writePlain(outputEnt, getSymbol(label), getAddress(label)); /* Writing to the entry file. */
-					} else if (hasAttribute(label, ExternLabel) == SUCCESS) {
-						if (outputExt == NULL) { /* If that file was not created yet then it would be created. */
-							outputExt = fopen(extFileName, "w+"); /* Creating\recreating the output file. */
-							if (outputExt == NULL)
-								errFatal(); /* should not happen but, just in case. */
-						}
-						writePlain(outputExt, getSymbol(label), address); /* Writing to the extern file. */
-					}
-					assembleJ(outputObj, address, operator, 0, getAddress(label)); /* Assembling the line with a label. */
-				} else
-					assembleJ(outputObj, address, operator, 1, rs); /* Assembling the line with a register. */
-			}
-			address += assembledLineSize; /* Updating the code address tracker, every line takes exactly 4 bytes. */
-		} else { /* At this point the line can only be a data instruction line. */
-			instructor = searchInstructorByString(word); /* Getting the instructor. */
-			expecting = getExpectation(instructor); /* To know what should be the next part of the line. */
-			if (expecting == ExpectString) {
-				status = getAscizParam(sourceLine, &expecting, &index, str); /* Extracting the string. */
-				assembleAsciz(dataSegment, str, &dataSegmentIndex); /* Copying the string to the data segment, it will be added to the output file at the end. */
-			} else if (expecting == Expect8BitParams || expecting == Expect16BitParams || expecting == Expect32BitParams) { /* The instructor is db, dh, or dw. */
-				count = 0; /* Initializing the argument counting variable. */
-				sizeExpectation = expecting; /* Keeping that expectation for the assembling part since getDataParam will modify it. */
-				getDataParam(sourceLine, &expecting, &index, &count, args); /* Extracting the arguments. */
-				assembleData(dataSegment, &dataSegmentIndex, sizeExpectation, count, args); /* Copying the argument to the data segment. */
-			}
+	word.isLast = 1; /* Telling the last stage that it is done. */
+	pushQueue(pipeline->words, &word);
+	return NULL;
+}
+
+/**
+ * Keeps the given encoded code line at the current address of the given
+ * second pass state.
+ */
+void emitCode(ConvertState *state, Word data) {
+	state->codeSegment[state->codeCount++] = data;
+}
+
+/**
+ * Keeps a reference to the given external label, made by the code line
+ * at the current address of the given second pass state.
+ */
+void emitReference(ConvertState *state, Label label) {
+	struct reference *reference; /* The kept reference. */
+
+	if (state->referenceCount == state->referenceCapacity) { /* Making room for the reference. */
+		state->referenceCapacity = state->referenceCapacity ? state->referenceCapacity * 2 : INITIAL_REFERENCES;
+		if ((reference = realloc(state->references, state->referenceCapacity * sizeof(struct reference))) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		state->references = reference;
+	}
+	reference = state->references + state->referenceCount++;
+	reference->label = label;
+	reference->address = state->address;
+}
+
+/**
+ * Writes the code lines kept in the given second pass state that were
+ * not written yet into its output files, in every format they take,
+ * unless the object file is filled in place. The external label
+ * references made by those code lines are written into the externals
+ * file unless they are written grouped by label. The externals file is
+ * created on the first reference. Called as the code segment grows and
+ * once more when the outputs are closed.
+ */
+void writeCodeSegment(ConvertState *state) {
+	const char assembledLineSize = 4; /* The size for the bit field in the output file. */
+	unsigned long int index; /* To loop trough the code lines. */
+	struct reference *reference = state->references + state->referencesWritten; /* Every reference that was not written. */
+	struct reference *end = state->references + state->referenceCount; /* The end of the references. */
+
+	if (state->obWriter != NULL)
+		writeHexCode(state->obWriter, state->codeSegment + state->codeWritten, state->codeCount - state->codeWritten, MEMORY_START_ADDRESS + state->codeWritten * assembledLineSize);
+	for (index = state->codeWritten; index < state->codeCount; index++) {
+		if (state->binObject != NULL)
+			writeBinaryCode(state->binObject, state->codeSegment[index]);
+		if (state->elfObject != NULL)
+			writeElfCode(state->elfObject, state->codeSegment[index]);
+	}
+
+	for (; reference < end; reference++) {
+		if (state->binObject != NULL)
+			addBinaryExtern(state->binObject, reference->label, reference->address);
+		if (state->elfObject != NULL)
+			addElfRelocation(state->elfObject, reference->label, reference->address);
+		if (state->isGroupedExt)
+			continue; /* Written when the outputs are closed. */
+		if (state->outputExt == NULL) { /* If that file was not created yet then it would be created. */
+			state->outputExt = fopen(state->extFileName, "w+"); /* Creating\recreating the output file. */
+			if (state->outputExt == NULL)
+				errFatal(); /* should not happen but, just in case. */
 		}
+		writePlain(state->outputExt, getSymbol(state->symbolTable, reference->label), reference->address);
 	}
 
-	writeDataSegment(outputObj, dc, dataSegment, address); /* Writing the data segment to the output file. */
+	state->codeWritten = state->codeCount;
+	state->referencesWritten = state->referenceCount;
+}
 
-	/* Freeing memory. */
-	free(obFileName);
-	free(entFileName);
-	free(extFileName);
-	free(dataSegment);
-	free(word);
-	free(symbol);
-	free(str);
-	free(args);
-	/* Closing used file streams. */
-	fclose(outputObj);
-	if (outputEnt != NULL)
-		fclose(outputEnt);
-	if (outputExt != NULL)
-		fclose(outputExt);
+/**
+ * Writes every entry label of the symbol table of the given second pass
+ * state into the entries file, once, sorted by their addresses. The file
+ * is created only if there are entry labels.
+ */
+void writeEntries(ConvertState *state) {
+	SymbolTable *symbolTable = state->symbolTable;
+	struct entry *entries; /* The entry labels. */
+	unsigned long int count = 0, index; /* The number of entry labels. */
+	Label label; /* To loop trough the labels. */
+	FILE *output; /* The entries file. */
+
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label))
+		if (hasAttribute(symbolTable, label, EntryLabel) == SUCCESS)
+			count++;
+	if (count == 0)
+		return; /* No entries file should be created. */
+
+	if ((entries = malloc(count * sizeof(struct entry))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	for (label = getFirst(symbolTable), index = 0; label != NO_LABEL; label = getNext(symbolTable, label)) {
+		if (hasAttribute(symbolTable, label, EntryLabel) == SUCCESS) {
+			entries[index].address = getAddress(symbolTable, label);
+			entries[index++].label = label;
+		}
+	}
+	qsort(entries, count, sizeof(struct entry), compareEntries);
+
+	if ((output = fopen(state->entFileName, "w+")) == NULL) /* Creating\recreating the output file. */
+		errFatal(); /* should not happen but, just in case. */
+	for (index = 0; index < count; index++)
+		writePlain(output, getSymbol(symbolTable, entries[index].label), entries[index].address);
+	fclose(output);
+	free(entries);
+}
+
+/**
+ * Writes the external label references kept in the given second pass
+ * state into the externals file, a single line for every external label
+ * that is used: the symbol, the number of uses, the address of the first
+ * use and then the distance of every other use from the one before it.
+ */
+void writeGroupedExterns(ConvertState *state) {
+	struct reference *reference = state->references; /* Every reference. */
+	struct reference *end = state->references + state->referenceCount; /* The end of the references. */
+	struct reference *group; /* The first reference of every label. */
+
+	if (state->referenceCount == 0)
+		return; /* No externals file should be created. */
+	qsort(state->references, state->referenceCount, sizeof(struct reference), compareReferences);
+
+	if ((state->outputExt = fopen(state->extFileName, "w+")) == NULL) /* Creating\recreating the output file. */
+		errFatal(); /* should not happen but, just in case. */
+	while (reference < end) {
+		for (group = reference; reference < end && reference->label == group->label; reference++)
+			; /* Finding the end of the group. */
+		fprintf(state->outputExt, "%s %ld %04ld", getSymbol(state->symbolTable, group->label), (long int)(reference - group), group->address);
+		for (group++; group < reference; group++)
+			fprintf(state->outputExt, " %ld", group->address - group[-1].address);
+		fputc('\n', state->outputExt);
+	}
+}
+
+/**
+ * Creates the object file of the given second pass state at its final
+ * size, for its code segment and its data segment of the given size,
+ * and fills it in place trough a mapping of the file into memory.
+ */
+void fillObject(ConvertState *state, const unsigned long int dc) {
+	const unsigned long int ic = state->address - MEMORY_START_ADDRESS; /* The size of the code segment. */
+	unsigned long int size = getHexObjectSize(ic, dc, MEMORY_START_ADDRESS); /* Every line has a known width. */
+	char *object = mapFile(state->outputObj, size);
+
+	if (object == NULL)
+		errFatal(); /* should not happen but, just in case. */
+	fillHexObject(object, state->codeSegment, state->dataSegment, ic, dc, MEMORY_START_ADDRESS, state->inPlaceJobs);
+	unmapFile(object, size);
+}
+
+/**
+ * Compares two label references by their labels in the order of the
+ * symbol table, and the references to the same label by their addresses.
+ * Used for sorting.
+ */
+int compareReferences(const void *first, const void *second) {
+	const struct reference *firstReference = first, *secondReference = second;
+
+	if (firstReference->label != secondReference->label)
+		return firstReference->label < secondReference->label ? -1 : 1;
+	return firstReference->address < secondReference->address ? -1 : firstReference->address > secondReference->address;
 }
 
 /**
- * Extracts the file name without the extension from the first parameter and
- * assigns that name as a string into the last three parameters, as well as
- * assigning them their own extensions: .ob .ent .ext respectively.
- * This function modifies the last three buffers.
+ * Compares two entries by their addresses, entries with the same address
+ * keep the order of the symbol table. Used for sorting.
+ */
+int compareEntries(const void *first, const void *second) {
+	const struct entry *firstEntry = first, *secondEntry = second;
+
+	if (firstEntry->address != secondEntry->address)
+		return firstEntry->address < secondEntry->address ? -1 : 1;
+	return firstEntry->label < secondEntry->label ? -1 : firstEntry->label > secondEntry->label;
+}
+
+/**
+ * Adds the code lines and the label references kept in the chunk state
+ * on the second parameter into the given state, in the order they were
+ * encoded. The address of the given state is advanced past the code of
+ * the chunk.
+ */
+void writeConvertState(ConvertState *state, ConvertState *chunk) {
+	unsigned long int index, reference = 0; /* To loop trough the code lines and the references. */
+
+	for (index = 0; index < chunk->codeCount; index++) {
+		/* Writing the references made by the code line before the code line, as it would on a single thread. */
+		for (; reference < chunk->referenceCount && chunk->references[reference].address == state->address; reference++)
+			emitReference(state, chunk->references[reference].label);
+		addCode(state, chunk->codeSegment[index], NO_LABEL);
+	}
+}
+
+/**
+ * Returns the index in the data segment that the given second pass state
+ * assembles the next data instructor into.
+ */
+unsigned long int getDataIndex(ConvertState *state) {
+	return state->dataSegmentIndex;
+}
+
+/**
+ * Moves the given second pass state to the given address and the given
+ * index in its data segment.
+ */
+void moveConvertState(ConvertState *state, unsigned long int address, unsigned long int dataIndex) {
+	state->address = address;
+	state->dataSegmentIndex = dataIndex;
+}
+
+/**
+ * Frees all the memory used by the given second pass state.
+ * The symbol table, the data segment and the output files are not
+ * owned by the state.
+ */
+void freeConvertState(ConvertState *state) {
+	free(state->word);
+	free(state->symbol);
+	free(state->str);
+	free(state->args);
+	free(state->codeSegment);
+	free(state->references);
+	free(state);
+}
+
+/**
+ * Returns a new string of the name of the given source file with its
+ * extension replaced by the given extension.
  * This is a private utility function for the convert function.
  */
-void extractOutputFileNames(const char *sourceFileName, char *obFileName, char *entFileName, char *extFileName) {
-	const char nullTermination = '\0'; /* Null terminating character, used for string handling. */
-	char *srcFileName; /* To contain the source file name without the extension. */
-	int sourceFileNameLen = strlen(sourceFileName); /* Used in multiple locations. */
+char *outputFileName(const char *sourceFileName, const char *extension) {
+	const size_t nameLength = strlen(sourceFileName) - FILE_EXTENSION_LEN; /* The length of the name without the extension. */
+	char *outputName; /* The result. */
 
-	/* Allocating memory for the extension-less file name buffer. */
-	if ((srcFileName = malloc(sourceFileNameLen - FILE_EXTENSION_LEN)) == NULL)
+	if ((outputName = malloc(nameLength + strlen(extension) + 1)) == NULL) /* +1 for a terminating character. */
 		errFatal(); /* Cannot continue without memory. */
+	memcpy(outputName, sourceFileName, nameLength);
+	strcpy(outputName + nameLength, extension);
+
+	return outputName;
+}
 
-	/* Extracting the source file's name without the extension into srcFileName. */
-	subString(srcFileName, sourceFileName, 0, sourceFileNameLen - FILE_EXTENSION_LEN - 1);
-	srcFileName[sourceFileNameLen - FILE_EXTENSION_LEN] = nullTermination; /* Avoiding issues with strcat. */
-
-	/* Assigning a terminating character at the beginning of each buffer before using strcat. */
-	obFileName[0] = nullTermination;
-	entFileName[0] = nullTermination;
-	extFileName[0] = nullTermination;
-
-	/* Copying the name of the file without the extension into the buffers. */
-	strcat(obFileName, srcFileName);
-	strcat(entFileName, srcFileName);
-	strcat(extFileName, srcFileName);
-
-	/* Assigning the right extension for every output file name. */
-	strcat(obFileName, OUTPUT_OB_EXTENTION);
-	strcat(entFileName, OUTPUT_ENT_EXTENTION);
-	strcat(extFileName, OUTPUT_EXT_EXTENTION);
-
-	/* Freeing memory */
-	free(srcFileName);
-}
-
-/**
- * Assembles the given data into the given stream.
- * This function writes the opcode of the given R operator then the
- * given registers and then the funct value of that operator as a
- * bit field into the given stream, in 8 bit sections separated with
- * spaces with the given address at the beginning of the line and
- * a new line character at the end of the line.
- * Expects the given register values to not be larger than 5 bits as
- * well as the funct value of the given operator, also the opcode of
- * the given operator should not require more than 6 bits.
- */
-void assembleR(FILE *output, unsigned long int address, Operator *operator, char rs, char rt, char rd) {
-	const char unusedBits = 6; /* The size of the unused part in the bit field. */
-	const char registerDiffBits = 5; /* The size of the registers in the bit field. */
-	const char bitSectionSize = 8; /* The size of every section in the bit field. */
-	unsigned long int data = 0; /* The bit field. */
-	unsigned char bitSection; /* To hold divided sections from the bit field. */
-
-	data += getOpcode(operator); /* Inserting the opcode into the bit field. */
-	data <<= registerDiffBits; /* Shifting the field 5 bits. */
-	data += rs; /* Inserting the first register into the bit field. */
-	data <<= registerDiffBits; /* Shifting the field 5 bits. */
-	data += rt; /* Inserting the second register into the bit field. */
-	data <<= registerDiffBits; /* Shifting the field 5 bits. */
-	data += rd; /* Inserting the third register into the bit field. */
-	data <<= registerDiffBits; /* Shifting the field 5 bits. */
-	data += getFunct(operator); /* Inserting the funct value into the bit field. */
-	data <<= unusedBits; /* Shifting the field 6 bits. */
-
-	/* Writing the memory address into the output file. */
-	fprintf(output, "%04ld ", address);
-
-	/* The size of the bit field is (at least) 32 bits. */
-	bitSection = data; /* Extracting the first 8 bits from the bit field */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the next 8 bits. */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the next 8 bits. */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the last 8 bits. */
-	fprintf(output, "%02X\n", bitSection); /* Writing them into the output file in hexadecimal format. */
-}
-
-/**
- * Assembles the given data into the given stream.
- * This function writes the opcode of the given I operator then the
- * given registers and lastly the immediate value as a bit field
- * into the given stream. The bit field is written between the
- * given address and a new line character and is divided into 8 bit
- * sections separated by spaces.
- * Expects the given register values to not require more than 5
- * bits.
- */
-void assembleI(FILE *output, unsigned long int address, Operator *operator, char rs, char rt, short immed) {
-	const char registerDiffBits = 5; /* The size of the registers in the bit field. */
-	const char immediateDiffBits = 16; /* The size of the immediate value in the bit field. */
-	const char bitSectionSize = 8; /* The size of every section in the bit field. */
-	unsigned long int data = 0; /* The bit field. */
-	unsigned char bitSection; /* To hold divided sections from the bit field. */
-
-	data += getOpcode(operator); /* Inserting the opcode into the bit field. */
-	data <<= registerDiffBits; /* Shifting the field 5 bits. */
-	data += rs; /* Inserting the first register into the bit field. */
-	data <<= registerDiffBits; /* Shifting the field 5 bits. */
-	data += rt; /* Inserting the second register into the bit field. */
-	data <<= immediateDiffBits; /* Shifting the field 16 bits. */
-	data += ((unsigned short)immed); /* Inserting the immediate value into the bit field. */
-
-	/* Writing the memory address into the output file. */
-	fprintf(output, "%04ld ", address);
-
-	/* The size of the bit field is (at least) 32 bits. */
-	bitSection = data; /* Extracting the first 8 bits from the bit field */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the next 8 bits. */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the next 8 bits. */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the last 8 bits. */
-	fprintf(output, "%02X\n", bitSection); /* Writing them into the output file in hexadecimal format. */
-}
-
-void assembleJ(FILE *output, unsigned long int address, Operator *operator, char isRegister, unsigned long int addressValue) {
-	const char addressDiffBits = 25; /* The size of the address in the bit field. */
-	const char bitSectionSize = 8; /* The size of every section in the bit field. */
-	unsigned long int data = 0; /* The bit field. */
-	unsigned char bitSection; /* To hold divided sections from the bit field. */
-
-	data += getOpcode(operator); /* Inserting the opcode into the bit field. */
-	data <<= 1; /* Shifting the bit field 1 bit for the isRegister parameter. */
-	data += isRegister; /* Inserting the isRegister parameter into the bit field. */
-	data <<= addressDiffBits; /* Shifting the bit field 24 bit to the left for the address value. */
-	data += addressValue; /* Inserting the address value. */
-
-	/* Writing the memory address into the output file. */
-	fprintf(output, "%04ld ", address);
-
-	/* The size of the bit field is (at least) 32 bits. */
-	bitSection = data; /* Extracting the first 8 bits from the bit field */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the next 8 bits. */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the next 8 bits. */
-	fprintf(output, "%02X ", bitSection); /* Writing them into the output file in hexadecimal format. */
-	data >>= bitSectionSize; /* Shifting the field 8 bits to the right. */
-	bitSection = data; /* Then extracting the last 8 bits. */
-	fprintf(output, "%02X\n", bitSection); /* Writing them into the output file in hexadecimal format. */
+/**
+ * Encodes the given data into a bit field and returns it.
+ * This function places the opcode of the given R operator then the
+ * given registers and then the funct value of that operator into
+ * the bit field, as laid out in isa.def.
+ */
+Word encodeR(const Operator *operator, char rs, char rt, char rd) {
+	return ENCODE_R(getOpcode(operator), rs, rt, rd, getFunct(operator));
+}
+
+/**
+ * Encodes the given data into a bit field and returns it.
+ * This function places the opcode of the given I operator then the
+ * given registers and lastly the immediate value into the bit field,
+ * as laid out in isa.def.
+ */
+Word encodeI(const Operator *operator, char rs, char rt, short immed) {
+	return ENCODE_I(getOpcode(operator), rs, rt, (unsigned short)immed);
+}
+
+/**
+ * Encodes the given data into a bit field and returns it.
+ * This function places the opcode of the given J operator then the
+ * register flag and lastly the address value (or register) into the
+ * bit field, as laid out in isa.def.
+ */
+Word encodeJ(const Operator *operator, char isRegister, unsigned long int addressValue) {
+	return ENCODE_J(getOpcode(operator), isRegister, addressValue);
+}
+
+/**
+ * Replaces the label operand in the given bit field with the given label
+ * address and returns the result. If the operand is relative the
+ * immediate value of an I operator is replaced with the difference
+ * between the label address and the address of the line, otherwise the
+ * address value of a J operator is replaced with the label address.
+ */
+unsigned long int relocateOperand(unsigned long int data, unsigned long int labelAddress, unsigned long int address, char isRelative) {
+	const unsigned long int immediateMask = I_IMMED_MASK << I_IMMED_SHIFT; /* The immediate value part of an I bit field. */
+	const unsigned long int addressMask = J_ADDRESS_MASK << J_ADDRESS_SHIFT; /* The address value part of a J bit field. */
+
+	if (isRelative)
+		return (data & ~immediateMask) + ((unsigned short)(short)(labelAddress - address)); /* Just like encodeI calculates it. */
+	return (data & ~addressMask) + labelAddress;
 }
 
 /**
@@ -756,26 +1808,3 @@ void writePlain(FILE *output, char *symbol, unsigned long int address) {
 	fprintf(output, "%s %04ld\n", symbol, address);
 }
 
-
-
-/**
- * Writes the given data segment to the given output stream.
- */
-void writeDataSegment(FILE *output ,const unsigned long int dc, char *dataSegment, unsigned long int address) {
-	const char assembledLineSize = 4; /* The size for the bit field in the output file. */
-	int index = 0; /* Starting from the beginning of the data segment. */
-
-	if (dc == 0)
-		return; /* If the data segment is empty then there is nothing to write. */
-
-	fprintf(output, "%04ld", address); /* Writing the address for the first line in the loop. */
-	/* Copying all the data segment into the output file. */
-	while (index < dc) {
-		/* Writing every character in hexadecimal format. */
-		fprintf(output, " %02X", ((unsigned char)dataSegment[index++]));
-		address++; /* Incrementing the total address. */
-		if (address % assembledLineSize == 0) 
-			/* Every 4 bytes, printing the address in decimal format. */
-			fprintf(output, "\n%04ld", address);
-	}
-}
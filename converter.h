@@ -1,10 +1,194 @@
 #ifndef CONVERTER_H
 #define CONVERTER_H
 
+#include <stdio.h>
+
+#include "options.h"
+#include "symboltable.h"
+#include "exports.h"
+#include "utils.h"
+
 /**
  * An header file for the converter translation unit.
  */
 
-void assemble(FILE *file, const char *fileName);
+#define MAX_LABEL_SIZE 31 /* The maximum number of characters allowed in a symbol. */
+#define MEMORY_START_ADDRESS 100 /* The memory address from which the program should be loaded. */
+
+/**
+ * Defining the first pass state data structure.
+ * This structure holds everything the first pass tracks between the
+ * lines of a source file: the symbol table, the counters and the code
+ * that tells if output files should be created.
+ */
+typedef struct mapstate MapState;
+
+/**
+ * Defining the second pass state data structure.
+ * This structure holds everything the second pass tracks between the
+ * lines of a source file. The encoded code lines and the label
+ * references are kept in the state, a state with output files writes
+ * them once the whole code segment was encoded, or a batch at a time
+ * as they are encoded by the pipeline.
+ */
+typedef struct convertstate ConvertState;
+
+/**
+ * Takes in an assembly source file as a stream and assembles
+ * it after checking if it has any issues, using the given
+ * options. If the exports parameter is not null the entry and
+ * external labels of the file are published into it.
+ * Returns SUCCESS if the file has no issues and ERROR otherwise.
+ */
+Code assemble(FILE *file, const char *fileName, Options *options, Exports *exports);
+
+/**
+ * Creates a new first pass state for the given source file.
+ * If the second parameter is null the state owns an empty symbol table
+ * and its instruction counter starts at the memory start address.
+ * Otherwise the state defers its label actions, its counters start at
+ * zero and every message printed while mapping into it is expected to
+ * be written into the given stream.
+ * Returns a pointer to the new state or a null pointer if the memory
+ * allocation had failed.
+ */
+MapState *createMapState(const char *fileName, FILE *deferredMessages);
+
+/**
+ * Maps the source lines of the given stream, starting from its current
+ * position, into the given first pass state. The first line is given
+ * the line number on the fourth parameter. If the last parameter is
+ * zero the stream is mapped until its end, otherwise only that number
+ * of lines are mapped.
+ * Expects the third parameter to be a buffer SOURCE_LINE_LENGTH + 1 long.
+ */
+void mapLines(MapState *state, FILE *file, char *sourceLine, unsigned long int firstLine, unsigned long int lineCount);
+
+/**
+ * Maps a single source line into the given first pass state, using the
+ * results of the extractSourceLine function on the last two parameters.
+ * While deferring, the end of a line that recorded label actions is
+ * recorded as well so that a failed action can skip the rest of its
+ * line when replayed.
+ */
+void mapLine(MapState *state, char *sourceLine, unsigned long int lineNum, int length, Flag status);
+
+/**
+ * Replays the deferred label actions of the chunk state on the second
+ * parameter into the given state, in the order they were recorded, while
+ * copying the messages of the chunk into the message stream in between.
+ * The code and data labels of the chunk are positioned after everything
+ * that was mapped into the given state so far.
+ */
+void replayMapState(MapState *state, MapState *chunk);
+
+/**
+ * Checks if the given first pass state had as many errors as its limit.
+ * Returns SUCCESS if it had and ERROR otherwise.
+ */
+Code isErrorLimitReached(MapState *state);
+
+/**
+ * Returns the instruction counter of the given first pass state.
+ */
+unsigned long int getInstructionCounter(MapState *state);
+
+/**
+ * Returns the data counter of the given first pass state.
+ */
+unsigned long int getDataCounter(MapState *state);
+
+/**
+ * Frees all the memory used by the given first pass state, its symbol
+ * table included.
+ */
+void freeMapState(MapState *state);
+
+/**
+ * Creates a new second pass state that encodes the code lines starting
+ * from the given address, and assembles data instructors into the given
+ * data segment starting from the given index.
+ * The encoded code lines and the external label references
+ * are kept in the state, the last parameter is the size of the code
+ * they take (in bytes).
+ * Returns a pointer to the new state or a null pointer if the memory
+ * allocation had failed.
+ */
+ConvertState *createConvertState(SymbolTable *symbolTable, char *dataSegment, unsigned long int address, unsigned long int dataIndex, unsigned long int codeSize);
+
+/**
+ * Assembles the source lines of the given stream, starting from its
+ * current position, into the given second pass state. If the last
+ * parameter is zero the stream is assembled until its end, otherwise
+ * only that number of lines are assembled.
+ * Expects the third parameter to be a buffer SOURCE_LINE_LENGTH + 1 long.
+ */
+void convertLines(ConvertState *state, FILE *file, char *sourceLine, unsigned long int lineCount);
+
+/**
+ * Assembles the given source line at the address of the given second
+ * pass state, just like convertLine, but hands the result back instead
+ * of writing it. Data instructors are copied into the data segment of
+ * the state and the address of the state is not updated.
+ * Returns OperatorFlag for a code line, in that case the bit field is
+ * set into the third parameter, the label operand of the line (or
+ * NO_LABEL) into the fourth and the last parameter tells if the operand
+ * is relative to the address of the line. Returns IllegalSymbolFlag for
+ * a code line with a label operand that is not in the symbol table and
+ * NoIssueFlag for any other line.
+ */
+Flag encodeLine(ConvertState *state, char *sourceLine, unsigned long int *data, Label *operand, char *isRelative);
+
+/**
+ * Adds the given encoded code line at the current address of the given
+ * second pass state, along with a reference to the given external label
+ * if it is not NO_LABEL, and advances the address.
+ */
+void addCode(ConvertState *state, Word data, Label label);
+
+/**
+ * Replaces the label operand in the given bit field with the given label
+ * address and returns the result. If the operand is relative the
+ * immediate value of an I operator is replaced with the difference
+ * between the label address and the address of the line, otherwise the
+ * address value of a J operator is replaced with the label address.
+ */
+unsigned long int relocateOperand(unsigned long int data, unsigned long int labelAddress, unsigned long int address, char isRelative);
+
+/**
+ * Returns the index in the data segment that the given second pass state
+ * assembles the next data instructor into.
+ */
+unsigned long int getDataIndex(ConvertState *state);
+
+/**
+ * Moves the given second pass state to the given address and the given
+ * index in its data segment.
+ */
+void moveConvertState(ConvertState *state, unsigned long int address, unsigned long int dataIndex);
+
+/**
+ * Writes the output files of the given source file from the code lines
+ * and label references kept in the given second pass state, and the
+ * given data segment. The ic and dc parameters are expected to equal
+ * the size of the code segment and the size of the data segment
+ * respectively. The given options choose the format of the output files.
+ */
+void writeAssembled(const char *fileName, ConvertState *assembled, char *dataSegment, const unsigned long int ic, const unsigned long int dc, Options *options);
+
+/**
+ * Adds the code lines and the label references kept in the chunk state
+ * on the second parameter into the given state, in the order they were
+ * encoded. The address of the given state is advanced past the code of
+ * the chunk.
+ */
+void writeConvertState(ConvertState *state, ConvertState *chunk);
+
+/**
+ * Frees all the memory used by the given second pass state.
+ * The symbol table, the data segment and the output files are not
+ * owned by the state.
+ */
+void freeConvertState(ConvertState *state);
 
 #endif
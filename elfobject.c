@@ -0,0 +1,382 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elfobject.h"
+#include "symboltable.h"
+#include "converter.h"
+#include "keywords.h"
+#include "errmsg.h"
+#include "utils.h"
+
+/**
+ * The ELF object translation unit writes the optional ELF relocatable
+ * object file, the same program as the object, entries and externals
+ * files in the format other linkers and tools read.
+ */
+
+#define INITIAL_RELOCATIONS 64 /* The initial capacity of the relocations array. */
+#define WORD_SIZE 4 /* The size of every code word (in bytes), the alignment of the tables. */
+#define ELF_IDENT_SIZE 16 /* The size of the identification part of the ELF header (in bytes). */
+#define ELF_HEADER_SIZE 52 /* The size of the ELF header (in bytes). */
+#define ELF_SECTION_HEADER_SIZE 40 /* The size of every section header (in bytes). */
+#define ELF_SYMBOL_SIZE 16 /* The size of every symbol (in bytes). */
+#define ELF_RELOCATION_SIZE 8 /* The size of every relocation (in bytes). */
+#define ELF_CLASS_32 1 /* 32 bit objects. */
+#define ELF_DATA_LSB 1 /* Little endian objects. */
+#define ELF_VERSION 1 /* The current version. */
+#define ELF_TYPE_REL 1 /* A relocatable object file. */
+#define ELF_MACHINE_NONE 0 /* The machine has no assigned number. */
+#define SECTION_PROGBITS 1 /* A section of program bytes. */
+#define SECTION_SYMTAB 2 /* A symbol table section. */
+#define SECTION_STRTAB 3 /* A string table section. */
+#define SECTION_REL 9 /* A relocations section without addends. */
+#define SECTION_WRITE 0x1 /* The section is writable. */
+#define SECTION_ALLOC 0x2 /* The section takes memory when the program runs. */
+#define SECTION_EXECINSTR 0x4 /* The section holds instructions. */
+#define SECTION_INFO_LINK 0x40 /* The info field of the section header is a section index. */
+#define SYMBOL_LOCAL 0 /* A local symbol binding. */
+#define SYMBOL_GLOBAL 1 /* A global symbol binding. */
+#define SYMBOL_NOTYPE 0 /* A symbol without a type. */
+#define SYMBOL_SECTION 3 /* A symbol of a section. */
+#define SYMBOL_INFO(binding, type) (((binding) << 4) + (type)) /* The info field of a symbol. */
+#define RELOCATION_J_ADDRESS 1 /* The address value of a J bit field is set to the symbol value. */
+#define RELOCATION_INFO(symbol, type) (((symbol) << 8) + (type)) /* The info field of a relocation. */
+#define SECTION_SYMBOLS 3 /* The symbols before the first global symbol: the null symbol and the symbols of the .text and .data sections. */
+
+/**
+ * The index of every section in the section headers table.
+ */
+typedef enum {
+	NullSection, /* The null section. */
+	TextSection, /* The code segment. */
+	DataSection, /* The data segment. */
+	SymtabSection, /* The symbol table. */
+	StrtabSection, /* The symbol names. */
+	RelSection, /* The relocations of the code segment. */
+	ShstrtabSection, /* The section names. */
+	SectionCount /* The number of sections. */
+} Section;
+
+/**
+ * The name of every section, by its index.
+ */
+static const char *sectionNames[SectionCount] = {"", ".text", ".data", ".symtab", ".strtab", ".rel.text", ".shstrtab"};
+
+/**
+ * Defining the ELF section data structure.
+ * The fields of a section header that are not fixed.
+ */
+struct elfsection {
+	unsigned long int type; /* The type of the section. */
+	unsigned long int flags; /* The attributes of the section. */
+	unsigned long int offset; /* The offset of the section in the file. */
+	unsigned long int size; /* The size of the section (in bytes). */
+	unsigned long int link; /* The section this one refers to. */
+	unsigned long int info; /* Extra information that depends on the type. */
+	unsigned long int align; /* The alignment of the section. */
+	unsigned long int entrySize; /* The size of every entry of a table section. */
+};
+
+/**
+ * Defining the ELF relocation data structure.
+ * A use of a label before it is written: of an external label, or of an
+ * internal label by the symbol of its section, the offset of the label
+ * in its section kept in the code word.
+ */
+struct elfrelocation {
+	unsigned long int address; /* The address of the code word that uses the label. */
+	Label label; /* The external label, NO_LABEL for an internal label. */
+	Section section; /* The section of an internal label, NullSection for an external label. */
+};
+
+/**
+ * Defining the ELF object data structure.
+ * Holds the stream of an ELF object file and the relocations until the
+ * tables are written.
+ */
+struct elfobject {
+	FILE *output; /* The ELF object file. */
+	unsigned long int ic, dc; /* The size of the code segment and the size of the data segment. */
+	unsigned long int address; /* The address of the next code word. */
+	char isJump[J_OPCODE_MASK + 1]; /* Whether every opcode is of a J operator. */
+	struct elfrelocation *relocations; /* The relocations in the order of use. */
+	unsigned long int relocationCount; /* The number of relocations. */
+	unsigned long int relocationCapacity; /* The capacity of the relocations array. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+void addRelocation(ElfObject *object, Label label, Section section, unsigned long int address);
+void writeElfHeader(ElfObject *object, unsigned long int sectionsOffset);
+void writeElfSymbol(FILE *output, unsigned long int name, unsigned long int value, unsigned char info, Section section);
+void writeElfSection(FILE *output, unsigned long int name, struct elfsection *section);
+unsigned long int alignElf(FILE *output, unsigned long int offset);
+
+/**
+ * Creates a new ELF object that writes into the given stream, which
+ * should not have been written yet, a program with the given size of
+ * the code segment and the given size of the data segment.
+ * Returns a pointer to the new ELF object or a null pointer if the
+ * memory allocation had failed.
+ */
+ElfObject *createElfObject(FILE *output, unsigned long int ic, unsigned long int dc) {
+	ElfObject *object = calloc(1, sizeof(ElfObject)); /* Every field starts empty. */
+	unsigned int index; /* To loop trough the operators. */
+
+	if (object == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	object->output = output;
+	object->ic = ic;
+	object->dc = dc;
+	object->address = MEMORY_START_ADDRESS;
+	for (index = 0; index < getOperatorCount(); index++)
+		if (getType(getOperator(index)) == J)
+			object->isJump[getOpcode(getOperator(index))] = 1;
+	writeElfHeader(object, 0); /* The section headers are written last. */
+
+	return object;
+}
+
+/**
+ * Writes the given bit field as the next word of the .text section.
+ * A J bit field that holds the address of an internal label gets the
+ * offset of the label in its section instead, and a relocation by the
+ * symbol of that section.
+ */
+void writeElfCode(ElfObject *object, unsigned long int data) {
+	const unsigned long int dataStart = MEMORY_START_ADDRESS + object->ic; /* The address of the data segment. */
+	unsigned long int address = (data >> J_ADDRESS_SHIFT) & J_ADDRESS_MASK; /* The address field, if it is a J bit field. */
+
+	/* Registers and the "stop" operator are not addresses, and neither is the zero address of an external label. */
+	if (object->isJump[(data >> J_OPCODE_SHIFT) & J_OPCODE_MASK] && !((data >> J_REG_SHIFT) & J_REG_MASK) && address != 0) {
+		data &= ~(J_ADDRESS_MASK << J_ADDRESS_SHIFT);
+		if (address < dataStart) {
+			data |= (address - MEMORY_START_ADDRESS) << J_ADDRESS_SHIFT;
+			addRelocation(object, NO_LABEL, TextSection, object->address);
+		} else {
+			data |= (address - dataStart) << J_ADDRESS_SHIFT;
+			addRelocation(object, NO_LABEL, DataSection, object->address);
+		}
+	}
+	writeWord(object->output, data);
+	object->address += WORD_SIZE;
+}
+
+/**
+ * Adds a relocation for the given external label, used by the code word
+ * at the given address.
+ */
+void addElfRelocation(ElfObject *object, Label label, unsigned long int address) {
+	addRelocation(object, label, NullSection, address);
+}
+
+/**
+ * Writes the given data segment, the symbol table made of the entry and
+ * external labels of the given symbol table, the relocations and the
+ * section headers after the .text section and completes the ELF header.
+ * Should be called once, after the whole code segment was written.
+ */
+void writeElfTables(ElfObject *object, SymbolTable *symbolTable, const char *dataSegment) {
+	FILE *output = object->output;
+	const unsigned long int dataStart = MEMORY_START_ADDRESS + object->ic; /* The address of the data segment. */
+	struct elfsection sections[SectionCount]; /* The section headers. */
+	unsigned long int *symbols; /* The symbol index of every external label. */
+	unsigned long int labelCount = 0, symbolCount = SECTION_SYMBOLS, name = 1, offset, index; /* The symbol names start after an empty string. */
+	Label label; /* To loop trough the labels. */
+
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label))
+		if (label > labelCount)
+			labelCount = label;
+	if ((symbols = calloc(labelCount + 1, sizeof(unsigned long int))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	memset(sections, 0, sizeof(sections));
+
+	sections[TextSection].type = SECTION_PROGBITS;
+	sections[TextSection].flags = SECTION_ALLOC | SECTION_EXECINSTR;
+	sections[TextSection].offset = ELF_HEADER_SIZE;
+	sections[TextSection].size = object->ic;
+	sections[TextSection].align = WORD_SIZE;
+
+	sections[DataSection].type = SECTION_PROGBITS;
+	sections[DataSection].flags = SECTION_ALLOC | SECTION_WRITE;
+	sections[DataSection].offset = ELF_HEADER_SIZE + object->ic;
+	sections[DataSection].size = object->dc;
+	sections[DataSection].align = 1;
+	fwrite(dataSegment, 1, object->dc, output);
+
+	/* The symbols, the entry labels and then the external labels, all of them global. */
+	sections[SymtabSection].type = SECTION_SYMTAB;
+	sections[SymtabSection].offset = alignElf(output, sections[DataSection].offset + object->dc);
+	sections[SymtabSection].link = StrtabSection;
+	sections[SymtabSection].info = SECTION_SYMBOLS; /* The first global symbol. */
+	sections[SymtabSection].align = WORD_SIZE;
+	sections[SymtabSection].entrySize = ELF_SYMBOL_SIZE;
+	writeElfSymbol(output, 0, 0, 0, NullSection);
+	writeElfSymbol(output, 0, 0, SYMBOL_INFO(SYMBOL_LOCAL, SYMBOL_SECTION), TextSection);
+	writeElfSymbol(output, 0, 0, SYMBOL_INFO(SYMBOL_LOCAL, SYMBOL_SECTION), DataSection);
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label)) {
+		if (hasAttribute(symbolTable, label, EntryLabel) == ERROR)
+			continue;
+		offset = getAddress(symbolTable, label);
+		if (offset < dataStart)
+			writeElfSymbol(output, name, offset - MEMORY_START_ADDRESS, SYMBOL_INFO(SYMBOL_GLOBAL, SYMBOL_NOTYPE), TextSection);
+		else
+			writeElfSymbol(output, name, offset - dataStart, SYMBOL_INFO(SYMBOL_GLOBAL, SYMBOL_NOTYPE), DataSection);
+		name += strlen(getSymbol(symbolTable, label)) + 1; /* +1 for a terminating character. */
+		symbolCount++;
+	}
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label)) {
+		if (hasAttribute(symbolTable, label, ExternLabel) == ERROR)
+			continue;
+		writeElfSymbol(output, name, 0, SYMBOL_INFO(SYMBOL_GLOBAL, SYMBOL_NOTYPE), NullSection); /* Undefined. */
+		name += strlen(getSymbol(symbolTable, label)) + 1; /* +1 for a terminating character. */
+		symbols[label] = symbolCount++;
+	}
+	sections[SymtabSection].size = symbolCount * ELF_SYMBOL_SIZE;
+
+	/* The symbol names, in the same order. */
+	sections[StrtabSection].type = SECTION_STRTAB;
+	sections[StrtabSection].offset = sections[SymtabSection].offset + sections[SymtabSection].size;
+	sections[StrtabSection].size = name;
+	sections[StrtabSection].align = 1;
+	fputc('\0', output); /* The empty string. */
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label))
+		if (hasAttribute(symbolTable, label, EntryLabel) == SUCCESS)
+			fwrite(getSymbol(symbolTable, label), 1, strlen(getSymbol(symbolTable, label)) + 1, output);
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label))
+		if (hasAttribute(symbolTable, label, ExternLabel) == SUCCESS)
+			fwrite(getSymbol(symbolTable, label), 1, strlen(getSymbol(symbolTable, label)) + 1, output);
+
+	sections[RelSection].type = SECTION_REL;
+	sections[RelSection].flags = SECTION_INFO_LINK;
+	sections[RelSection].offset = alignElf(output, sections[StrtabSection].offset + name);
+	sections[RelSection].size = object->relocationCount * ELF_RELOCATION_SIZE;
+	sections[RelSection].link = SymtabSection;
+	sections[RelSection].info = TextSection; /* The section the relocations apply to. */
+	sections[RelSection].align = WORD_SIZE;
+	sections[RelSection].entrySize = ELF_RELOCATION_SIZE;
+	for (index = 0; index < object->relocationCount; index++) {
+		writeWord(output, object->relocations[index].address - MEMORY_START_ADDRESS);
+		if (object->relocations[index].label == NO_LABEL) /* The symbol of the section is its index as well. */
+			writeWord(output, RELOCATION_INFO(object->relocations[index].section, RELOCATION_J_ADDRESS));
+		else
+			writeWord(output, RELOCATION_INFO(symbols[object->relocations[index].label], RELOCATION_J_ADDRESS));
+	}
+
+	sections[ShstrtabSection].type = SECTION_STRTAB;
+	sections[ShstrtabSection].offset = sections[RelSection].offset + sections[RelSection].size;
+	sections[ShstrtabSection].align = 1;
+	for (index = 0; index < SectionCount; index++)
+		sections[ShstrtabSection].size += strlen(sectionNames[index]) + 1; /* +1 for a terminating character. */
+	for (index = 0; index < SectionCount; index++)
+		fwrite(sectionNames[index], 1, strlen(sectionNames[index]) + 1, output);
+
+	offset = alignElf(output, sections[ShstrtabSection].offset + sections[ShstrtabSection].size);
+	for (index = 0, name = 0; index < SectionCount; index++) {
+		writeElfSection(output, name, sections + index);
+		name += strlen(sectionNames[index]) + 1; /* +1 for a terminating character. */
+	}
+
+	writeElfHeader(object, offset);
+	free(symbols);
+}
+
+/**
+ * Frees all the memory used by the given ELF object, the stream is not
+ * closed.
+ */
+void freeElfObject(ElfObject *object) {
+	free(object->relocations);
+	free(object);
+}
+
+/**
+ * Adds a relocation for the given external label, or for the symbol of
+ * the given section if the label is NO_LABEL, used by the code word at
+ * the given address.
+ */
+void addRelocation(ElfObject *object, Label label, Section section, unsigned long int address) {
+	struct elfrelocation *relocation; /* The new relocation. */
+
+	if (object->relocationCount == object->relocationCapacity) { /* Making room for the relocation. */
+		object->relocationCapacity = object->relocationCapacity ? object->relocationCapacity * 2 : INITIAL_RELOCATIONS;
+		if ((relocation = realloc(object->relocations, object->relocationCapacity * sizeof(struct elfrelocation))) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		object->relocations = relocation;
+	}
+	relocation = object->relocations + object->relocationCount++;
+	relocation->address = address;
+	relocation->label = label;
+	relocation->section = section;
+}
+
+/**
+ * Writes the ELF header at the beginning of the stream of the given ELF
+ * object, with the given offset of the section headers. The stream is
+ * left at its end.
+ */
+void writeElfHeader(ElfObject *object, unsigned long int sectionsOffset) {
+	FILE *output = object->output;
+	unsigned char ident[ELF_IDENT_SIZE] = {0x7F, 'E', 'L', 'F', ELF_CLASS_32, ELF_DATA_LSB, ELF_VERSION}; /* The rest is padding. */
+
+	rewind(output);
+	fwrite(ident, 1, ELF_IDENT_SIZE, output);
+	writeHalfWord(output, ELF_TYPE_REL);
+	writeHalfWord(output, ELF_MACHINE_NONE);
+	writeWord(output, ELF_VERSION);
+	writeWord(output, 0); /* No entry point. */
+	writeWord(output, 0); /* No program headers. */
+	writeWord(output, sectionsOffset);
+	writeWord(output, 0); /* No flags. */
+	writeHalfWord(output, ELF_HEADER_SIZE);
+	writeHalfWord(output, 0); /* No program headers. */
+	writeHalfWord(output, 0);
+	writeHalfWord(output, ELF_SECTION_HEADER_SIZE);
+	writeHalfWord(output, SectionCount);
+	writeHalfWord(output, ShstrtabSection);
+	fseek(output, 0, SEEK_END);
+}
+
+/**
+ * Writes a symbol with the given name offset, value, info and section
+ * into the given stream.
+ */
+void writeElfSymbol(FILE *output, unsigned long int name, unsigned long int value, unsigned char info, Section section) {
+	writeWord(output, name);
+	writeWord(output, value);
+	writeWord(output, 0); /* The size of a label is not known. */
+	fputc(info, output);
+	fputc(0, output); /* Default visibility. */
+	writeHalfWord(output, section);
+}
+
+/**
+ * Writes the header of the given section, with the given name offset,
+ * into the given stream.
+ */
+void writeElfSection(FILE *output, unsigned long int name, struct elfsection *section) {
+	writeWord(output, name);
+	writeWord(output, section->type);
+	writeWord(output, section->flags);
+	writeWord(output, 0); /* Sections of a relocatable file have no address. */
+	writeWord(output, section->offset);
+	writeWord(output, section->size);
+	writeWord(output, section->link);
+	writeWord(output, section->info);
+	writeWord(output, section->align);
+	writeWord(output, section->entrySize);
+}
+
+/**
+ * Pads the given stream, which is at the given offset, with zeros to a
+ * word boundary.
+ * Returns the offset after the padding.
+ */
+unsigned long int alignElf(FILE *output, unsigned long int offset) {
+	for (; offset % WORD_SIZE != 0; offset++)
+		fputc(0, output);
+	return offset;
+}
@@ -0,0 +1,63 @@
+#ifndef ELFOBJECT_H
+#define ELFOBJECT_H
+
+#include <stdio.h>
+
+#include "symboltable.h"
+
+/**
+ * An header file for the ELF object translation unit.
+ */
+
+/**
+ * Defining the ELF object data structure.
+ * Writes the assembled program into an ELF32 little endian relocatable
+ * object file, with a .text section for the code segment, a .data
+ * section for the data segment, a symbol table of the entry labels as
+ * global symbols and the external labels as undefined symbols, and a
+ * .rel.text section with a relocation for every use of an external
+ * label and for every J bit field that holds the address of an internal
+ * label, by the symbol of its section, the offset of the label in that
+ * section kept in the bit field. Symbol values and relocation offsets are relative to the start
+ * of their sections, which are loaded from the memory start address.
+ */
+typedef struct elfobject ElfObject;
+
+/**
+ * Creates a new ELF object that writes into the given stream, which
+ * should not have been written yet, a program with the given size of
+ * the code segment and the given size of the data segment.
+ * Returns a pointer to the new ELF object or a null pointer if the
+ * memory allocation had failed.
+ */
+ElfObject *createElfObject(FILE *output, unsigned long int ic, unsigned long int dc);
+
+/**
+ * Writes the given bit field as the next word of the .text section.
+ * A J bit field that holds the address of an internal label gets the
+ * offset of the label in its section instead, and a relocation by the
+ * symbol of that section.
+ */
+void writeElfCode(ElfObject *object, unsigned long int data);
+
+/**
+ * Adds a relocation for the given external label, used by the code word
+ * at the given address.
+ */
+void addElfRelocation(ElfObject *object, Label label, unsigned long int address);
+
+/**
+ * Writes the given data segment, the symbol table made of the entry and
+ * external labels of the given symbol table, the relocations and the
+ * section headers after the .text section and completes the ELF header.
+ * Should be called once, after the whole code segment was written.
+ */
+void writeElfTables(ElfObject *object, SymbolTable *symbolTable, const char *dataSegment);
+
+/**
+ * Frees all the memory used by the given ELF object, the stream is not
+ * closed.
+ */
+void freeElfObject(ElfObject *object);
+
+#endif
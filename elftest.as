@@ -0,0 +1,11 @@
+; The relocations of the ELF object file, checked by "make check".
+		.entry	MAIN
+		.extern	FAR
+MAIN:	la		VALUES
+		jmp		LOOP
+LOOP:	call	FAR
+		la		NAME
+		jmp		$5
+		stop
+VALUES:	.dw		7, -1
+NAME:	.asciz	"elf"
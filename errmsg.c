@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
 
 #include "errmsg.h"
 #include "asmutils.h"
 #include "keywords.h"
 #include "symboltable.h"
+#include "namespace.h"
 
 /**
  * The errmsg translation unit is responsible for printing error
@@ -14,17 +17,56 @@
 /**
  * The following functions should not be used outside this translation unit.
  */
+void createMessageStreamKey();
 void printMsgTitle(const char *fileName, unsigned long int line, int index);
 void printLine(const char *sourceLine, unsigned long int line, int index);
 void errUnexpected();
 
+/**
+ * Holds the stream that messages are printed into for every thread, a
+ * thread that did not set one prints into the standard output.
+ */
+static pthread_key_t messageStreamKey;
+static pthread_once_t messageStreamOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * Creates the key for the per thread message stream.
+ * Called only once, trough pthread_once.
+ */
+void createMessageStreamKey() {
+	if (pthread_key_create(&messageStreamKey, NULL) != 0)
+		errFatal(); /* Cannot tell where messages should go. */
+}
+
+/**
+ * Sets the stream into which every message printed by the calling
+ * thread should be written.
+ */
+void setMessageStream(FILE *stream) {
+	pthread_once(&messageStreamOnce, createMessageStreamKey);
+	if (pthread_setspecific(messageStreamKey, stream) != 0)
+		errFatal(); /* Cannot tell where messages should go. */
+}
+
+/**
+ * Returns the stream into which messages of the calling thread are
+ * printed, the standard output unless another stream was set.
+ */
+FILE *getMessageStream() {
+	FILE *stream;
+
+	pthread_once(&messageStreamOnce, createMessageStreamKey);
+	stream = pthread_getspecific(messageStreamKey);
+	return stream != NULL ? stream : stdout;
+}
+
 /**
  * Prints a title for the error message with the given file name
  * and the given line number and the given index.
  * The title does not include a new line character.
  */
 void printMsgTitle(const char *fileName, unsigned long int line, int index) {
-	printf("%s:%ld:%d: ", fileName, line, index);
+	fprintf(getMessageStream(), "%s:%ld:%d: ", fileName, line, index);
 }
 
 /**
@@ -35,21 +77,21 @@ void printMsgTitle(const char *fileName, unsigned long int line, int index) {
  */
 void printLine(const char *sourceLine, unsigned long int line, int index) {
 	int i; /* For the loop that places the pointer. */
-	printf("%ld |%s\n", line, sourceLine); /* Printing the line. */
+	fprintf(getMessageStream(), "%ld |%s\n", line, sourceLine); /* Printing the line. */
 
 	if (index < 0)
 		return; /* Only the line should be printed. */
 
 	while (line != 0) {
-		printf(" "); /* Moving the pointer underneath to after the line number. */
+		fprintf(getMessageStream(), " "); /* Moving the pointer underneath to after the line number. */
 		line /= 10;
 	}
-	printf("  "); /* Moving the pointer underneath to after the space and pipe sign. */
+	fprintf(getMessageStream(), "  "); /* Moving the pointer underneath to after the space and pipe sign. */
 
 	/* Printing the pointer bellow the position of the issue. */
 	for (i = 0; i < index && i < SOURCE_LINE_LENGTH; i++)
-		printf(" ");
-	printf("^\n");
+		fprintf(getMessageStream(), " ");
+	fprintf(getMessageStream(), "^\n");
 }
 
 /**
@@ -70,10 +112,10 @@ Event errCheckLine(const char *fileName, const char *sourceLine, unsigned long i
 
 	/* Figuring the error message. */
 	if (status == WarningLineLengthFlag) {
-		printf("Warning: character limit exceeded on this line by %d blank characters\n", length - SOURCE_LINE_LENGTH - 1);
+		fprintf(getMessageStream(), "Warning: character limit exceeded on this line by %d blank characters\n", length - SOURCE_LINE_LENGTH - 1);
 		event = WEvent; /* The event is a warning. */
 	} else if (status == ErrorLineLengthFlag) {
-		printf("Error: character limit exceeded on this line by %d characters\n", length - SOURCE_LINE_LENGTH - 1);
+		fprintf(getMessageStream(), "Error: character limit exceeded on this line by %d characters\n", length - SOURCE_LINE_LENGTH - 1);
 		event = EEvent; /* The event is an error. */
 	}
 
@@ -97,7 +139,7 @@ void errFatal() {
  * Prints an unexpected token error message.
  */
 void errUnexpected() {
-	printf("SyntaxError: unexpected token, delete this token\n");
+	fprintf(getMessageStream(), "SyntaxError: unexpected token, delete this token\n");
 }
 
 /**
@@ -123,15 +165,15 @@ Event errCheckData(const char *fileName, const char *sourceLine, unsigned long i
 	/* Figuring the error message. */
 	if (status == NoIssueFlag) { /* The line is incomplete. */
 		if (expecting == ExpectDigitOrSign) /* The line ended empty or after a comma. */
-			printf("SyntaxError: argument is expected here\n");
+			fprintf(getMessageStream(), "SyntaxError: argument is expected here\n");
 		else if (expecting == ExpectDigit) /* The line ended after a plus or a minus. */
-			printf("SyntaxError: incomplete argument\n");
+			fprintf(getMessageStream(), "SyntaxError: incomplete argument\n");
 	} else if (status == IllegalSpacingFlag) { /* The line has illegal spacing. */
-		printf("SyntaxError: illegal spacing\n");
+		fprintf(getMessageStream(), "SyntaxError: illegal spacing\n");
 	} else if (status == StrayCommentFlag) { /* There is a semicolon among the arguments. */
-		printf("SyntaxError: a comment must have a dedicated line\n");
+		fprintf(getMessageStream(), "SyntaxError: a comment must have a dedicated line\n");
 	} else if (status == SizeOverflowFlag) { /* One (or more) of the arguments was too large for the specified data instruction. */
-		printf("Warning: argument size is too large, only least significant bytes were scanned\n");
+		fprintf(getMessageStream(), "Warning: argument size is too large, only least significant bytes were scanned\n");
 		event = WEvent; /* The event is a warning. */
 		index = -1; /* To print the line without the pointer underneath. */
 	} else { /* StraySignFlag, UnexpectedFlag, StrayDigitFlag. The line has unexpected tokens that should be deleted. */
@@ -165,9 +207,9 @@ Event errCheckAsciz(const char *fileName, const char *sourceLine, unsigned long
 	printMsgTitle(fileName, line, index); /* Printing error message title. */
 	/* Figuring the error message. */
 	if (status == NoIssueFlag) { /* ExpectQuote, there is no string, the line is empty. */
-		printf("SyntaxError: string is expected\n");
+		fprintf(getMessageStream(), "SyntaxError: string is expected\n");
 	} else if (status == IncompleteStringFlag) {
-		printf("SyntaxError: string definition lacks ending quote\n");
+		fprintf(getMessageStream(), "SyntaxError: string definition lacks ending quote\n");
 	} else { /* UnexpectedFlag, non-quote characters have appeared before the string. */
 		errUnexpected();
 	}
@@ -197,18 +239,18 @@ Event errCheckR(const char *fileName, const char *sourceLine, unsigned long int
 	/* Figuring the error message. */
 	if (status == NoIssueFlag) {
 		if (expecting == ExpectDollarSign) { /* The line ended before all operands were declared. */
-			printf("SyntaxError: operand is expected\n");
+			fprintf(getMessageStream(), "SyntaxError: operand is expected\n");
 		} else if (expecting == ExpectDigitOrComma || expecting == ExpectComma) { /* The line ended before all operands were declared. */
-			printf("SyntaxError: missing operands, operand separation ',' is expected\n");
+			fprintf(getMessageStream(), "SyntaxError: missing operands, operand separation ',' is expected\n");
 		} else { /* ExpectDigit, nothing after a dollar sign. */
-			printf("SyntaxError: incomplete operand\n");
+			fprintf(getMessageStream(), "SyntaxError: incomplete operand\n");
 		}
 	} else if (status == IllegalSpacingFlag) { /* Spaces are not allowed between a dollar sign and register address. */
-		printf("SyntaxError: illegal spacing, spacing is not allowed after this token\n");
+		fprintf(getMessageStream(), "SyntaxError: illegal spacing, spacing is not allowed after this token\n");
 	} else if (status == StrayCommentFlag) { /* Found a semicolon on a code line. */
-		printf("SyntaxError: a comment must have a dedicated line\n");
+		fprintf(getMessageStream(), "SyntaxError: a comment must have a dedicated line\n");
 	} else if (status == InvalidRegisterFlag) { /* Found a defined register with invalid address. */
-		printf("Error: invalid register address, valid addresses are 0 - 31\n");
+		fprintf(getMessageStream(), "Error: invalid register address, valid addresses are 0 - 31\n");
 		index = -1; /* To print the line without the pointer underneath. */
 	} else { /* StrayDollarSignFlag, StrayDigitFlag, StrayCommaFlag, UnexpectedFlag flags. Tokens should not be there. */
 		errUnexpected();
@@ -242,24 +284,24 @@ Event errCheckI(const char *fileName, const char *sourceLine, unsigned long int
 	/* Figuring the error message. */
 	if (status == NoIssueFlag) {
 		if (expecting == ExpectDollarSign) { /* The line ended with missing operand(s). */
-			printf("SyntaxError: operand is expected\n");
+			fprintf(getMessageStream(), "SyntaxError: operand is expected\n");
 		} else if (expecting == ExpectDigitOrComma || expecting == ExpectComma) { /* The line ended before all operands were declared. */
-			printf("SyntaxError: missing operands, operand separation ',' is expected\n");
+			fprintf(getMessageStream(), "SyntaxError: missing operands, operand separation ',' is expected\n");
 		} else { /* ExpectDigit, ExpectDigitOrSignOrDollarSign, The line ended with an incomplete operand. */
-			printf("SyntaxError: incomplete operand, digit is expected\n");
+			fprintf(getMessageStream(), "SyntaxError: incomplete operand, digit is expected\n");
 		} 
 	} else if (status == IllegalSpacingFlag) { /* Spaces are not allowed between a dollar sign and register address as well as between signs and digits. */
-		printf("SyntaxError: illegal spacing, spacing is not allowed after this token\n");
+		fprintf(getMessageStream(), "SyntaxError: illegal spacing, spacing is not allowed after this token\n");
 	} else if (status == StrayCommentFlag) { /* Found a semicolon on a code line. */
-		printf("SyntaxError: a comment must have a dedicated line\n");
+		fprintf(getMessageStream(), "SyntaxError: a comment must have a dedicated line\n");
 	} else if (status == SizeOverflowFlag) { /* The immediate value was too large. */
-		printf("Warning: argument size is too large, only least significant bytes were scanned\n");
+		fprintf(getMessageStream(), "Warning: argument size is too large, only least significant bytes were scanned\n");
 		event = WEvent; /* This is a warning event. */
 		index = -1; /* To print the line without the pointer underneath. */
 	} else if (status == IllegalSymbolFlag) { /* The specified symbol is illegal. */
-		printf("SyntaxError: The specified symbol is illegal\n");
+		fprintf(getMessageStream(), "SyntaxError: The specified symbol is illegal\n");
 	} else if (status == InvalidRegisterFlag) { /* Found a defined register with invalid address. */
-		printf("Error: invalid register address, valid addresses are 0 - 31\n");
+		fprintf(getMessageStream(), "Error: invalid register address, valid addresses are 0 - 31\n");
 		index = -1; /* To print the line without the pointer underneath. */
 	} else { /* StrayDollarSignFlag, StraySignFlag, StrayDigitFlag, StrayCommaFlag, UnexpectedFlag flags. Tokens should not be there. */
 		errUnexpected();
@@ -293,18 +335,18 @@ Event errCheckJ(const char *fileName, const char *sourceLine, unsigned long int
 	/* Figuring the error message. */
 	if (status == NoIssueFlag) {
 		if (expecting == ExpectDollarSign) { /* The line ended with missing operand (the operand could also be a label). */
-			printf("SyntaxError: operand is expected\n");
+			fprintf(getMessageStream(), "SyntaxError: operand is expected\n");
 		} else { /* ExpectDigit, The line ended with incomplete operand. */
-			printf("SyntaxError: incomplete operand\n");
+			fprintf(getMessageStream(), "SyntaxError: incomplete operand\n");
 		}
 	} else if (status == IllegalSpacingFlag) { /* Spaces are not allowed between a dollar sign and register address. */
-		printf("SyntaxError: illegal spacing, spacing is not allowed after this token\n");
+		fprintf(getMessageStream(), "SyntaxError: illegal spacing, spacing is not allowed after this token\n");
 	} else if (status == StrayCommentFlag) { /* Found a semicolon on a code line. */
-		printf("SyntaxError: a comment must have a dedicated line\n");
+		fprintf(getMessageStream(), "SyntaxError: a comment must have a dedicated line\n");
 	} else if (status == IllegalSymbolFlag) { /* The specified symbol is illegal. */
-		printf("SyntaxError: The specified symbol is illegal\n");
+		fprintf(getMessageStream(), "SyntaxError: The specified symbol is illegal\n");
 	} else if (status == InvalidRegisterFlag) { /* Found a defined register with invalid address. */
-		printf("Error: invalid register address, valid addresses are 0 - 31\n");
+		fprintf(getMessageStream(), "Error: invalid register address, valid addresses are 0 - 31\n");
 	} else { /* StrayDollarSignFlag, StrayDigitFlag, UnexpectedFlag, Tokens should not be there. */
 		errUnexpected();
 	}
@@ -338,11 +380,11 @@ Event errCheckWord(const char *fileName, const char *sourceLine, unsigned long i
 	printMsgTitle(fileName, line, index); /* Printing error message title. */
 	/* Figuring the error message. */
 	if (status == IllegalSpacingFlag) { /* Illegal spacing can be returned only it there was a space after a dot. */
-		printf("SyntaxError: Illegal spacing, data instructor is expected\n");
+		fprintf(getMessageStream(), "SyntaxError: Illegal spacing, data instructor is expected\n");
 	} else if (status == StrayCommentFlag || status == UnexpectedFlag || status == StrayDigitFlag) { /* Found a semicolon on a code line. */
 		errUnexpected();
 	} else if (status == IllegalSymbolFlag)
-		printf("SyntaxError: illegal symbol\n");
+		fprintf(getMessageStream(), "SyntaxError: illegal symbol\n");
 
 	printLine(sourceLine, line, index); /* Printing the line. */
 
@@ -351,26 +393,18 @@ Event errCheckWord(const char *fileName, const char *sourceLine, unsigned long i
 
 /**
  * Checks for problems that may occur while handling labels.
- * Specifically a label that was already declared or a
- * symbol with a reserved keyword.
+ * Specifically a symbol with a reserved keyword, labels
+ * may be used and declared more than once. The kind of
+ * the symbol is looked up by the caller.
  * Returns an Event enumeration value that can be used
  * to determine what was the issue (if there was one).
  */
-Event errCheckSymbol(SymbolTable *symbolTable, const char *fileName, const char *sourceLine, const char *symbol, unsigned long int line) {
-	SymbolTable *checkLabel = searchLabel(symbolTable, symbol); /* To check if the symbol was already declared. */
-	Operator *checkOperator = searchOperatorByString(symbol); /* To check if the symbol is a keyword. */
-	Instructor *checkInstructor = searchInstructorByString(symbol); /* To check if the symbol is a keyword. */
-
-	if (checkLabel == NULL && checkOperator == NULL && checkInstructor == NULL) /* The symbol can only be one of them. */
-		return NEvent; /* There is no issue. */
-	if (checkLabel != NULL && isDeclared(symbolTable) == ERROR)
-		return NEvent; /* This label was used as an operand and was not yet declared. */
+Event errCheckSymbol(NameKind kind, const char *fileName, const char *sourceLine, const char *symbol, unsigned long int line) {
+	if (kind == UnknownName || kind == LabelName)
+		return NEvent; /* There is no issue, a label may be used before it is declared. */
 
 	printMsgTitle(fileName, line, 0); /* Printing error message title. */
-	if (checkLabel != NULL)
-		printf("Error: symbol '%s' is already declared\n", symbol); /* The label is already declared. */
-	else if (checkOperator != NULL || checkInstructor != NULL) /* The first parameter can be NULL. */
-		printf("Error: symbol '%s' is a reserved keyword\n", symbol); /* The label is a reserved keyword. */
+	fprintf(getMessageStream(), "Error: symbol '%s' is a reserved keyword\n", symbol); /* The label is a reserved keyword. */
 	printLine(sourceLine, line, -1); /* Printing the line without the pointer underneath. */
 
 	return EEvent; /* The event was an error. */
@@ -382,7 +416,7 @@ Event errCheckSymbol(SymbolTable *symbolTable, const char *fileName, const char
  */
 void errLonelyLabel(const char *fileName, const char *sourceLine, unsigned long int line) {
 	printMsgTitle(fileName, line, 0); /* Printing error message title. */
-	printf("Error: this line is labeled but empty\n");
+	fprintf(getMessageStream(), "Error: this line is labeled but empty\n");
 	printLine(sourceLine, line, -1); /* Printing the line without the pointer underneath. */
 }
 
@@ -392,7 +426,7 @@ void errLonelyLabel(const char *fileName, const char *sourceLine, unsigned long
  */
 void errInvalidKeyword(const char *fileName, const char *sourceLine, const char *word, unsigned long int line) {
 	printMsgTitle(fileName, line, 0); /* Printing error message title. */
-	printf("SyntaxError: unknown keyword '%s'\n", word);
+	fprintf(getMessageStream(), "SyntaxError: unknown keyword '%s'\n", word);
 	printLine(sourceLine, line, -1); /* Printing the line without the pointer underneath. */
 }
 
@@ -404,11 +438,11 @@ void errInvalidArgumentSet(const char *fileName, const char *sourceLine, unsigne
 	printMsgTitle(fileName, line, 0); /* Printing error message title. */
 	if (typeOperator == I) { /* Printing message for I operators. */
 		if (isSpecialSet)
-			printf("SyntaxError: invalid argument set, should be: register, register, label\n");
+			fprintf(getMessageStream(), "SyntaxError: invalid argument set, should be: register, register, label\n");
 		else
-			printf("SyntaxError: invalid argument set, should be: register, immediate, register\n");
+			fprintf(getMessageStream(), "SyntaxError: invalid argument set, should be: register, immediate, register\n");
 	} else if (typeOperator == J) /* Printing message for J operators. */
-		printf("SyntaxError: invalid argument set, should be: label\n");
+		fprintf(getMessageStream(), "SyntaxError: invalid argument set, should be: label\n");
 	printLine(sourceLine, line, -1); /* Printing the line without the pointer underneath. */
 }
 
@@ -419,9 +453,9 @@ void errInvalidArgumentSet(const char *fileName, const char *sourceLine, unsigne
 void wrnLabeledLine(const char *fileName, const char *sourceLine, unsigned long int line, Expectation dataExpectation) {
 	printMsgTitle(fileName, line, 0); /* Printing error message title. */
 	if (dataExpectation == ExpectLabelEntry) /* Warning message for an entry line. */
-		printf("Warning: label before entry keyword is ignored\n");
+		fprintf(getMessageStream(), "Warning: label before entry keyword is ignored\n");
 	else if (dataExpectation == ExpectLabelExternal) /* Warning message for an extern line. */
-		printf("Warning: label before extern keyword is ignored\n");
+		fprintf(getMessageStream(), "Warning: label before extern keyword is ignored\n");
 	printLine(sourceLine, line, 0); /* Printing the line. */
 }
 
@@ -447,9 +481,9 @@ Event errCheckExpectLabel(const char *fileName, const char *sourceLine, const ch
 	printMsgTitle(fileName, line, index); /* Printing error message title. */
 	/* Figuring the error message. */
 	if ((status == OperatorFlag && expecting == ExpectWord) || symbol == NULL) /* Checking if there is a label at all. */
-		printf("SyntaxError: label is expected\n"); /* The line is empty or there is an unexpected token. */
+		fprintf(getMessageStream(), "SyntaxError: label is expected\n"); /* The line is empty or there is an unexpected token. */
 	else
-		printf("SyntaxError: label is expected, replace this token\n"); /* Everything else is unexpected. */
+		fprintf(getMessageStream(), "SyntaxError: label is expected, replace this token\n"); /* Everything else is unexpected. */
 	printLine(sourceLine, line, index); /* Printing the line. */
 
 	return event;
@@ -462,9 +496,9 @@ Event errCheckExpectLabel(const char *fileName, const char *sourceLine, const ch
 void errBothEntryAndExtern(const char *fileName, const char *sourceLine, unsigned long int line, Expectation dataExpectation) {
 	printMsgTitle(fileName, line, 0); /* Printing error message title. */
 	if (dataExpectation == ExpectLabelEntry)
-		printf("Error: label is already defined as external\n");
+		fprintf(getMessageStream(), "Error: label is already defined as external\n");
 	else if (dataExpectation == ExpectLabelExternal)
-		printf("Error: label is already defined as entry\n");
+		fprintf(getMessageStream(), "Error: label is already defined as entry\n");
 	printLine(sourceLine, line, -1); /* Printing the line without the pointer underneath. */
 }
 
@@ -482,10 +516,30 @@ void errUnexpectedToken(const char *fileName, const char *sourceLine, unsigned l
  * A formatted error message for cases where a label is used
  * but not declared.
  */
-void errUndeclaredLabel(const char *fileName, SymbolTable *label) {
+void errUndeclaredLabel(const char *fileName, SymbolTable *symbolTable, Label label) {
 	/* The address field should contain the line where the label is used. */
-	printf("%s:%ld: ", fileName, getAddress(label));
-	printf("Error: the label '%s' is used but not declared\n", getSymbol(label));
+	fprintf(getMessageStream(), "%s:%ld: ", fileName, getAddress(symbolTable, label));
+	fprintf(getMessageStream(), "Error: the label '%s' is used but not declared\n", getSymbol(symbolTable, label));
+}
+
+/**
+ * A formatted error message for cases where a numeric local label
+ * is used but has no definition in the given direction.
+ */
+void errUndefinedLocalLabel(const char *fileName, const char *reference, unsigned long int line) {
+	fprintf(getMessageStream(), "%s:%ld: ", fileName, line);
+	fprintf(getMessageStream(), "Error: the local label '%s' is used but not defined %s this line\n", reference,
+		reference[strlen(reference) - 1] == BACKWARD_SUFFIX ? "before" : "after");
+}
+
+/**
+ * A formatted error message for cases where a numeric local label
+ * is at the beginning of a line that is not a code line.
+ */
+void errLocalLabelLine(const char *fileName, const char *sourceLine, unsigned long int line) {
+	printMsgTitle(fileName, line, 0); /* Printing error message title. */
+	fprintf(getMessageStream(), "Error: a local label can only label a code line\n");
+	printLine(sourceLine, line, -1); /* Printing the line without the pointer underneath. */
 }
 
 /**
@@ -493,7 +547,34 @@ void errUndeclaredLabel(const char *fileName, SymbolTable *label) {
  * as external but is already defined locally.
  */
 void errDeclaredExtern(const char *fileName, const char *sourceLine, const char *symbol, unsigned long int line) {
-	printf("%s:%ld: ", fileName, line);
-	printf("Error: the external label '%s' is declared locally\n", symbol);
+	fprintf(getMessageStream(), "%s:%ld: ", fileName, line);
+	fprintf(getMessageStream(), "Error: the external label '%s' is declared locally\n", symbol);
 	printLine(sourceLine, line, -1); /* Printing the line without the pointer underneath. */
 }
+
+/**
+ * A formatted error message for cases where the mapping of a source
+ * file was stopped after too many errors.
+ */
+void errTooManyErrors(const char *fileName, unsigned long int line, unsigned long int errors, unsigned long int skipped) {
+	fprintf(getMessageStream(), "%s:%ld: ", fileName, line);
+	fprintf(getMessageStream(), "Error: stopped after %ld errors, the remaining %ld lines were skipped\n", errors, skipped);
+}
+
+/**
+ * A formatted error message for cases where an external label
+ * is not an entry label of any source file in the batch.
+ */
+void errUnresolvedExtern(const char *fileName, const char *symbol) {
+	fprintf(getMessageStream(), "%s: ", fileName);
+	fprintf(getMessageStream(), "Error: the external label '%s' is not an entry of any source file\n", symbol);
+}
+
+/**
+ * A formatted error message for cases where an entry label is
+ * an entry label of another source file in the batch as well.
+ */
+void errDuplicateEntry(const char *fileName, const char *symbol, const char *otherFileName) {
+	fprintf(getMessageStream(), "%s: ", fileName);
+	fprintf(getMessageStream(), "Error: the entry label '%s' is already an entry of %s\n", symbol, otherFileName);
+}
@@ -3,6 +3,7 @@
 
 #include "asmutils.h"
 #include "symboltable.h"
+#include "namespace.h"
 
 /**
  * An header file for the errmsg translation unit.
@@ -20,6 +21,18 @@ typedef enum {
 	NEvent /* No message was printed, does not affect the output. */
 } Event;
 
+/**
+ * Sets the stream into which every message printed by the calling
+ * thread should be written.
+ */
+void setMessageStream(FILE *stream);
+
+/**
+ * Returns the stream into which messages of the calling thread are
+ * printed, the standard output unless another stream was set.
+ */
+FILE *getMessageStream();
+
 /**
  * Checks for issues that may be found in the source file
  * after calling the extractSourceLine function.
@@ -112,12 +125,13 @@ Event errCheckWord(const char *fileName, const char *sourceLine, unsigned long i
 
 /**
  * checks for problems that may occur while handling labels.
- * Specifically a label that was already declared or a
- * symbol with a reserved keyword.
+ * Specifically a symbol with a reserved keyword, labels
+ * may be used and declared more than once. The kind of
+ * the symbol is looked up by the caller.
  * Returns an Event enumeration value that can be used
  * to determine what was the issue (if there was one).
  */
-Event errCheckSymbol(SymbolTable *symbolTable, const char *fileName, const char *sourceLine, const char *symbol, unsigned long int line);
+Event errCheckSymbol(NameKind kind, const char *fileName, const char *sourceLine, const char *symbol, unsigned long int line);
 
 /**
  * A formatted error message for cases where a line has
@@ -171,7 +185,19 @@ void errUnexpectedToken(const char *fileName, const char *sourceLine, unsigned l
  * A formatted error message for cases where a label is used
  * but not declared.
  */
-void errUndeclaredLabel(const char *fileName, SymbolTable *label);
+void errUndeclaredLabel(const char *fileName, SymbolTable *symbolTable, Label label);
+
+/**
+ * A formatted error message for cases where a numeric local label
+ * is used but has no definition in the given direction.
+ */
+void errUndefinedLocalLabel(const char *fileName, const char *reference, unsigned long int line);
+
+/**
+ * A formatted error message for cases where a numeric local label
+ * is at the beginning of a line that is not a code line.
+ */
+void errLocalLabelLine(const char *fileName, const char *sourceLine, unsigned long int line);
 
 /**
  * A formatted error message for cases where a label is defined
@@ -179,4 +205,22 @@ void errUndeclaredLabel(const char *fileName, SymbolTable *label);
  */
 void errDeclaredExtern(const char *fileName, const char *sourceLine, const char *symbol, unsigned long int line);
 
+/**
+ * A formatted error message for cases where the mapping of a source
+ * file was stopped after too many errors.
+ */
+void errTooManyErrors(const char *fileName, unsigned long int line, unsigned long int errors, unsigned long int skipped);
+
+/**
+ * A formatted error message for cases where an external label
+ * is not an entry label of any source file in the batch.
+ */
+void errUnresolvedExtern(const char *fileName, const char *symbol);
+
+/**
+ * A formatted error message for cases where an entry label is
+ * an entry label of another source file in the batch as well.
+ */
+void errDuplicateEntry(const char *fileName, const char *symbol, const char *otherFileName);
+
 #endif
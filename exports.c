@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "exports.h"
+#include "symboltable.h"
+#include "arena.h"
+#include "asmutils.h"
+#include "errmsg.h"
+#include "utils.h"
+
+/**
+ * The exports translation unit resolves the external labels of a batch
+ * of source files against the entry labels of the batch, without linking
+ * anything. The entry labels are kept in an open addressing hash table
+ * and every string is copied into an arena, all of it guarded by a
+ * single lock.
+ */
+
+#define INITIAL_SLOTS 256 /* The initial number of slots, a power of two. */
+#define INITIAL_IMPORTS 64 /* The initial capacity of the imports and the duplicates arrays. */
+#define ARENA_BLOCK_SIZE 16384 /* The size of the blocks of the arena (in bytes). */
+
+/**
+ * Defining the exported label data structure.
+ * A single entry of the exports hash table.
+ */
+struct exported {
+	const char *symbol; /* The symbol of the entry label, null for an empty slot. */
+	unsigned long int hash; /* The hash of the symbol. */
+	const char *fileName; /* The first source file that exported the label. */
+};
+
+/**
+ * Defining the label use data structure.
+ * An external label of a source file, or an entry label that was
+ * exported by a second source file.
+ */
+struct labeluse {
+	const char *symbol; /* The symbol of the label. */
+	const char *fileName; /* The source file. */
+	const char *otherFileName; /* The source file that exported the label first, for duplicates. */
+};
+
+/**
+ * Defining the exports data structure.
+ * A hash table of the entry labels of every source file in a batch,
+ * along with the external labels every file expects some other file to
+ * export. Any number of threads may publish into it at the same time.
+ */
+struct exportset {
+	struct exported *slots; /* The hash table, probed linearly. */
+	unsigned long int capacity; /* The number of slots, a power of two. */
+	unsigned long int count; /* The number of exported labels. */
+	struct labeluse *imports; /* The external labels, in the order they were published. */
+	unsigned long int importCount; /* The number of external labels. */
+	unsigned long int importCapacity; /* The capacity of the imports array. */
+	struct labeluse *duplicates; /* The entry labels that were exported more than once. */
+	unsigned long int duplicateCount; /* The number of duplicates. */
+	unsigned long int duplicateCapacity; /* The capacity of the duplicates array. */
+	Arena *strings; /* Holds the symbols and the file names. */
+	pthread_mutex_t lock; /* Guards everything above. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+struct exported *findExport(Exports *exports, const char *symbol, unsigned long int hash);
+void addExport(Exports *exports, const char *symbol, const char *fileName);
+void addLabelUse(struct labeluse **uses, unsigned long int *count, unsigned long int *capacity, const char *symbol, const char *fileName, const char *otherFileName);
+void growExports(Exports *exports);
+
+/**
+ * Creates a new empty exports table.
+ * Returns a pointer to the new table or a null pointer if the memory
+ * allocation had failed.
+ */
+Exports *createExports() {
+	Exports *exports = calloc(1, sizeof(Exports)); /* Every field starts empty. */
+
+	if (exports == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	exports->capacity = INITIAL_SLOTS;
+	if ((exports->slots = calloc(INITIAL_SLOTS, sizeof(struct exported))) == NULL ||
+		(exports->strings = createArena(ARENA_BLOCK_SIZE)) == NULL) {
+		free(exports->slots);
+		free(exports);
+		return NULL; /* Memory allocation failed. */
+	}
+	pthread_mutex_init(&exports->lock, NULL);
+
+	return exports;
+}
+
+/**
+ * Publishes the entry labels of the given symbol table of the given
+ * source file into the given exports table, and keeps its external
+ * labels to be checked at the end of the batch.
+ */
+void publishSymbols(Exports *exports, SymbolTable *symbolTable, const char *fileName) {
+	Label label; /* To loop trough the labels. */
+	const char *name; /* The copy of the file name. */
+	const char *symbol; /* The copy of the symbol of every external label. */
+
+	pthread_mutex_lock(&exports->lock);
+	if ((name = copyArenaString(exports->strings, fileName)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label)) {
+		if (hasAttribute(symbolTable, label, EntryLabel) == SUCCESS)
+			addExport(exports, getSymbol(symbolTable, label), name);
+		else if (hasAttribute(symbolTable, label, ExternLabel) == SUCCESS) {
+			if ((symbol = copyArenaString(exports->strings, getSymbol(symbolTable, label))) == NULL)
+				errFatal(); /* Cannot continue without memory. */
+			addLabelUse(&exports->imports, &exports->importCount, &exports->importCapacity, symbol, name, NULL);
+		}
+	}
+	pthread_mutex_unlock(&exports->lock);
+}
+
+/**
+ * Checks that every external label that was published into the given
+ * exports table is an entry label of exactly one source file, and prints
+ * an error message for every one that is not.
+ * Returns SUCCESS if every external label is resolved and ERROR
+ * otherwise.
+ */
+Code checkExports(Exports *exports) {
+	struct labeluse *use; /* Every external label and every duplicate. */
+	Code code = SUCCESS; /* The result. */
+
+	pthread_mutex_lock(&exports->lock);
+	for (use = exports->duplicates; use < exports->duplicates + exports->duplicateCount; use++) {
+		errDuplicateEntry(use->fileName, use->symbol, use->otherFileName);
+		code = ERROR;
+	}
+	for (use = exports->imports; use < exports->imports + exports->importCount; use++) {
+		if (findExport(exports, use->symbol, hashBytes(use->symbol, strlen(use->symbol), 0))->symbol == NULL) {
+			errUnresolvedExtern(use->fileName, use->symbol);
+			code = ERROR;
+		}
+	}
+	pthread_mutex_unlock(&exports->lock);
+
+	return code;
+}
+
+/**
+ * Frees all the memory used by the given exports table.
+ */
+void freeExports(Exports *exports) {
+	pthread_mutex_destroy(&exports->lock);
+	free(exports->slots);
+	free(exports->imports);
+	free(exports->duplicates);
+	freeArena(exports->strings);
+	free(exports);
+}
+
+/**
+ * Probes the given exports table for the given symbol with the given
+ * hash.
+ * Returns the slot of the symbol, or the empty slot where it should be
+ * added if it is not in the table.
+ */
+struct exported *findExport(Exports *exports, const char *symbol, unsigned long int hash) {
+	const unsigned long int mask = exports->capacity - 1; /* The capacity is a power of two. */
+	unsigned long int index = hash & mask;
+
+	/* The table is never full, so the probe always ends. */
+	while (exports->slots[index].symbol != NULL &&
+		(exports->slots[index].hash != hash || strcmp(exports->slots[index].symbol, symbol) != 0))
+		index = (index + 1) & mask;
+
+	return &exports->slots[index];
+}
+
+/**
+ * Adds the given entry label of the given source file to the given
+ * exports table, or records it as a duplicate if another file exported
+ * it already. Expects the lock to be held.
+ */
+void addExport(Exports *exports, const char *symbol, const char *fileName) {
+	const unsigned long int hash = hashBytes(symbol, strlen(symbol), 0);
+	struct exported *slot = findExport(exports, symbol, hash);
+
+	if (slot->symbol != NULL) { /* Another file exported it first. */
+		addLabelUse(&exports->duplicates, &exports->duplicateCount, &exports->duplicateCapacity, slot->symbol, fileName, slot->fileName);
+		return;
+	}
+	if ((exports->count + 1) * 2 > exports->capacity) { /* Keeping the table at most half full. */
+		growExports(exports);
+		slot = findExport(exports, symbol, hash);
+	}
+
+	if ((slot->symbol = copyArenaString(exports->strings, symbol)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	slot->hash = hash;
+	slot->fileName = fileName;
+	exports->count++;
+}
+
+/**
+ * Appends a label use of the given symbol and source files to the given
+ * array, growing it if it is full. The strings are expected to be in the
+ * arena of the exports table already.
+ */
+void addLabelUse(struct labeluse **uses, unsigned long int *count, unsigned long int *capacity, const char *symbol, const char *fileName, const char *otherFileName) {
+	struct labeluse *use; /* The new label use. */
+
+	if (*count == *capacity) { /* Making room for the label use. */
+		*capacity = *capacity ? *capacity * 2 : INITIAL_IMPORTS;
+		if ((use = realloc(*uses, *capacity * sizeof(struct labeluse))) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		*uses = use;
+	}
+
+	use = *uses + (*count)++;
+	use->fileName = fileName;
+	use->otherFileName = otherFileName;
+	use->symbol = symbol;
+}
+
+/**
+ * Doubles the number of slots of the given exports table and places
+ * every exported label again. Expects the lock to be held.
+ */
+void growExports(Exports *exports) {
+	struct exported *slots = exports->slots; /* The old slots. */
+	const unsigned long int capacity = exports->capacity;
+	unsigned long int index;
+
+	if ((exports->slots = calloc(capacity * 2, sizeof(struct exported))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	exports->capacity = capacity * 2;
+
+	for (index = 0; index < capacity; index++)
+		if (slots[index].symbol != NULL)
+			*findExport(exports, slots[index].symbol, slots[index].hash) = slots[index];
+	free(slots);
+}
@@ -0,0 +1,47 @@
+#ifndef EXPORTS_H
+#define EXPORTS_H
+
+#include "asmutils.h"
+#include "symboltable.h"
+
+/**
+ * An header file for the exports translation unit.
+ */
+
+/**
+ * Defining the exports data structure.
+ * A hash table of the entry labels of every source file in a batch,
+ * along with the external labels every file expects some other file to
+ * export. Any number of threads may publish into it at the same time.
+ */
+typedef struct exportset Exports;
+
+/**
+ * Creates a new empty exports table.
+ * Returns a pointer to the new table or a null pointer if the memory
+ * allocation had failed.
+ */
+Exports *createExports();
+
+/**
+ * Publishes the entry labels of the given symbol table of the given
+ * source file into the given exports table, and keeps its external
+ * labels to be checked at the end of the batch.
+ */
+void publishSymbols(Exports *exports, SymbolTable *symbolTable, const char *fileName);
+
+/**
+ * Checks that every external label that was published into the given
+ * exports table is an entry label of exactly one source file, and prints
+ * an error message for every one that is not.
+ * Returns SUCCESS if every external label is resolved and ERROR
+ * otherwise.
+ */
+Code checkExports(Exports *exports);
+
+/**
+ * Frees all the memory used by the given exports table.
+ */
+void freeExports(Exports *exports);
+
+#endif
@@ -0,0 +1,515 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__AVX2__) && !defined(NO_SIMD)
+#define HEX_AVX2 /* Converting 32 bytes at once. */
+#include <immintrin.h>
+#elif defined(__SSE2__) && !defined(NO_SIMD)
+#define HEX_SSE2 /* Converting 16 bytes at once. */
+#include <emmintrin.h>
+#endif
+
+#include "hexwriter.h"
+#include "errmsg.h"
+
+/**
+ * The hex writer translation unit formats the object file without the
+ * standard formatted output functions. The bytes are converted to their
+ * fields, a space and two hexadecimal digits, a block at a time: 32
+ * bytes with AVX2 and 16 bytes with SSE2 where the compiler offers them,
+ * and with a table of the two digits of every byte otherwise, which is
+ * also what a build with NO_SIMD defined uses. The address of every line
+ * is kept as text and counted up from the address before it, and
+ * everything goes straight into a buffer that is written in one piece.
+ */
+
+#define HEX_BUFFER_SIZE 65536 /* The size of the buffer of a writer (in bytes). */
+#define MAX_RECORD_SIZE 64 /* More than the longest piece written at once, a code line with the longest address. */
+#define ADDRESS_WIDTH 4 /* Addresses are padded with zeros to that many digits. */
+#define LINE_BYTES 4 /* The number of data bytes between two addresses. */
+#define HEADER_INDENT "     " /* The header line starts with that. */
+#define DECIMAL 10 /* Decimal base, used for conversion from integer to text. */
+#ifdef HEX_AVX2
+#define HEX_BLOCK 32 /* The number of bytes converted to hexadecimal digits at once. */
+#else
+#define HEX_BLOCK 16 /* The number of bytes converted to hexadecimal digits at once. */
+#endif
+#define BYTE_FIELD 3 /* The size of the field of every byte in a line, a space and two digits. */
+#define LANE 16 /* The size of a 128 bit lane (in bytes). */
+#define LINE_SIZE(width) ((width) + 3 * LINE_BYTES + 1) /* The size of a full line with an address of the given width, new line character included. */
+#define COUNTER_SIZE (3 * sizeof(unsigned long int) + 1) /* More than the digits of the largest address, and one more for counting past it. */
+
+#if !defined(HEX_AVX2) && !defined(HEX_SSE2)
+/**
+ * The two hexadecimal digits of every byte, for converting without SIMD.
+ */
+static const char hexDigits[256][3] = {
+	"00", "01", "02", "03", "04", "05", "06", "07", "08", "09", "0A", "0B", "0C", "0D", "0E", "0F",
+	"10", "11", "12", "13", "14", "15", "16", "17", "18", "19", "1A", "1B", "1C", "1D", "1E", "1F",
+	"20", "21", "22", "23", "24", "25", "26", "27", "28", "29", "2A", "2B", "2C", "2D", "2E", "2F",
+	"30", "31", "32", "33", "34", "35", "36", "37", "38", "39", "3A", "3B", "3C", "3D", "3E", "3F",
+	"40", "41", "42", "43", "44", "45", "46", "47", "48", "49", "4A", "4B", "4C", "4D", "4E", "4F",
+	"50", "51", "52", "53", "54", "55", "56", "57", "58", "59", "5A", "5B", "5C", "5D", "5E", "5F",
+	"60", "61", "62", "63", "64", "65", "66", "67", "68", "69", "6A", "6B", "6C", "6D", "6E", "6F",
+	"70", "71", "72", "73", "74", "75", "76", "77", "78", "79", "7A", "7B", "7C", "7D", "7E", "7F",
+	"80", "81", "82", "83", "84", "85", "86", "87", "88", "89", "8A", "8B", "8C", "8D", "8E", "8F",
+	"90", "91", "92", "93", "94", "95", "96", "97", "98", "99", "9A", "9B", "9C", "9D", "9E", "9F",
+	"A0", "A1", "A2", "A3", "A4", "A5", "A6", "A7", "A8", "A9", "AA", "AB", "AC", "AD", "AE", "AF",
+	"B0", "B1", "B2", "B3", "B4", "B5", "B6", "B7", "B8", "B9", "BA", "BB", "BC", "BD", "BE", "BF",
+	"C0", "C1", "C2", "C3", "C4", "C5", "C6", "C7", "C8", "C9", "CA", "CB", "CC", "CD", "CE", "CF",
+	"D0", "D1", "D2", "D3", "D4", "D5", "D6", "D7", "D8", "D9", "DA", "DB", "DC", "DD", "DE", "DF",
+	"E0", "E1", "E2", "E3", "E4", "E5", "E6", "E7", "E8", "E9", "EA", "EB", "EC", "ED", "EE", "EF",
+	"F0", "F1", "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9", "FA", "FB", "FC", "FD", "FE", "FF"
+};
+#endif
+
+#ifdef HEX_AVX2
+/**
+ * The shuffles that spread the 16 high digits and the 16 low digits of a
+ * lane into the 48 characters of their fields, 16 characters at a time,
+ * and the spaces between them. An index of 0x80 picks a zero.
+ */
+static const unsigned char highShuffle[BYTE_FIELD * LANE] = {
+	0x80, 0, 0x80, 0x80, 1, 0x80, 0x80, 2, 0x80, 0x80, 3, 0x80, 0x80, 4, 0x80, 0x80,
+	5, 0x80, 0x80, 6, 0x80, 0x80, 7, 0x80, 0x80, 8, 0x80, 0x80, 9, 0x80, 0x80, 10,
+	0x80, 0x80, 11, 0x80, 0x80, 12, 0x80, 0x80, 13, 0x80, 0x80, 14, 0x80, 0x80, 15, 0x80
+};
+static const unsigned char lowShuffle[BYTE_FIELD * LANE] = {
+	0x80, 0x80, 0, 0x80, 0x80, 1, 0x80, 0x80, 2, 0x80, 0x80, 3, 0x80, 0x80, 4, 0x80,
+	0x80, 5, 0x80, 0x80, 6, 0x80, 0x80, 7, 0x80, 0x80, 8, 0x80, 0x80, 9, 0x80, 0x80,
+	10, 0x80, 0x80, 11, 0x80, 0x80, 12, 0x80, 0x80, 13, 0x80, 0x80, 14, 0x80, 0x80, 15
+};
+static const unsigned char fieldSpaces[BYTE_FIELD * LANE] = {
+	' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ',
+	0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0,
+	0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0, ' ', 0, 0
+};
+#endif
+
+/**
+ * Defining the hex writer data structure.
+ * Formats the lines of an object file into a large buffer and writes
+ * the buffer into its stream only when it is full.
+ */
+struct hexwriter {
+	FILE *output; /* The object file. */
+	char *buffer; /* The formatted lines that were not written yet. */
+	unsigned long int size; /* The used part of the buffer. */
+};
+
+/**
+ * Defining the hex job data structure.
+ * A range of full lines of an object file that is filled in place by a
+ * single thread. The code lines come first and the full lines of the
+ * data segment follow, at consecutive addresses.
+ */
+struct hexjob {
+	char *position; /* Where the first line of the range goes. */
+	const Word *code; /* The code segment. */
+	const char *dataSegment; /* The data segment. */
+	unsigned long int codeLines; /* The number of code lines. */
+	unsigned long int first, last; /* The range of lines, the last one is not included. */
+	unsigned long int address; /* The address of the first line of the range. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+char *reserveHex(HexWriter *writer);
+char *putDecimal(char *position, unsigned long int value, int width);
+int addDecimal(char *digits, int width, unsigned int value);
+char *putHexLine(char *position, const char *counter, int width, const char *fields);
+void hexBlock(char *fields, const unsigned char *bytes);
+unsigned long int addressWidths(unsigned long int address, unsigned long int count);
+void *fillHexLines(void *job);
+
+/**
+ * Creates a new hex writer that writes into the given stream, which
+ * should not have been written yet. The stream is left unbuffered since
+ * the writer buffers everything itself.
+ * Returns a pointer to the new writer or a null pointer if the memory
+ * allocation had failed.
+ */
+HexWriter *createHexWriter(FILE *output) {
+	HexWriter *writer = malloc(sizeof(HexWriter));
+
+	if (writer == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	if ((writer->buffer = malloc(HEX_BUFFER_SIZE)) == NULL) {
+		free(writer);
+		return NULL; /* Memory allocation failed. */
+	}
+	writer->output = output;
+	writer->size = 0;
+	setvbuf(output, NULL, _IONBF, 0); /* Every full buffer is a single write. */
+
+	return writer;
+}
+
+/**
+ * Writes the header line of an object file with the given size of the
+ * code segment and the given size of the data segment.
+ */
+void writeHexHeader(HexWriter *writer, unsigned long int ic, unsigned long int dc) {
+	const char *indent = HEADER_INDENT;
+	char *position = reserveHex(writer);
+
+	while (*indent != '\0')
+		*position++ = *indent++;
+	position = putDecimal(position, ic, 1);
+	*position++ = ' ';
+	position = putDecimal(position, dc, 1);
+	*position++ = '\n';
+
+	writer->size = position - writer->buffer;
+}
+
+/**
+ * Writes the given number of bit fields of the given code segment, as
+ * the lines of the object file, starting from the given address.
+ * Every bit field is written between its address and a new line
+ * character and is divided into 8 bit sections separated by spaces,
+ * starting from the least significant section.
+ */
+void writeHexCode(HexWriter *writer, const Word *code, unsigned long int count, unsigned long int address) {
+	unsigned char bytes[HEX_BLOCK]; /* The sections of a block of bit fields. */
+	char fields[BYTE_FIELD * HEX_BLOCK]; /* The fields of the block. */
+	char counter[COUNTER_SIZE]; /* The address of the next line. */
+	unsigned long int index, line, lines; /* To loop trough the bit fields. */
+	int width = putDecimal(counter, address, ADDRESS_WIDTH) - counter; /* The number of digits of the address. */
+	char *position;
+
+	memset(bytes, 0, HEX_BLOCK); /* The last block may not be full. */
+	for (index = 0; index < count; index += lines) {
+		lines = count - index < HEX_BLOCK / LINE_BYTES ? count - index : HEX_BLOCK / LINE_BYTES;
+		for (line = 0; line < lines; line++) { /* The size of the bit field is (at least) 32 bits, the least significant section comes first. */
+			bytes[line * LINE_BYTES] = code[index + line] & 0xFF;
+			bytes[line * LINE_BYTES + 1] = (code[index + line] >> 8) & 0xFF;
+			bytes[line * LINE_BYTES + 2] = (code[index + line] >> 16) & 0xFF;
+			bytes[line * LINE_BYTES + 3] = (code[index + line] >> 24) & 0xFF;
+		}
+		hexBlock(fields, bytes);
+
+		for (line = 0; line < lines; line++) {
+			position = putHexLine(reserveHex(writer), counter, width, fields + line * BYTE_FIELD * LINE_BYTES);
+			*position++ = '\n';
+			writer->size = position - writer->buffer;
+			width = addDecimal(counter, width, LINE_BYTES);
+		}
+	}
+}
+
+/**
+ * Writes the given data segment of the given size, starting from the
+ * given address, with the address of every 4 bytes written before them.
+ */
+void writeHexData(HexWriter *writer, const char *dataSegment, unsigned long int dc, unsigned long int address) {
+	unsigned char bytes[HEX_BLOCK]; /* A block of the data segment. */
+	char fields[BYTE_FIELD * HEX_BLOCK]; /* The fields of the block. */
+	char counter[COUNTER_SIZE]; /* The address of the current line. */
+	unsigned long int index, byte, count; /* To loop trough the data segment. */
+	unsigned long int lineAddress = address; /* The address of the current line. */
+	int width; /* The number of digits of the address. */
+	char *position; /* Where the next byte goes. */
+
+	if (dc == 0)
+		return; /* If the data segment is empty then there is nothing to write. */
+
+	width = putDecimal(counter, address, ADDRESS_WIDTH) - counter;
+	position = reserveHex(writer);
+	memcpy(position, counter, width); /* The address of the first line. */
+	position += width;
+	memset(bytes, 0, HEX_BLOCK); /* The last block may not be full. */
+	for (index = 0; index < dc; index += count) {
+		count = dc - index < HEX_BLOCK ? dc - index : HEX_BLOCK;
+		memcpy(bytes, dataSegment + index, count);
+		hexBlock(fields, bytes);
+
+		for (byte = 0; byte < count; byte++) {
+			memcpy(position, fields + BYTE_FIELD * byte, BYTE_FIELD);
+			position += BYTE_FIELD;
+			if (++address % LINE_BYTES == 0) { /* Every 4 bytes, the next address. */
+				writer->size = position - writer->buffer;
+				position = reserveHex(writer);
+				*position++ = '\n';
+				width = addDecimal(counter, width, address - lineAddress);
+				lineAddress = address;
+				memcpy(position, counter, width);
+				position += width;
+			}
+		}
+	}
+
+	writer->size = position - writer->buffer;
+}
+
+/**
+ * Returns the size (in bytes) of the object file of a program with the
+ * given size of the code segment and the given size of the data
+ * segment, loaded from the given address.
+ */
+unsigned long int getHexObjectSize(unsigned long int ic, unsigned long int dc, unsigned long int address) {
+	char header[3 * COUNTER_SIZE]; /* More than the header line. */
+	unsigned long int lines = ic / LINE_BYTES + dc / LINE_BYTES; /* The number of full lines. */
+	unsigned long int size = putDecimal(putDecimal(header, ic, 1), dc, 1) - header + strlen(HEADER_INDENT) + 2; /* The header line, with a space and a new line character. */
+
+	size += lines * LINE_SIZE(0) + addressWidths(address, lines);
+	if (dc > 0) /* The last line of the data segment has no new line character, and an address even if it has no bytes. */
+		size += addressWidths(address + lines * LINE_BYTES, 1) + 3 * (dc % LINE_BYTES);
+	return size;
+}
+
+/**
+ * Fills the given memory, of the size getHexObjectSize returns, with the
+ * object file of the given code segment of the given size and the given
+ * data segment of the given size, loaded from the given address. Just
+ * like a hex writer would write it, but every line is formatted straight
+ * at its offset, split between up to the given number of threads.
+ */
+void fillHexObject(char *object, const Word *code, const char *dataSegment, unsigned long int ic, unsigned long int dc, unsigned long int address, int jobs) {
+	unsigned long int lines = ic / LINE_BYTES + dc / LINE_BYTES; /* The number of full lines. */
+	unsigned char bytes[HEX_BLOCK]; /* The bytes of the last line. */
+	char fields[BYTE_FIELD * HEX_BLOCK]; /* The fields of the last line. */
+	char counter[COUNTER_SIZE]; /* The address of the last line. */
+	char *position = object, *tail; /* The tail is the last line of the data segment. */
+	struct hexjob *work; /* The range of every thread. */
+	pthread_t *threads; /* A thread for every range. */
+	const char *indent = HEADER_INDENT;
+	int job;
+
+	while (*indent != '\0')
+		*position++ = *indent++;
+	position = putDecimal(position, ic, 1);
+	*position++ = ' ';
+	position = putDecimal(position, dc, 1);
+	*position++ = '\n';
+
+	if ((unsigned long int)jobs > lines)
+		jobs = lines > 0 ? lines : 1; /* No thread without lines. */
+	if ((work = malloc(jobs * sizeof(struct hexjob))) == NULL || (threads = malloc(jobs * sizeof(pthread_t))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	for (job = 0; job < jobs; job++) {
+		work[job].code = code;
+		work[job].dataSegment = dataSegment;
+		work[job].codeLines = ic / LINE_BYTES;
+		work[job].first = lines / jobs * job;
+		work[job].last = job == jobs - 1 ? lines : lines / jobs * (job + 1);
+		work[job].address = address + work[job].first * LINE_BYTES;
+		work[job].position = position + work[job].first * LINE_SIZE(0) + addressWidths(address, work[job].first);
+		if (pthread_create(threads + job, NULL, fillHexLines, work + job) != 0)
+			errFatal(); /* Cannot continue without the thread. */
+	}
+	for (job = 0; job < jobs; job++)
+		pthread_join(threads[job], NULL);
+
+	if (dc > 0) { /* The last line of the data segment. */
+		tail = position + lines * LINE_SIZE(0) + addressWidths(address, lines);
+		position = tail + (putDecimal(counter, address + lines * LINE_BYTES, ADDRESS_WIDTH) - counter);
+		memcpy(tail, counter, position - tail);
+		memset(bytes, 0, HEX_BLOCK);
+		memcpy(bytes, dataSegment + dc - dc % LINE_BYTES, dc % LINE_BYTES);
+		hexBlock(fields, bytes);
+		memcpy(position, fields, BYTE_FIELD * (dc % LINE_BYTES));
+	}
+
+	free(work);
+	free(threads);
+}
+
+/**
+ * Writes whatever is left in the buffer of the given hex writer and
+ * frees all the memory used by it. The stream is not closed.
+ */
+void freeHexWriter(HexWriter *writer) {
+	fwrite(writer->buffer, 1, writer->size, writer->output);
+	free(writer->buffer);
+	free(writer);
+}
+
+/**
+ * Makes sure the buffer of the given hex writer has room for a piece of
+ * up to MAX_RECORD_SIZE bytes, writing the buffer if it does not.
+ * Returns the position in the buffer the piece should be formatted at.
+ */
+char *reserveHex(HexWriter *writer) {
+	if (writer->size + MAX_RECORD_SIZE > HEX_BUFFER_SIZE) { /* Writing the buffer to make room. */
+		fwrite(writer->buffer, 1, writer->size, writer->output);
+		writer->size = 0;
+	}
+	return writer->buffer + writer->size;
+}
+
+/**
+ * Formats the given value in decimal at the given position, padded with
+ * zeros to at least the given number of digits.
+ * Returns the position after the last digit.
+ */
+char *putDecimal(char *position, unsigned long int value, int width) {
+	char digits[3 * sizeof(unsigned long int)]; /* More than the digits of the largest value, in reverse. */
+	int count = 0;
+
+	do {
+		digits[count++] = '0' + value % DECIMAL;
+		value /= DECIMAL;
+	} while (value != 0);
+	while (count < width)
+		digits[count++] = '0';
+
+	while (count > 0)
+		*position++ = digits[--count];
+	return position;
+}
+
+/**
+ * Returns the number of digits of the given number of addresses, the
+ * first one is the given address and every other one is LINE_BYTES
+ * after the one before it. Addresses are padded to ADDRESS_WIDTH digits.
+ */
+unsigned long int addressWidths(unsigned long int address, unsigned long int count) {
+	unsigned long int limit = 1, total = 0, lines; /* The first address that takes one more digit. */
+	int width;
+
+	for (width = 0; width < ADDRESS_WIDTH; width++)
+		limit *= DECIMAL;
+	while (count > 0) {
+		for (; address >= limit; width++)
+			limit *= DECIMAL;
+		lines = (limit - address + LINE_BYTES - 1) / LINE_BYTES; /* The addresses before the next width. */
+		if (lines > count)
+			lines = count;
+		total += lines * width;
+		address += lines * LINE_BYTES;
+		count -= lines;
+	}
+	return total;
+}
+
+/**
+ * Formats the range of full lines of the given hex job at its position.
+ * Used as the routine of a thread.
+ */
+void *fillHexLines(void *job) {
+	struct hexjob *work = job;
+	unsigned char bytes[HEX_BLOCK]; /* The bytes of a block of lines. */
+	char fields[BYTE_FIELD * HEX_BLOCK]; /* The fields of the block. */
+	char counter[COUNTER_SIZE]; /* The address of the next line. */
+	unsigned long int line, index, count, data; /* To loop trough the lines. */
+	int width = putDecimal(counter, work->address, ADDRESS_WIDTH) - counter; /* The number of digits of the address. */
+	char *position = work->position;
+
+	memset(bytes, 0, HEX_BLOCK); /* The last block may not be full. */
+	for (line = work->first; line < work->last; line += count) {
+		count = work->last - line < HEX_BLOCK / LINE_BYTES ? work->last - line : HEX_BLOCK / LINE_BYTES;
+		for (index = 0; index < count; index++) {
+			if (line + index < work->codeLines) { /* A code line, the least significant section comes first. */
+				data = work->code[line + index];
+				bytes[index * LINE_BYTES] = data & 0xFF;
+				bytes[index * LINE_BYTES + 1] = (data >> 8) & 0xFF;
+				bytes[index * LINE_BYTES + 2] = (data >> 16) & 0xFF;
+				bytes[index * LINE_BYTES + 3] = (data >> 24) & 0xFF;
+			} else
+				memcpy(bytes + index * LINE_BYTES, work->dataSegment + (line + index - work->codeLines) * LINE_BYTES, LINE_BYTES);
+		}
+		hexBlock(fields, bytes);
+
+		for (index = 0; index < count; index++) {
+			position = putHexLine(position, counter, width, fields + index * BYTE_FIELD * LINE_BYTES);
+			*position++ = '\n';
+			width = addDecimal(counter, width, LINE_BYTES);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Adds the given value, which is smaller than the decimal base, to the
+ * given decimal number of the given number of digits, in place. There
+ * should be room for one more digit after the number.
+ * Returns the number of digits of the result.
+ */
+int addDecimal(char *digits, int width, unsigned int value) {
+	int index = width;
+
+	while (value != 0 && index-- > 0) { /* Adding from the least significant digit. */
+		value += digits[index] - '0';
+		digits[index] = '0' + value % DECIMAL;
+		value /= DECIMAL;
+	}
+	if (value != 0) { /* Carried past the most significant digit. */
+		memmove(digits + 1, digits, width);
+		digits[0] = '0' + value;
+		width++;
+	}
+	return width;
+}
+
+/**
+ * Formats a line of the object file at the given position, without its
+ * new line character: the given address of the given number of digits
+ * and the first 4 of the given fields.
+ * Returns the position after the line.
+ */
+char *putHexLine(char *position, const char *counter, int width, const char *fields) {
+	memcpy(position, counter, width);
+	memcpy(position + width, fields, BYTE_FIELD * LINE_BYTES);
+	return position + width + BYTE_FIELD * LINE_BYTES;
+}
+
+/**
+ * Converts the HEX_BLOCK bytes of the given block into their fields, a
+ * space and the uppercase hexadecimal digits of every byte, the high
+ * digit first.
+ */
+void hexBlock(char *fields, const unsigned char *bytes) {
+#if defined(HEX_AVX2)
+	const __m256i mask = _mm256_set1_epi8(0x0F), nine = _mm256_set1_epi8(9);
+	const __m256i zero = _mm256_set1_epi8('0'), letters = _mm256_set1_epi8('A' - '0' - 10); /* Added to the digits above 9. */
+	__m256i block = _mm256_loadu_si256((const __m256i *)bytes);
+	__m256i high = _mm256_and_si256(_mm256_srli_epi16(block, 4), mask);
+	__m256i low = _mm256_and_si256(block, mask);
+	__m256i chunk;
+	int part;
+
+	high = _mm256_add_epi8(_mm256_add_epi8(high, zero), _mm256_and_si256(_mm256_cmpgt_epi8(high, nine), letters));
+	low = _mm256_add_epi8(_mm256_add_epi8(low, zero), _mm256_and_si256(_mm256_cmpgt_epi8(low, nine), letters));
+	for (part = 0; part < BYTE_FIELD; part++) { /* Every lane spreads its 16 bytes into 48 characters, a third at a time. */
+		chunk = _mm256_or_si256(
+			_mm256_or_si256(_mm256_shuffle_epi8(high, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(highShuffle + part * LANE)))),
+				_mm256_shuffle_epi8(low, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(lowShuffle + part * LANE))))),
+			_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(fieldSpaces + part * LANE))));
+		_mm_storeu_si128((__m128i *)(fields + part * LANE), _mm256_castsi256_si128(chunk));
+		_mm_storeu_si128((__m128i *)(fields + (BYTE_FIELD + part) * LANE), _mm256_extracti128_si256(chunk, 1));
+	}
+#elif defined(HEX_SSE2)
+	const __m128i mask = _mm_set1_epi8(0x0F), nine = _mm_set1_epi8(9);
+	const __m128i zero = _mm_set1_epi8('0'), letters = _mm_set1_epi8('A' - '0' - 10); /* Added to the digits above 9. */
+	__m128i block = _mm_loadu_si128((const __m128i *)bytes);
+	__m128i high = _mm_and_si128(_mm_srli_epi16(block, 4), mask);
+	__m128i low = _mm_and_si128(block, mask);
+	__m128i first = _mm_unpacklo_epi8(high, low); /* The digits of the first 8 bytes, in order. */
+	__m128i second = _mm_unpackhi_epi8(high, low); /* The digits of the last 8 bytes, in order. */
+	char digits[2 * HEX_BLOCK]; /* The digits of the block, without the spaces. */
+	int index;
+
+	first = _mm_add_epi8(_mm_add_epi8(first, zero), _mm_and_si128(_mm_cmpgt_epi8(first, nine), letters));
+	second = _mm_add_epi8(_mm_add_epi8(second, zero), _mm_and_si128(_mm_cmpgt_epi8(second, nine), letters));
+	_mm_storeu_si128((__m128i *)digits, first);
+	_mm_storeu_si128((__m128i *)(digits + HEX_BLOCK), second);
+	for (index = 0; index < HEX_BLOCK; index++) { /* SSE2 has no byte shuffle for the spaces. */
+		*fields++ = ' ';
+		*fields++ = digits[2 * index];
+		*fields++ = digits[2 * index + 1];
+	}
+#else
+	int index;
+
+	for (index = 0; index < HEX_BLOCK; index++) {
+		*fields++ = ' ';
+		*fields++ = hexDigits[bytes[index]][0];
+		*fields++ = hexDigits[bytes[index]][1];
+	}
+#endif
+}
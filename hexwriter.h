@@ -0,0 +1,72 @@
+#ifndef HEXWRITER_H
+#define HEXWRITER_H
+
+#include <stdio.h>
+
+#include "utils.h"
+
+/**
+ * An header file for the hex writer translation unit.
+ */
+
+/**
+ * Defining the hex writer data structure.
+ * Formats the lines of an object file into a large buffer and writes
+ * the buffer into its stream only when it is full, so the object file
+ * takes a few write calls no matter how many lines it has.
+ */
+typedef struct hexwriter HexWriter;
+
+/**
+ * Creates a new hex writer that writes into the given stream, which
+ * should not have been written yet. The stream is left unbuffered since
+ * the writer buffers everything itself.
+ * Returns a pointer to the new writer or a null pointer if the memory
+ * allocation had failed.
+ */
+HexWriter *createHexWriter(FILE *output);
+
+/**
+ * Writes the header line of an object file with the given size of the
+ * code segment and the given size of the data segment.
+ */
+void writeHexHeader(HexWriter *writer, unsigned long int ic, unsigned long int dc);
+
+/**
+ * Writes the given number of bit fields of the given code segment, as
+ * the lines of the object file, starting from the given address.
+ * Every bit field is written between its address and a new line
+ * character and is divided into 8 bit sections separated by spaces,
+ * starting from the least significant section.
+ */
+void writeHexCode(HexWriter *writer, const Word *code, unsigned long int count, unsigned long int address);
+
+/**
+ * Writes the given data segment of the given size, starting from the
+ * given address, with the address of every 4 bytes written before them.
+ */
+void writeHexData(HexWriter *writer, const char *dataSegment, unsigned long int dc, unsigned long int address);
+
+/**
+ * Returns the size (in bytes) of the object file of a program with the
+ * given size of the code segment and the given size of the data
+ * segment, loaded from the given address.
+ */
+unsigned long int getHexObjectSize(unsigned long int ic, unsigned long int dc, unsigned long int address);
+
+/**
+ * Fills the given memory, of the size getHexObjectSize returns, with the
+ * object file of the given code segment of the given size and the given
+ * data segment of the given size, loaded from the given address. Just
+ * like a hex writer would write it, but every line is formatted straight
+ * at its offset, split between up to the given number of threads.
+ */
+void fillHexObject(char *object, const Word *code, const char *dataSegment, unsigned long int ic, unsigned long int dc, unsigned long int address, int jobs);
+
+/**
+ * Writes whatever is left in the buffer of the given hex writer and
+ * frees all the memory used by it. The stream is not closed.
+ */
+void freeHexWriter(HexWriter *writer);
+
+#endif
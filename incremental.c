@@ -0,0 +1,673 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "incremental.h"
+#include "converter.h"
+#include "symboltable.h"
+#include "keywords.h"
+#include "asmutils.h"
+#include "errmsg.h"
+#include "utils.h"
+#include "exports.h"
+
+/**
+ * The incremental translation unit caches the state of every source file
+ * that was assembled successfully: a hash of every line, the encoded code
+ * lines with their label operands, the data of every line and the labels
+ * with the lines that declare them. The next run compares the source file
+ * against the cache and assembles only the lines that were changed, the
+ * rest of the lines are only moved and patched if addresses were shifted.
+ * Changed lines that declare labels or print any message are not handled
+ * here, the file is assembled from scratch in that case. Files with
+ * numeric local labels are not cached at all, since their operands are
+ * not labels of the symbol table and could not be patched.
+ */
+
+#define CACHE_EXTENSION ".cache" /* The extension of the cache files. */
+#define CACHE_MAGIC "ASMCACH1" /* Every cache file starts with that, for validation. */
+#define CACHE_MAGIC_LEN 8 /* The length of the magic string. */
+#define NO_LINE -1 /* The line of labels that are not declared by any line. */
+#define NO_OPERAND -1 /* The operand of lines that have no label operand. */
+#define CODE_LINE_SIZE 4 /* The size of an assembled code line. */
+#define INITIAL_LINES 1024 /* The initial capacity of the lines arrays. */
+
+/**
+ * Defining the cache header data structure.
+ * The sizes of everything that follows it in a cache file.
+ */
+struct cacheheader {
+	char magic[CACHE_MAGIC_LEN]; /* Should be CACHE_MAGIC. */
+	unsigned long int lineCount; /* The number of source lines. */
+	unsigned long int labelCount; /* The number of labels. */
+	unsigned long int ic; /* The size of the code segment. */
+	unsigned long int dc; /* The size of the data segment. */
+};
+
+/**
+ * Defining the cached line data structure.
+ * Everything that is needed to assemble a single source line again
+ * without reading it.
+ */
+struct cachedline {
+	unsigned long int hash; /* The hash of the source line, to find changed lines. */
+	unsigned long int data; /* The bit field of a code line. */
+	long int operand; /* The index of the label operand of a code line, NO_OPERAND if there is none. */
+	unsigned long int dataSize; /* The number of bytes the line adds to the data segment. */
+	char isCode; /* Tells if the line is a code line. */
+	char isRelative; /* Tells if the label operand is relative to the address of the line. */
+	char affectsLabels; /* Tells if the line declares a label or marks it as an entry or external. */
+};
+
+/**
+ * Defining the cached label data structure.
+ * A single label from the symbol table, along with the line that
+ * declares it so its address can be calculated again.
+ */
+struct cachedlabel {
+	char symbol[MAX_LABEL_SIZE + 1]; /* The symbol of the label. */
+	unsigned long int address; /* The address of the label. */
+	long int line; /* The index of the line that declares the label, NO_LINE for external labels. */
+	char isCode, isData, isEntry, isExtern; /* The attributes of the label. */
+};
+
+/**
+ * Defining the cache data structure.
+ * The cached state of a single source file, as it is stored in its
+ * cache file, along with the structures built from it.
+ */
+struct cache {
+	struct cacheheader header; /* The sizes of the arrays. */
+	struct cachedline *lines; /* Every source line, in order. */
+	struct cachedlabel *labels; /* Every label, in the order of the symbol table. */
+	struct cachedlabel **byName; /* The labels sorted by their symbols, for searching. */
+	char *dataSegment; /* The assembled data segment. */
+	SymbolTable *symbolTable; /* A symbol table built from the labels, null until it is needed. */
+};
+
+/**
+ * Defining the scanned line data structure.
+ * A single line of the current source file, as far as it is needed
+ * to compare it against the cache.
+ */
+struct scannedline {
+	unsigned long int hash; /* The hash of the source line. */
+	long int offset; /* The position of the line in the source file. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+char *cacheFileName(const char *fileName);
+struct cache *createCache(unsigned long int lineCount, unsigned long int labelCount, unsigned long int dc);
+struct cache *loadCache(const char *fileName);
+void writeCache(const char *fileName, struct cache *cache);
+void freeCache(struct cache *cache);
+void sortLabels(struct cache *cache);
+int compareLabels(const void *first, const void *second);
+long int findLabel(struct cache *cache, const char *symbol);
+void buildSymbolTable(struct cache *cache);
+Flag lineLabels(char *sourceLine, char *word);
+unsigned long int hashLine(const char *sourceLine, int length, Flag status);
+struct scannedline *scanLines(FILE *file, char *sourceLine, unsigned long int *count);
+Code updateCache(struct cache *cache, FILE *file, const char *fileName, char *sourceLine, struct scannedline *scanned, unsigned long int count, unsigned long int first, unsigned long int last);
+void writeFromCache(struct cache *cache, const char *fileName, Options *options);
+
+/**
+ * Assembles the given source file by reusing the state that was cached
+ * by the last successful run on it, so only the lines that were changed
+ * since then are assembled again.
+ * Returns SUCCESS if the output files and the cache were written, or
+ * ERROR if there is no usable cache or the changes may affect more than
+ * the changed lines, in that case the file should be assembled from
+ * scratch. Either way the given stream is rewound. The given options
+ * choose the format of the output files, and if the exports parameter is
+ * not null the entry and external labels of the file are published into
+ * it.
+ */
+Code assembleIncremental(FILE *file, const char *fileName, Options *options, Exports *exports) {
+	struct cache *cache; /* The state of the last successful run. */
+	struct scannedline *scanned; /* The lines of the source file. */
+	unsigned long int count; /* The number of lines in the source file. */
+	unsigned long int first = 0, last = 0; /* The number of unchanged lines at the beginning and at the end. */
+	unsigned long int cached; /* The number of cached lines. */
+	char *sourceLine = malloc(SOURCE_LINE_LENGTH + 1); /* A buffer for every source line. */
+	Code code = ERROR; /* The result. */
+
+	if (sourceLine == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	if ((cache = loadCache(fileName)) != NULL) {
+		scanned = scanLines(file, sourceLine, &count);
+		cached = cache->header.lineCount;
+
+		/* Skipping the lines that are the same at the beginning and at the end. */
+		while (first < cached && first < count && cache->lines[first].hash == scanned[first].hash)
+			first++;
+		while (last < cached - first && last < count - first && cache->lines[cached - last - 1].hash == scanned[count - last - 1].hash)
+			last++;
+
+		if ((code = updateCache(cache, file, fileName, sourceLine, scanned, count, first, last)) == SUCCESS) {
+			writeFromCache(cache, fileName, options);
+			writeCache(fileName, cache);
+			if (exports != NULL)
+				publishSymbols(exports, cache->symbolTable, fileName); /* Built while writing the output files. */
+		}
+
+		free(scanned);
+		freeCache(cache);
+	}
+
+	free(sourceLine);
+	rewind(file);
+	return code;
+}
+
+/**
+ * Caches the state of the given source file after it was assembled
+ * successfully, for the next incremental run. Expects the given symbol
+ * table to be the one the file was assembled with, and the ic and dc
+ * parameters to equal the size of the code segment and the size of the
+ * data segment respectively. The given stream is rewound.
+ * A file with numeric local labels is not cached, and its old cache file
+ * is removed.
+ */
+void saveIncremental(FILE *file, const char *fileName, SymbolTable *symbolTable, const unsigned long int ic, const unsigned long int dc) {
+	struct cache *cache; /* The state to cache. */
+	struct cachedline *line; /* Every line. */
+	struct cachedlabel *label; /* Every label. */
+	Label edit; /* To loop trough the symbol table. */
+	Label operand; /* The label operand of every code line. */
+	ConvertState *state; /* To assemble every line on its own. */
+	unsigned long int labelCount = 0, lineCapacity = INITIAL_LINES; /* The sizes of the arrays. */
+	unsigned long int address = MEMORY_START_ADDRESS; /* The address of every code line. */
+	unsigned long int dataIndex; /* The data index of every line. */
+	long int index; /* The index of a declared label. */
+	int length; /* Used as length check for extractSourceLine. */
+	char word[MAX_LABEL_SIZE + 1]; /* The label a line declares. */
+	char *sourceLine = malloc(SOURCE_LINE_LENGTH + 1); /* A buffer for every source line. */
+	char *name; /* The name of the cache file. */
+	Flag extracted; /* To catch the end of the file. */
+	Flag status; /* The labels of every line. */
+
+	if (getLocalLabelCount(getLocalLabels(symbolTable)) != 0) { /* The lines that use them could not be patched. */
+		name = cacheFileName(fileName);
+		remove(name); /* The old cache does not match the file anymore. */
+		free(name);
+		free(sourceLine);
+		rewind(file);
+		return;
+	}
+
+	for (edit = getFirst(symbolTable); edit != NO_LABEL; edit = getNext(symbolTable, edit))
+		labelCount++;
+
+	if (sourceLine == NULL || (cache = createCache(lineCapacity, labelCount, dc)) == NULL ||
+		(state = createConvertState(symbolTable, cache->dataSegment, MEMORY_START_ADDRESS, 0, 0)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	/* Copying the labels, their lines are found while scanning the file. */
+	for (edit = getFirst(symbolTable), label = cache->labels; edit != NO_LABEL; edit = getNext(symbolTable, edit), label++) {
+		strcpy(label->symbol, getSymbol(symbolTable, edit));
+		label->address = getAddress(symbolTable, edit);
+		label->line = NO_LINE;
+		label->isCode = hasAttribute(symbolTable, edit, CodeLabel) == SUCCESS;
+		label->isData = hasAttribute(symbolTable, edit, DataLabel) == SUCCESS;
+		label->isEntry = hasAttribute(symbolTable, edit, EntryLabel) == SUCCESS;
+		label->isExtern = hasAttribute(symbolTable, edit, ExternLabel) == SUCCESS;
+	}
+	sortLabels(cache);
+
+	rewind(file);
+	do {
+		if (cache->header.lineCount == lineCapacity) { /* Making room for the line. */
+			lineCapacity *= 2;
+			if ((line = realloc(cache->lines, lineCapacity * sizeof(struct cachedline))) == NULL)
+				errFatal(); /* Cannot continue without memory. */
+			cache->lines = line;
+		}
+		line = cache->lines + cache->header.lineCount;
+		memset(line, 0, sizeof(struct cachedline));
+
+		length = -1; /* The length is set only for lines that are too long. */
+		extracted = extractSourceLine(file, sourceLine, &length);
+		line->hash = hashLine(sourceLine, length, extracted);
+		line->operand = NO_OPERAND;
+
+		status = lineLabels(sourceLine, word);
+		line->affectsLabels = status != NoIssueFlag;
+		if (status == LabelFlag && (index = findLabel(cache, word)) != NO_OPERAND && (cache->labels[index].isCode || cache->labels[index].isData))
+			cache->labels[index].line = cache->header.lineCount; /* This line declares the label. */
+
+		dataIndex = getDataIndex(state);
+		moveConvertState(state, address, dataIndex);
+		if (encodeLine(state, sourceLine, &line->data, &operand, &line->isRelative) == OperatorFlag) {
+			line->isCode = 1;
+			if (operand != NO_LABEL)
+				line->operand = operand - 1; /* The labels were copied in the order of the symbol table. */
+			address += CODE_LINE_SIZE; /* Every code line takes exactly 4 bytes. */
+		}
+		line->dataSize = getDataIndex(state) - dataIndex;
+		cache->header.lineCount++;
+	} while (extracted != EndFileFlag);
+
+	cache->header.ic = ic;
+	writeCache(fileName, cache);
+
+	freeConvertState(state);
+	freeCache(cache);
+	free(sourceLine);
+	rewind(file);
+}
+
+/**
+ * Compares the cached state of a source file against its current lines,
+ * found on the fifth parameter, and updates the cache to match them.
+ * Every line between the first lines and the last lines (as counted by
+ * the last two parameters) is considered changed and is assembled again,
+ * then the labels are positioned again and the operands of the unchanged
+ * code lines are patched if addresses were shifted.
+ * Returns SUCCESS if the cache was updated, or ERROR if one of the
+ * changed lines declares a label, prints a message or uses a label that
+ * does not exist. In that case the cache should not be used.
+ */
+Code updateCache(struct cache *cache, FILE *file, const char *fileName, char *sourceLine, struct scannedline *scanned, unsigned long int count, unsigned long int first, unsigned long int last) {
+	const unsigned long int cachedEnd = cache->header.lineCount - last; /* The end of the changed cached lines. */
+	const unsigned long int end = count - last; /* The end of the changed lines. */
+	struct cachedline *lines; /* The updated lines. */
+	struct cachedlabel *label; /* Every label. */
+	unsigned long int *addresses, *dataIndexes; /* The address and data index of every line. */
+	unsigned long int index; /* To loop trough the lines and labels. */
+	unsigned long int ic, dc, cachedDataEnd = 0; /* The new sizes, and where the unchanged data at the end begins in the cache. */
+	unsigned long int address; /* The address of every label. */
+	char isShifted = 0; /* Tells if any label was moved. */
+	char *dataSegment; /* The updated data segment. */
+	char word[MAX_LABEL_SIZE + 1]; /* To check the labels of every line. */
+	int length; /* Used as length check for extractSourceLine. */
+	Flag status; /* The status of every line. */
+	FILE *messages; /* The messages printed while mapping the changed lines. */
+	MapState *probe; /* Maps the changed lines, to find issues. */
+	ConvertState *state; /* Assembles the changed lines. */
+	Label operand; /* The label operand of every code line. */
+	Code code = SUCCESS; /* The result. */
+
+	/* Cached lines that affect labels cannot be removed without mapping the whole file. */
+	for (index = first; index < cachedEnd; index++)
+		if (cache->lines[index].affectsLabels)
+			return ERROR;
+
+	if ((lines = calloc(count + 1, sizeof(struct cachedline))) == NULL ||
+		(addresses = malloc((count + 1) * sizeof(unsigned long int))) == NULL ||
+		(dataIndexes = malloc((count + 1) * sizeof(unsigned long int))) == NULL ||
+		(messages = tmpfile()) == NULL || (probe = createMapState(fileName, messages)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	/* The unchanged lines are copied as they are. */
+	memcpy(lines, cache->lines, first * sizeof(struct cachedline));
+	memcpy(lines + end, cache->lines + cachedEnd, last * sizeof(struct cachedline));
+
+	/* Mapping the changed lines to find their sizes and any issue in them. */
+	for (index = first; index < end && code == SUCCESS; index++) {
+		fseek(file, scanned[index].offset, SEEK_SET);
+		length = -1; /* The length is set only for lines that are too long. */
+		status = extractSourceLine(file, sourceLine, &length);
+		if (lineLabels(sourceLine, word) != NoIssueFlag) {
+			code = ERROR; /* Declaring labels requires mapping the whole file. */
+			break;
+		}
+		address = getInstructionCounter(probe);
+		dc = getDataCounter(probe);
+		mapLine(probe, sourceLine, index + 1, length, status);
+
+		lines[index].hash = scanned[index].hash;
+		lines[index].operand = NO_OPERAND;
+		lines[index].isCode = getInstructionCounter(probe) != address;
+		lines[index].dataSize = getDataCounter(probe) - dc;
+	}
+	if (ftell(messages) != 0)
+		code = ERROR; /* The changed lines have issues, the whole file should be mapped to print them in order. */
+	freeMapState(probe);
+	fclose(messages);
+
+	if (code == SUCCESS) {
+		/* Positioning every line. */
+		for (index = 0, ic = MEMORY_START_ADDRESS, dc = 0; index < count; index++) {
+			addresses[index] = ic;
+			dataIndexes[index] = dc;
+			ic += lines[index].isCode ? CODE_LINE_SIZE : 0;
+			dc += lines[index].dataSize;
+		}
+		addresses[count] = ic; /* The end of the file. */
+		dataIndexes[count] = dc;
+		ic -= MEMORY_START_ADDRESS;
+		for (index = 0; index < cachedEnd; index++)
+			cachedDataEnd += cache->lines[index].dataSize;
+
+		/* Positioning the labels, their lines may have moved as well. */
+		for (index = 0, label = cache->labels; index < cache->header.labelCount; index++, label++) {
+			if (label->line == NO_LINE)
+				continue; /* External labels have no address. */
+			if (label->line >= (long int)cachedEnd)
+				label->line += end - cachedEnd;
+			address = label->isCode ? addresses[label->line] : MEMORY_START_ADDRESS + ic + dataIndexes[label->line];
+			if (address != label->address)
+				isShifted = 1;
+			label->address = address;
+		}
+
+		/* Moving the data segment around the changed lines. */
+		if ((dataSegment = malloc(dc + 1)) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		memcpy(dataSegment, cache->dataSegment, dataIndexes[first]);
+		memcpy(dataSegment + dataIndexes[end], cache->dataSegment + cachedDataEnd, cache->header.dc - cachedDataEnd);
+		free(cache->dataSegment);
+		cache->dataSegment = dataSegment;
+
+		/* Assembling the changed lines. */
+		buildSymbolTable(cache);
+		if ((state = createConvertState(cache->symbolTable, dataSegment, MEMORY_START_ADDRESS, 0, 0)) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		for (index = first; index < end && code == SUCCESS; index++) {
+			fseek(file, scanned[index].offset, SEEK_SET);
+			length = -1; /* The length is set only for lines that are too long. */
+			extractSourceLine(file, sourceLine, &length);
+			moveConvertState(state, addresses[index], dataIndexes[index]);
+			status = encodeLine(state, sourceLine, &lines[index].data, &operand, &lines[index].isRelative);
+			if (status == IllegalSymbolFlag)
+				code = ERROR; /* An undeclared label, the whole file should be mapped to print it. */
+			else if (status == OperatorFlag && operand != NO_LABEL)
+				lines[index].operand = operand - 1; /* The symbol table was built in the order of the cached labels. */
+		}
+		freeConvertState(state);
+
+		/* Patching the operands of the unchanged lines if anything was moved. */
+		if (isShifted || ic != cache->header.ic)
+			for (index = 0; index < count; index++)
+				if ((index < first || index >= end) && lines[index].operand != NO_OPERAND)
+					lines[index].data = relocateOperand(lines[index].data, cache->labels[lines[index].operand].address,
+						addresses[index], lines[index].isRelative);
+
+		cache->header.ic = ic;
+		cache->header.dc = dc;
+	}
+
+	/* The cache holds the updated lines from now on. */
+	free(cache->lines);
+	cache->lines = lines;
+	cache->header.lineCount = count;
+
+	free(addresses);
+	free(dataIndexes);
+	return code;
+}
+
+/**
+ * Writes the output files of the given source file from the given cache,
+ * in the format the given options choose.
+ */
+void writeFromCache(struct cache *cache, const char *fileName, Options *options) {
+	struct cachedline *line; /* Every line. */
+	Label label; /* The external label operand of every line. */
+	ConvertState *state; /* Keeps the code lines in order. */
+	unsigned long int index; /* To loop trough the lines. */
+
+	if (cache->symbolTable == NULL)
+		buildSymbolTable(cache); /* Nothing was assembled, so it was not built yet. */
+	if ((state = createConvertState(cache->symbolTable, cache->dataSegment, MEMORY_START_ADDRESS, 0, cache->header.ic)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	for (index = 0, line = cache->lines; index < cache->header.lineCount; index++, line++) {
+		if (!line->isCode)
+			continue;
+		label = NO_LABEL;
+		if (line->operand != NO_OPERAND && !line->isRelative && cache->labels[line->operand].isExtern) /* Only J operators reference external labels. */
+			label = line->operand + 1; /* The symbol table was built in the order of the cached labels. */
+		addCode(state, line->data, label);
+	}
+
+	writeAssembled(fileName, state, cache->dataSegment, cache->header.ic, cache->header.dc, options);
+	freeConvertState(state);
+}
+
+/**
+ * Reads every line of the given stream from its beginning and returns
+ * an array with the hash and position of every line, the number of lines
+ * is set into the last parameter.
+ * Expects the second parameter to be a buffer SOURCE_LINE_LENGTH + 1 long.
+ */
+struct scannedline *scanLines(FILE *file, char *sourceLine, unsigned long int *count) {
+	unsigned long int capacity = INITIAL_LINES; /* The capacity of the array. */
+	struct scannedline *lines = malloc(capacity * sizeof(struct scannedline)); /* The result. */
+	struct scannedline *line; /* Every line. */
+	int length; /* Used as length check for extractSourceLine. */
+	Flag status; /* To catch the end of the file. */
+
+	if (lines == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	rewind(file);
+	*count = 0;
+	do {
+		if (*count == capacity) { /* Making room for the line. */
+			capacity *= 2;
+			if ((line = realloc(lines, capacity * sizeof(struct scannedline))) == NULL)
+				errFatal(); /* Cannot continue without memory. */
+			lines = line;
+		}
+		line = lines + (*count)++;
+		line->offset = ftell(file);
+		length = -1; /* The length is set only for lines that are too long. */
+		status = extractSourceLine(file, sourceLine, &length);
+		line->hash = hashLine(sourceLine, length, status);
+	} while (status != EndFileFlag);
+
+	return lines;
+}
+
+/**
+ * Hashes the given source line along with the results of the
+ * extractSourceLine function, so lines that are too long or that end
+ * the file are different from their shorter forms.
+ */
+unsigned long int hashLine(const char *sourceLine, int length, Flag status) {
+	unsigned long int hash = hashBytes(sourceLine, strlen(sourceLine), 0);
+
+	hash = hashBytes(&length, sizeof(length), hash);
+	return hashBytes(&status, sizeof(status), hash);
+}
+
+/**
+ * Checks if the given source line affects the symbol table other than by
+ * using labels as operands.
+ * Returns LabelFlag if the line declares a label, in that case the label
+ * is copied into the last parameter, InstructorFlag if the line marks a
+ * label as an entry or external label and NoIssueFlag otherwise.
+ */
+Flag lineLabels(char *sourceLine, char *word) {
+	char buffer[SOURCE_LINE_LENGTH + 1]; /* Holds the words of the line, they may be longer than a label. */
+	int index = 0; /* The line start at index 0. */
+	Expectation expecting; /* To use the getWord function. */
+	const Instructor *instructor; /* The instructor of the line. */
+	Flag status = getWord(sourceLine, &expecting, &index, buffer); /* Extracting the beginning of the line. */
+
+	if (status == LabelFlag) {
+		strncpy(word, buffer, MAX_LABEL_SIZE);
+		word[MAX_LABEL_SIZE] = '\0';
+		return LabelFlag;
+	}
+	if (status == InstructorFlag && (instructor = searchInstructorByString(buffer)) != NULL &&
+		(getExpectation(instructor) == ExpectLabelEntry || getExpectation(instructor) == ExpectLabelExternal))
+		return InstructorFlag;
+	return NoIssueFlag;
+}
+
+/**
+ * Returns a pointer to the name of the cache file of the given source
+ * file. The returned string should be freed by the caller.
+ */
+char *cacheFileName(const char *fileName) {
+	const size_t baseLength = strlen(fileName) - FILE_EXTENSION_LEN; /* The name without the extension. */
+	char *name = malloc(baseLength + strlen(CACHE_EXTENSION) + 1);
+
+	if (name == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	memcpy(name, fileName, baseLength);
+	strcpy(name + baseLength, CACHE_EXTENSION);
+
+	return name;
+}
+
+/**
+ * Creates a new empty cache with room for the given number of lines and
+ * labels, and the given size of data segment.
+ * Returns a pointer to the new cache or a null pointer if the memory
+ * allocation had failed.
+ */
+struct cache *createCache(unsigned long int lineCount, unsigned long int labelCount, unsigned long int dc) {
+	struct cache *cache = calloc(1, sizeof(struct cache)); /* Every field starts empty. */
+
+	if (cache == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	memcpy(cache->header.magic, CACHE_MAGIC, CACHE_MAGIC_LEN);
+	cache->header.labelCount = labelCount;
+	cache->header.dc = dc;
+
+	/* Allocating one more of everything, so empty files are no special case. */
+	if ((cache->lines = calloc(lineCount + 1, sizeof(struct cachedline))) == NULL ||
+		(cache->labels = calloc(labelCount + 1, sizeof(struct cachedlabel))) == NULL ||
+		(cache->byName = calloc(labelCount + 1, sizeof(struct cachedlabel *))) == NULL ||
+		(cache->dataSegment = malloc(dc + 1)) == NULL) {
+		freeCache(cache);
+		return NULL; /* Memory allocation failed. */
+	}
+
+	return cache;
+}
+
+/**
+ * Reads the cache file of the given source file.
+ * Returns a pointer to the cache, or a null pointer if there is no cache
+ * file or it is not valid.
+ */
+struct cache *loadCache(const char *fileName) {
+	char *name = cacheFileName(fileName); /* The name of the cache file. */
+	FILE *file = fopen(name, "rb");
+	struct cacheheader header; /* The sizes of the cache. */
+	struct cache *cache = NULL; /* The result. */
+
+	free(name);
+	if (file == NULL)
+		return NULL; /* There is no cache. */
+
+	if (fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, CACHE_MAGIC, CACHE_MAGIC_LEN) == 0) {
+		if ((cache = createCache(header.lineCount, header.labelCount, header.dc)) == NULL)
+			errFatal(); /* Cannot continue without memory. */
+		cache->header = header;
+		if (fread(cache->lines, sizeof(struct cachedline), header.lineCount, file) != header.lineCount ||
+			fread(cache->labels, sizeof(struct cachedlabel), header.labelCount, file) != header.labelCount ||
+			fread(cache->dataSegment, 1, header.dc, file) != header.dc) {
+			freeCache(cache);
+			cache = NULL; /* The cache is not complete. */
+		} else
+			sortLabels(cache);
+	}
+
+	fclose(file);
+	return cache;
+}
+
+/**
+ * Writes the given cache into the cache file of the given source file.
+ * The cache is only an optimization, so nothing is reported if it
+ * cannot be written.
+ */
+void writeCache(const char *fileName, struct cache *cache) {
+	char *name = cacheFileName(fileName); /* The name of the cache file. */
+	FILE *file = fopen(name, "wb");
+
+	if (file != NULL) {
+		fwrite(&cache->header, sizeof(cache->header), 1, file);
+		fwrite(cache->lines, sizeof(struct cachedline), cache->header.lineCount, file);
+		fwrite(cache->labels, sizeof(struct cachedlabel), cache->header.labelCount, file);
+		fwrite(cache->dataSegment, 1, cache->header.dc, file);
+		fclose(file);
+	}
+	free(name);
+}
+
+/**
+ * Frees all the memory used by the given cache.
+ */
+void freeCache(struct cache *cache) {
+	if (cache->symbolTable != NULL)
+		freeSymbolTable(cache->symbolTable);
+	free(cache->lines);
+	free(cache->labels);
+	free(cache->byName);
+	free(cache->dataSegment);
+	free(cache);
+}
+
+/**
+ * Sorts the labels of the given cache by their symbols into its byName
+ * array, so they can be searched.
+ */
+void sortLabels(struct cache *cache) {
+	unsigned long int index;
+
+	for (index = 0; index < cache->header.labelCount; index++)
+		cache->byName[index] = cache->labels + index;
+	qsort(cache->byName, cache->header.labelCount, sizeof(struct cachedlabel *), compareLabels);
+}
+
+/**
+ * Compares two cached labels by their symbols, used for sorting and
+ * searching.
+ */
+int compareLabels(const void *first, const void *second) {
+	return strcmp((*(struct cachedlabel * const *)first)->symbol, (*(struct cachedlabel * const *)second)->symbol);
+}
+
+/**
+ * Returns the index of the label with the given symbol in the given
+ * cache, or NO_OPERAND if there is no such label.
+ */
+long int findLabel(struct cache *cache, const char *symbol) {
+	struct cachedlabel key; /* To search by the symbol. */
+	struct cachedlabel *pointer = &key; /* The array holds pointers. */
+	struct cachedlabel **found; /* The result. */
+
+	strncpy(key.symbol, symbol, MAX_LABEL_SIZE);
+	key.symbol[MAX_LABEL_SIZE] = '\0';
+	found = bsearch(&pointer, cache->byName, cache->header.labelCount, sizeof(struct cachedlabel *), compareLabels);
+
+	return found == NULL ? NO_OPERAND : *found - cache->labels;
+}
+
+/**
+ * Builds a symbol table from the labels of the given cache, in the order
+ * of the cached labels, so the cached label at index n is label n + 1 of
+ * the symbol table. Expects the cache to have no symbol table yet.
+ */
+void buildSymbolTable(struct cache *cache) {
+	struct cachedlabel *label; /* Every label. */
+	Label last; /* The newest label of the symbol table. */
+	unsigned long int index;
+
+	if ((cache->symbolTable = createSymbolTable()) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	for (index = 0, label = cache->labels; index < cache->header.labelCount; index++, label++) {
+		if ((last = addSymbol(cache->symbolTable, label->symbol, label->address)) == NO_LABEL)
+			errFatal(); /* Cannot continue without memory. */
+		if (label->isCode)
+			addAttribute(cache->symbolTable, last, CodeLabel);
+		if (label->isData)
+			addAttribute(cache->symbolTable, last, DataLabel);
+		if (label->isEntry)
+			addAttribute(cache->symbolTable, last, EntryLabel);
+		if (label->isExtern)
+			addAttribute(cache->symbolTable, last, ExternLabel);
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdio.h>
+
+#include "symboltable.h"
+#include "options.h"
+#include "exports.h"
+
+/**
+ * An header file for the incremental translation unit.
+ */
+
+/**
+ * Assembles the given source file by reusing the state that was cached
+ * by the last successful run on it, so only the lines that were changed
+ * since then are assembled again.
+ * Returns SUCCESS if the output files and the cache were written, or
+ * ERROR if there is no usable cache or the changes may affect more than
+ * the changed lines, in that case the file should be assembled from
+ * scratch. Either way the given stream is rewound. The given options
+ * choose the format of the output files, and if the exports parameter is
+ * not null the entry and external labels of the file are published into
+ * it.
+ */
+Code assembleIncremental(FILE *file, const char *fileName, Options *options, Exports *exports);
+
+/**
+ * Caches the state of the given source file after it was assembled
+ * successfully, for the next incremental run. Expects the given symbol
+ * table to be the one the file was assembled with, and the ic and dc
+ * parameters to equal the size of the code segment and the size of the
+ * data segment respectively. The given stream is rewound.
+ */
+void saveIncremental(FILE *file, const char *fileName, SymbolTable *symbolTable, const unsigned long int ic, const unsigned long int dc);
+
+#endif
@@ -0,0 +1,508 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/**
+ * A build time generator for the instruction set of the assembler. Reads the
+ * declarative description of the instruction formats, operators and
+ * instructors (isa.def) and writes two headers from it:
+ * isa.h - the format codes, the layout of every format and an encoder macro
+ *         for every format that builds a bit field with shifts and masks.
+ * isatables.h - constant keyword tables for the keywords translation unit,
+ *               with perfect hash tables for looking up the keywords.
+ * Usage: isagen <description> <isa header> <tables header>
+ */
+
+#define LINE_LENGTH 256 /* The maximum length of a description line. */
+#define NAME_LENGTH 32 /* The maximum length of a name in the description, including the null character. */
+#define MAX_FORMATS 8 /* The maximum number of formats. */
+#define MAX_FIELDS 8 /* The maximum number of fields in a format. */
+#define MAX_KEYWORDS 64 /* The maximum number of operators, and of instructors. */
+#define MAX_SLOTS 256 /* The maximum size of a hash table. */
+#define MAX_MULTIPLIER 32 /* The hash multipliers are searched below this value. */
+#define WORD_SIZE 32 /* The size of every format in bits. */
+#define COMMENT '#' /* Starts a comment line. */
+#define FIELD_SEPARATOR ':' /* Separates the name of a field from its size. */
+#define UNUSED_FIELD "-" /* The name of a field that is always zero. */
+#define DELIMITERS " \t\r\n" /* Separates the words of a line. */
+#define FORMAT_KEYWORD "format"
+#define OPERATOR_KEYWORD "operator"
+#define INSTRUCTOR_KEYWORD "instructor"
+#define EMPTY_SLOT -1 /* Marks a hash table slot without a keyword. */
+
+/**
+ * Defining the field data structure.
+ * A bit field inside a format.
+ */
+struct field {
+	char name[NAME_LENGTH]; /* The name of the field, UNUSED_FIELD if it is always zero. */
+	int bits; /* The size of the field. */
+	int shift; /* The position of the least significant bit of the field. */
+};
+
+/**
+ * Defining the format data structure.
+ * The layout of one type of instruction.
+ */
+struct format {
+	char name[NAME_LENGTH]; /* The name of the format, also the name of its code. */
+	struct field fields[MAX_FIELDS]; /* The fields, from the most significant one. */
+	int fieldCount; /* The number of fields. */
+};
+
+/**
+ * Defining the keyword data structure.
+ * An operator or an instructor.
+ */
+struct keyword {
+	char name[NAME_LENGTH]; /* The keyword itself. */
+	char value[NAME_LENGTH]; /* The format of an operator or the expectation of an instructor. */
+	long int opcode; /* The opcode of an operator. */
+	long int funct; /* The funct code of an operator. */
+};
+
+/**
+ * Defining the hash data structure.
+ * A perfect hash table over a set of keywords, the hash of a keyword is
+ * first * its first character + second * its second character +
+ * last * its last character + its length, reduced to the size of the table.
+ */
+struct hash {
+	int size; /* The number of slots, a power of two. */
+	unsigned int first, second, last; /* The multipliers. */
+	int slots[MAX_SLOTS]; /* The index of the keyword in every slot, or EMPTY_SLOT. */
+};
+
+/**
+ * Defining the isa data structure.
+ * Everything that was read from the description.
+ */
+struct isa {
+	struct format formats[MAX_FORMATS];
+	int formatCount;
+	struct keyword operators[MAX_KEYWORDS];
+	int operatorCount;
+	struct keyword instructors[MAX_KEYWORDS];
+	int instructorCount;
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+int readIsa(FILE *file, const char *fileName, struct isa *isa);
+int parseFormat(struct isa *isa);
+int parseOperator(struct isa *isa);
+int parseInstructor(struct isa *isa);
+int copyName(char *dest, const char *name);
+int findFormat(struct isa *isa, const char *name);
+int findHash(struct keyword *keywords, int count, struct hash *hash);
+unsigned int hashKeyword(const char *keyword, struct hash *hash);
+int maxLength(struct keyword *keywords, int count);
+void writeUpper(FILE *output, const char *name);
+void writeIsa(FILE *output, struct isa *isa);
+void writeTables(FILE *output, struct isa *isa, struct hash *operatorHash, struct hash *instructorHash);
+void writeHash(FILE *output, const char *name, struct hash *hash);
+void writeSlots(FILE *output, const char *name, const char *size, struct hash *hash);
+
+/**
+ * Reads the description given as the first argument and writes the headers
+ * given as the second and third arguments.
+ * Returns EXIT_SUCCESS if both headers were written, otherwise EXIT_FAILURE.
+ */
+int main(int argc, char const *argv[]) {
+	static struct isa isa; /* Too large for the stack of some systems. */
+	static struct hash operatorHash, instructorHash;
+	FILE *file; /* Used for accessing files as streams. */
+
+	if (argc != 4) {
+		fprintf(stderr, "Usage: %s <description> <isa header> <tables header>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* Reading the description. */
+	if ((file = fopen(argv[1], "r")) == NULL) {
+		fprintf(stderr, "Could not access this file: %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	if (!readIsa(file, argv[1], &isa)) {
+		fclose(file);
+		return EXIT_FAILURE;
+	}
+	fclose(file);
+
+	/* The keywords are fixed, so there is a hash that tells all of them apart. */
+	if (!findHash(isa.operators, isa.operatorCount, &operatorHash) || !findHash(isa.instructors, isa.instructorCount, &instructorHash)) {
+		fprintf(stderr, "%s: could not find a perfect hash for the keywords\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	/* Writing the headers. */
+	if ((file = fopen(argv[2], "w")) == NULL) {
+		fprintf(stderr, "Could not create this file: %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+	writeIsa(file, &isa);
+	fclose(file);
+	if ((file = fopen(argv[3], "w")) == NULL) {
+		fprintf(stderr, "Could not create this file: %s\n", argv[3]);
+		return EXIT_FAILURE;
+	}
+	writeTables(file, &isa, &operatorHash, &instructorHash);
+	fclose(file);
+
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Reads the given description into the given isa object.
+ * Returns non zero on success, otherwise prints the line of the issue and
+ * returns zero.
+ */
+int readIsa(FILE *file, const char *fileName, struct isa *isa) {
+	char line[LINE_LENGTH + 1]; /* The current line. */
+	long int lineNum = 0; /* The number of the current line. */
+	char *word; /* The first word of the line. */
+	int isValid; /* Tells if the line was parsed. */
+
+	isa->formatCount = isa->operatorCount = isa->instructorCount = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		lineNum++;
+		word = strtok(line, DELIMITERS);
+		if (word == NULL || *word == COMMENT)
+			continue; /* Empty or comment line. */
+
+		/* The first word tells what the line declares, the rest is parsed by the related function. */
+		if (strcmp(word, FORMAT_KEYWORD) == 0)
+			isValid = parseFormat(isa);
+		else if (strcmp(word, OPERATOR_KEYWORD) == 0)
+			isValid = parseOperator(isa);
+		else if (strcmp(word, INSTRUCTOR_KEYWORD) == 0)
+			isValid = parseInstructor(isa);
+		else
+			isValid = 0;
+
+		if (!isValid) {
+			fprintf(stderr, "%s:%ld: invalid declaration '%s'\n", fileName, lineNum, word);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Parses the rest of a format declaration, which is being read by strtok.
+ * Returns non zero if the declaration is valid, otherwise zero.
+ */
+int parseFormat(struct isa *isa) {
+	struct format *format = &isa->formats[isa->formatCount]; /* The new format. */
+	struct field *field; /* The current field. */
+	char *word, *separator; /* The current word and the separator inside it. */
+	int bits = 0, index; /* The total size of the fields. */
+
+	if (isa->formatCount == MAX_FORMATS || (word = strtok(NULL, DELIMITERS)) == NULL || !copyName(format->name, word) || findFormat(isa, word) >= 0)
+		return 0;
+
+	/* Reading the fields, from the most significant one. */
+	for (format->fieldCount = 0; (word = strtok(NULL, DELIMITERS)) != NULL; format->fieldCount++) {
+		field = &format->fields[format->fieldCount];
+		if (format->fieldCount == MAX_FIELDS || (separator = strchr(word, FIELD_SEPARATOR)) == NULL)
+			return 0;
+		*separator = '\0'; /* Separating the name from the size. */
+		if (!copyName(field->name, word) || (field->bits = atoi(separator + 1)) <= 0)
+			return 0;
+		bits += field->bits;
+	}
+	if (format->fieldCount == 0 || bits != WORD_SIZE)
+		return 0; /* Every format is one word. */
+
+	/* Placing the fields, the first one is the most significant. */
+	for (index = 0; index < format->fieldCount; index++) {
+		bits -= format->fields[index].bits;
+		format->fields[index].shift = bits;
+	}
+
+	isa->formatCount++;
+	return 1;
+}
+
+/**
+ * Parses the rest of an operator declaration, which is being read by strtok.
+ * Returns non zero if the declaration is valid, otherwise zero.
+ */
+int parseOperator(struct isa *isa) {
+	struct keyword *operator = &isa->operators[isa->operatorCount]; /* The new operator. */
+	char *keyword, *format, *opcode, *funct; /* The words of the declaration. */
+
+	if (isa->operatorCount == MAX_KEYWORDS)
+		return 0;
+	keyword = strtok(NULL, DELIMITERS);
+	format = strtok(NULL, DELIMITERS);
+	opcode = strtok(NULL, DELIMITERS);
+	funct = strtok(NULL, DELIMITERS);
+	if (funct == NULL || strtok(NULL, DELIMITERS) != NULL)
+		return 0; /* Wrong number of words. */
+	if (!copyName(operator->name, keyword) || findFormat(isa, format) < 0 || !copyName(operator->value, format))
+		return 0;
+	operator->opcode = atol(opcode);
+	operator->funct = atol(funct);
+
+	isa->operatorCount++;
+	return 1;
+}
+
+/**
+ * Parses the rest of an instructor declaration, which is being read by strtok.
+ * Returns non zero if the declaration is valid, otherwise zero.
+ */
+int parseInstructor(struct isa *isa) {
+	struct keyword *instructor = &isa->instructors[isa->instructorCount]; /* The new instructor. */
+	char *keyword, *expectation; /* The words of the declaration. */
+
+	if (isa->instructorCount == MAX_KEYWORDS)
+		return 0;
+	keyword = strtok(NULL, DELIMITERS);
+	expectation = strtok(NULL, DELIMITERS);
+	if (expectation == NULL || strtok(NULL, DELIMITERS) != NULL)
+		return 0; /* Wrong number of words. */
+	if (!copyName(instructor->name, keyword) || !copyName(instructor->value, expectation))
+		return 0;
+
+	isa->instructorCount++;
+	return 1;
+}
+
+/**
+ * Copies the given name into the given buffer of NAME_LENGTH characters.
+ * Returns non zero if the name fits, otherwise zero.
+ */
+int copyName(char *dest, const char *name) {
+	if (strlen(name) >= NAME_LENGTH)
+		return 0;
+	strcpy(dest, name);
+	return 1;
+}
+
+/**
+ * Returns the index of the format with the given name, or -1 if there is
+ * no such format.
+ */
+int findFormat(struct isa *isa, const char *name) {
+	int index;
+
+	for (index = 0; index < isa->formatCount; index++)
+		if (strcmp(isa->formats[index].name, name) == 0)
+			return index;
+
+	return -1;
+}
+
+/**
+ * Searches for the smallest hash table, and the multipliers for it, in
+ * which no two of the given keywords share a slot. The table is at least
+ * as large as the number of keywords.
+ * Returns non zero if such a hash was found, otherwise zero.
+ */
+int findHash(struct keyword *keywords, int count, struct hash *hash) {
+	int index, slot;
+
+	for (hash->size = 1; hash->size < count; hash->size <<= 1)
+		; /* The smallest power of two that can hold every keyword. */
+
+	for (; hash->size <= MAX_SLOTS; hash->size <<= 1)
+		for (hash->first = 0; hash->first < MAX_MULTIPLIER; hash->first++)
+			for (hash->second = 0; hash->second < MAX_MULTIPLIER; hash->second++)
+				for (hash->last = 0; hash->last < MAX_MULTIPLIER; hash->last++) {
+					for (slot = 0; slot < hash->size; slot++)
+						hash->slots[slot] = EMPTY_SLOT;
+					/* Placing the keywords until two of them share a slot. */
+					for (index = 0; index < count; index++) {
+						slot = hashKeyword(keywords[index].name, hash) & (hash->size - 1);
+						if (hash->slots[slot] != EMPTY_SLOT)
+							break;
+						hash->slots[slot] = index;
+					}
+					if (index == count)
+						return 1; /* Every keyword has its own slot. */
+				}
+
+	return 0;
+}
+
+/**
+ * Returns the hash of the given keyword with the multipliers of the given
+ * hash, before it is reduced to the size of the table. Must match the
+ * hash macros written into the tables header.
+ */
+unsigned int hashKeyword(const char *keyword, struct hash *hash) {
+	const unsigned char *c = (const unsigned char *)keyword; /* Characters are hashed as unsigned values. */
+	const size_t length = strlen(keyword);
+
+	return c[0] * hash->first + c[1] * hash->second + c[length - 1] * hash->last + (unsigned int)length;
+}
+
+/**
+ * Returns the length of the longest of the given keywords.
+ */
+int maxLength(struct keyword *keywords, int count) {
+	int index, length = 0;
+
+	for (index = 0; index < count; index++)
+		if ((int)strlen(keywords[index].name) > length)
+			length = strlen(keywords[index].name);
+
+	return length;
+}
+
+/**
+ * Writes the given name into the given stream in upper case.
+ */
+void writeUpper(FILE *output, const char *name) {
+	for (; *name != '\0'; name++)
+		fputc(toupper((unsigned char)*name), output);
+}
+
+/**
+ * Writes the isa header, the format codes, the layout of every format and
+ * an encoder macro for every format.
+ */
+void writeIsa(FILE *output, struct isa *isa) {
+	struct format *format;
+	struct field *field;
+	int index, fieldIndex;
+	char isFirst; /* To separate the parameters of the encoders. */
+
+	fprintf(output, "#ifndef ISA_H\n#define ISA_H\n\n");
+	fprintf(output, "/**\n * Generated by isagen from isa.def, changes should be made there.\n");
+	fprintf(output, " * The instruction formats of the assembler, their codes and the layout of\n");
+	fprintf(output, " * their bit fields. Every format has an encoder macro that builds its bit\n");
+	fprintf(output, " * field from the values of its fields, from the most significant one.\n */\n\n");
+
+	/* The format codes. */
+	for (index = 0; index < isa->formatCount; index++)
+		fprintf(output, "#define %s %d /* Operator code for type %s. */\n", isa->formats[index].name, index + 1, isa->formats[index].name);
+
+	for (index = 0; index < isa->formatCount; index++) {
+		format = &isa->formats[index];
+		fprintf(output, "\n/* The layout of type %s. */\n", format->name);
+
+		/* The position and the size of every field. */
+		for (fieldIndex = 0; fieldIndex < format->fieldCount; fieldIndex++) {
+			field = &format->fields[fieldIndex];
+			if (strcmp(field->name, UNUSED_FIELD) == 0)
+				continue;
+			fprintf(output, "#define %s_", format->name);
+			writeUpper(output, field->name);
+			fprintf(output, "_SHIFT %d\n", field->shift);
+			fprintf(output, "#define %s_", format->name);
+			writeUpper(output, field->name);
+			fprintf(output, "_MASK 0x%lXUL\n", (1UL << field->bits) - 1);
+		}
+
+		/* The encoder. */
+		fprintf(output, "#define ENCODE_%s(", format->name);
+		for (fieldIndex = 0, isFirst = 1; fieldIndex < format->fieldCount; fieldIndex++) {
+			if (strcmp(format->fields[fieldIndex].name, UNUSED_FIELD) == 0)
+				continue;
+			if (!isFirst)
+				fputs(", ", output);
+			fputs(format->fields[fieldIndex].name, output);
+			isFirst = 0;
+		}
+		fprintf(output, ") (");
+		for (fieldIndex = 0, isFirst = 1; fieldIndex < format->fieldCount; fieldIndex++) {
+			field = &format->fields[fieldIndex];
+			if (strcmp(field->name, UNUSED_FIELD) == 0)
+				continue;
+			if (!isFirst)
+				fputs(" | ", output);
+			fprintf(output, "(((unsigned long int)(%s) & %s_", field->name, format->name);
+			writeUpper(output, field->name);
+			fprintf(output, "_MASK) << %s_", format->name);
+			writeUpper(output, field->name);
+			fprintf(output, "_SHIFT)");
+			isFirst = 0;
+		}
+		fprintf(output, ")\n");
+	}
+
+	fprintf(output, "\n#endif\n");
+}
+
+/**
+ * Writes the tables header, the keyword tables and their hash tables.
+ * The keyword tables are initialized in the order of the fields of the
+ * operator and instructor structures of the keywords translation unit.
+ */
+void writeTables(FILE *output, struct isa *isa, struct hash *operatorHash, struct hash *instructorHash) {
+	struct keyword *keyword;
+	int index;
+	int length = maxLength(isa->operators, isa->operatorCount); /* The length of the longest keyword. */
+
+	if (maxLength(isa->instructors, isa->instructorCount) > length)
+		length = maxLength(isa->instructors, isa->instructorCount);
+
+	fprintf(output, "/**\n * Generated by isagen from isa.def, changes should be made there.\n");
+	fprintf(output, " * The keyword tables of the keywords translation unit, it should be included\n");
+	fprintf(output, " * after the operator and instructor structures are defined.\n */\n\n");
+
+	fprintf(output, "#define OP_COUNT %d /* Number of assembly operators. */\n", isa->operatorCount);
+	fprintf(output, "#define INS_COUNT %d /* Number of assembly instructors. */\n", isa->instructorCount);
+	fprintf(output, "#define OP_SLOTS %d /* Number of slots in the operators hash table, a power of two. */\n", operatorHash->size);
+	fprintf(output, "#define INS_SLOTS %d /* Number of slots in the instructors hash table, a power of two. */\n", instructorHash->size);
+	fprintf(output, "#define MAX_KEYWORD_LENGTH %d /* The length of the longest keyword. */\n\n", length);
+	writeHash(output, "OPERATOR", operatorHash);
+	writeHash(output, "INSTRUCTOR", instructorHash);
+
+	/* The operators, as keyword, length, type, funct and opcode. */
+	fprintf(output, "\n/**\n * The assembly operators.\n */\n");
+	fprintf(output, "static const Operator operators[OP_COUNT] = {\n");
+	for (index = 0; index < isa->operatorCount; index++) {
+		keyword = &isa->operators[index];
+		fprintf(output, "\t{\"%s\", %d, %s, %ld, %ld}%s\n", keyword->name, (int)strlen(keyword->name),
+			keyword->value, keyword->funct, keyword->opcode, index + 1 < isa->operatorCount ? "," : "");
+	}
+	fprintf(output, "};\n");
+
+	/* The instructors, as keyword, length and expectation. */
+	fprintf(output, "\n/**\n * The assembly instructors.\n */\n");
+	fprintf(output, "static const Instructor instructors[INS_COUNT] = {\n");
+	for (index = 0; index < isa->instructorCount; index++) {
+		keyword = &isa->instructors[index];
+		fprintf(output, "\t{\"%s\", %d, %s}%s\n", keyword->name, (int)strlen(keyword->name),
+			keyword->value, index + 1 < isa->instructorCount ? "," : "");
+	}
+	fprintf(output, "};\n");
+
+	writeSlots(output, "operatorSlots", "OP_SLOTS", operatorHash);
+	writeSlots(output, "instructorSlots", "INS_SLOTS", instructorHash);
+}
+
+/**
+ * Writes a hash macro with the multipliers of the given hash. The macro
+ * takes the first, second and last characters of a keyword and its length.
+ */
+void writeHash(FILE *output, const char *name, struct hash *hash) {
+	fprintf(output, "#define %s_HASH(first, second, last, length) ((first) * %uu + (second) * %uu + (last) * %uu + (unsigned int)(length))\n",
+		name, hash->first, hash->second, hash->last);
+}
+
+/**
+ * Writes the slots of the given hash as a table, every slot holds the
+ * index of the keyword that hashes to it, or EMPTY_SLOT.
+ */
+void writeSlots(FILE *output, const char *name, const char *size, struct hash *hash) {
+	const int perLine = 16; /* The number of slots on every line. */
+	int slot;
+
+	fprintf(output, "\n/**\n * A perfect hash table, every slot holds the index of the keyword that\n");
+	fprintf(output, " * hashes to it, or EMPTY_SLOT.\n */\n");
+	fprintf(output, "static const signed char %s[%s] = {", name, size);
+	for (slot = 0; slot < hash->size; slot++) {
+		fputs(slot % perLine == 0 ? "\n\t" : " ", output);
+		fprintf(output, "%2d%s", hash->slots[slot], slot + 1 < hash->size ? "," : "");
+	}
+	fprintf(output, "\n};\n");
+}
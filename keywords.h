@@ -2,15 +2,12 @@
 #define OPERATIONS_H
 
 #include "asmutils.h"
+#include "isa.h"
 
 /**
  * An header file for the keywords container (keywords) translation unit.
  */
 
-#define R 1 /* Operator code for type R. */
-#define I 2 /* Operator code for type I. */
-#define J 3 /* Operator code for type J. */
-
 /**
  * Defining the operator data structure.
  * This structure is used by this assembler for storing, accessing, and
@@ -28,46 +25,68 @@ typedef struct ins Instructor;
 /**
  * Returns the type code of the given operator pointer.
  */
-unsigned char getType(Operator *operator);
+unsigned char getType(const Operator *operator);
 
 /**
  * Returns the funct code of the given operator pointer.
  */
-unsigned char getFunct(Operator *operator);
+unsigned char getFunct(const Operator *operator);
 
 /**
  * Returns the opcode code of the given operator pointer.
  */
-unsigned char getOpcode(Operator *operator);
+unsigned char getOpcode(const Operator *operator);
 
 /**
  * Returns the keyword of the given operator pointer as a string.
  */
-char *getOperatorKeyword(Operator *operator);
+const char *getOperatorKeyword(const Operator *operator);
 
 /**
  * Returns the expectation of the given instructor pointer.
  */
-Expectation getExpectation(Instructor *instructor);
+Expectation getExpectation(const Instructor *instructor);
 
 /**
  * Returns the keyword of the given instructor pointer as a string.
  */
-char *getInstructorKeyword(Instructor *instructor);
+const char *getInstructorKeyword(const Instructor *instructor);
+
+/**
+ * Returns the number of assembly operators.
+ */
+unsigned int getOperatorCount();
+
+/**
+ * Returns the operator at the given index, which should be smaller than
+ * the number of operators.
+ */
+const Operator *getOperator(unsigned int index);
+
+/**
+ * Returns the number of assembly instructors.
+ */
+unsigned int getInstructorCount();
+
+/**
+ * Returns the instructor at the given index, which should be smaller than
+ * the number of instructors.
+ */
+const Instructor *getInstructor(unsigned int index);
 
 /**
  * Searches for the related operator object using its string representation.
  * Returns a pointer to an operation container node, if the given parameter is a
  * code-word, otherwise a null pointer.
  */
-Operator *searchOperatorByString(const char *keyword);
+const Operator *searchOperatorByString(const char *keyword);
 
 /**
  * Searches for the related instructor object using its string representation.
  * Returns a pointer to the instructor object, if the given parameter is a valid
  * keyword, otherwise a null pointer.
  */
-Instructor *searchInstructorByString(const char *keyword);
+const Instructor *searchInstructorByString(const char *keyword);
 
 /**
  * Initializes all the assembly keywords so the assembler could link the
@@ -76,6 +95,8 @@ Instructor *searchInstructorByString(const char *keyword);
  * At the end of the process, this function will return a code that tells if the
  * initialization was successful or not.
  * This function should be called only once.
+ * The keyword tables are generated from isa.def as constants, so there is
+ * nothing to allocate and the initialization cannot fail.
  */
 Code initasmKeywords();
 
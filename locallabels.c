@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "locallabels.h"
+#include "asmutils.h"
+
+/**
+ * The local labels translation unit keeps the numeric local labels of a
+ * source file apart from the symbol table, so labels that are defined
+ * many times over never grow the namespace. Every number has an array
+ * of the addresses it is defined at, and a reference is resolved with a
+ * binary search of the array of its number.
+ */
+
+#define DECIMAL 10 /* Decimal base, used for conversion from text to integer. */
+#define INITIAL_NUMBERS 10 /* The initial size of the numbers array. */
+#define INITIAL_DEFINITIONS 16 /* The initial capacity of the addresses array of a number. */
+
+/**
+ * Defining the definitions data structure.
+ * The addresses a single number is defined at, in increasing order.
+ */
+struct definitions {
+	unsigned long int *addresses; /* The addresses of the definitions. */
+	unsigned long int count; /* The number of definitions. */
+	unsigned long int capacity; /* The capacity of the addresses array. */
+};
+
+/**
+ * Defining the local labels data structure.
+ * The definitions of the numeric local labels of a source file, a sorted
+ * array of addresses for every number.
+ */
+struct locals {
+	struct definitions *numbers; /* The definitions of every number, indexed by the number. */
+	unsigned long int numberCount; /* The size of the numbers array. */
+	unsigned long int count; /* The number of definitions of all the numbers. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+unsigned long int countUpTo(const struct definitions *definitions, unsigned long int address);
+
+/**
+ * Creates a new empty local labels index.
+ * Returns a pointer to the new index or a null pointer if the memory
+ * allocation had failed.
+ */
+LocalLabels *createLocalLabels() {
+	LocalLabels *locals = malloc(sizeof(LocalLabels));
+
+	if (locals == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	locals->count = 0;
+	locals->numberCount = INITIAL_NUMBERS;
+	if ((locals->numbers = calloc(INITIAL_NUMBERS, sizeof(struct definitions))) == NULL) {
+		free(locals);
+		return NULL; /* Memory allocation failed. */
+	}
+
+	return locals;
+}
+
+/**
+ * Adds a definition of the local label with the given number at the
+ * given address. The definitions of a number are expected to be added
+ * in the order of their addresses.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addLocalLabel(LocalLabels *locals, unsigned long int number, unsigned long int address) {
+	struct definitions *definitions; /* The definitions of the number. */
+	unsigned long int *addresses; /* To grow the addresses array. */
+	unsigned long int size = locals->numberCount; /* The new size of the numbers array. */
+
+	if (number >= locals->numberCount) { /* Making room for the number. */
+		while (number >= size)
+			size *= 2;
+		if ((definitions = realloc(locals->numbers, size * sizeof(struct definitions))) == NULL)
+			return ERROR; /* Memory allocation failed. */
+		memset(definitions + locals->numberCount, 0, (size - locals->numberCount) * sizeof(struct definitions));
+		locals->numbers = definitions;
+		locals->numberCount = size;
+	}
+
+	definitions = locals->numbers + number;
+	if (definitions->count == definitions->capacity) { /* Making room for the definition. */
+		size = definitions->capacity ? definitions->capacity * 2 : INITIAL_DEFINITIONS;
+		if ((addresses = realloc(definitions->addresses, size * sizeof(unsigned long int))) == NULL)
+			return ERROR; /* Memory allocation failed. */
+		definitions->addresses = addresses;
+		definitions->capacity = size;
+	}
+
+	definitions->addresses[definitions->count++] = address;
+	locals->count++;
+	return SUCCESS;
+}
+
+/**
+ * Resolves the given reference to a local label, as it is used by the
+ * code line at the given address. A backward reference resolves to the
+ * nearest definition at or before that address and a forward reference
+ * to the nearest definition after it.
+ * Returns SUCCESS and sets the last parameter to the address of the
+ * definition, or ERROR if there is no such definition.
+ */
+Code searchLocalLabel(LocalLabels *locals, const char *reference, unsigned long int address, unsigned long int *labelAddress) {
+	char *suffix; /* The character after the number. */
+	const unsigned long int number = strtoul(reference, &suffix, DECIMAL);
+	const struct definitions *definitions; /* The definitions of the number. */
+	unsigned long int before; /* The number of definitions at or before the address. */
+
+	if (number >= locals->numberCount)
+		return ERROR; /* The number is never defined. */
+	definitions = locals->numbers + number;
+	before = countUpTo(definitions, address);
+
+	if (*suffix == BACKWARD_SUFFIX) {
+		if (before == 0)
+			return ERROR; /* Every definition comes after the line. */
+		*labelAddress = definitions->addresses[before - 1];
+	} else {
+		if (before == definitions->count)
+			return ERROR; /* Every definition comes before the line. */
+		*labelAddress = definitions->addresses[before];
+	}
+	return SUCCESS;
+}
+
+/**
+ * Returns the number of definitions in the given local labels index.
+ */
+unsigned long int getLocalLabelCount(LocalLabels *locals) {
+	return locals->count;
+}
+
+/**
+ * Frees all the memory used by the given local labels index.
+ */
+void freeLocalLabels(LocalLabels *locals) {
+	unsigned long int number;
+
+	for (number = 0; number < locals->numberCount; number++)
+		free(locals->numbers[number].addresses);
+	free(locals->numbers);
+	free(locals);
+}
+
+/**
+ * Counts the given definitions that are at or before the given address,
+ * with a binary search.
+ */
+unsigned long int countUpTo(const struct definitions *definitions, unsigned long int address) {
+	unsigned long int low = 0, high = definitions->count; /* The answer is between the two. */
+	unsigned long int middle;
+
+	while (low < high) {
+		middle = low + (high - low) / 2;
+		if (definitions->addresses[middle] <= address)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low;
+}
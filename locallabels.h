@@ -0,0 +1,53 @@
+#ifndef LOCALLABELS_H
+#define LOCALLABELS_H
+
+#include "asmutils.h"
+
+/**
+ * An header file for the local labels translation unit.
+ */
+
+/**
+ * Defining the local labels data structure.
+ * The definitions of the numeric local labels of a source file, a sorted
+ * array of addresses for every number. Local labels have no symbol, so
+ * they are found by their number and the address they are used at.
+ */
+typedef struct locals LocalLabels;
+
+/**
+ * Creates a new empty local labels index.
+ * Returns a pointer to the new index or a null pointer if the memory
+ * allocation had failed.
+ */
+LocalLabels *createLocalLabels();
+
+/**
+ * Adds a definition of the local label with the given number at the
+ * given address. The definitions of a number are expected to be added
+ * in the order of their addresses.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addLocalLabel(LocalLabels *locals, unsigned long int number, unsigned long int address);
+
+/**
+ * Resolves the given reference to a local label, as it is used by the
+ * code line at the given address. A backward reference resolves to the
+ * nearest definition at or before that address and a forward reference
+ * to the nearest definition after it.
+ * Returns SUCCESS and sets the last parameter to the address of the
+ * definition, or ERROR if there is no such definition.
+ */
+Code searchLocalLabel(LocalLabels *locals, const char *reference, unsigned long int address, unsigned long int *labelAddress);
+
+/**
+ * Returns the number of definitions in the given local labels index.
+ */
+unsigned long int getLocalLabelCount(LocalLabels *locals);
+
+/**
+ * Frees all the memory used by the given local labels index.
+ */
+void freeLocalLabels(LocalLabels *locals);
+
+#endif
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "namespace.h"
+#include "keywords.h"
+#include "asmutils.h"
+#include "utils.h"
+
+/**
+ * The namespace translation unit keeps the reserved keywords and the labels
+ * of a source file in one open addressing hash table. No entry copies its
+ * name, keywords and labels alike keep the offset of their name in the
+ * strings pool of the symbol table, which may move. Every field of an
+ * entry is a 32 bit word, except for the kind, so a slot takes 16 bytes.
+ */
+
+#define INITIAL_SLOTS 64 /* The initial number of slots, a power of two. */
+
+/**
+ * Defining the name data structure.
+ * A single entry of the namespace hash table.
+ */
+struct name {
+	Word offset; /* The offset of the name in the strings pool. */
+	Word hash; /* The hash of the name. */
+	Word label; /* The label of a label name. */
+	unsigned char kind; /* What the name is, UnknownName for an empty slot. */
+};
+
+/**
+ * Defining the namespace data structure.
+ * A hash table of every name a source file can declare, the reserved
+ * keywords and the labels of the file together, so one probe tells what
+ * a name is.
+ */
+struct names {
+	struct name *slots; /* The hash table, probed linearly. */
+	unsigned long int capacity; /* The number of slots, a power of two. */
+	unsigned long int count; /* The number of names. */
+	char *const *pool; /* Points to the strings pool of the names. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+struct name *findSlot(Namespace *namespace, const char *name, unsigned long int hash);
+Code addName(Namespace *namespace, unsigned long int offset, NameKind kind, unsigned long int label);
+Code growNamespace(Namespace *namespace);
+
+/**
+ * Creates a new empty namespace. The names that are added to it are
+ * offsets into the strings pool the given pointer points to.
+ * Returns a pointer to the new namespace or a null pointer if the memory
+ * allocation had failed.
+ */
+Namespace *createNamespace(char *const *pool) {
+	Namespace *namespace = malloc(sizeof(Namespace));
+
+	if (namespace == NULL)
+		return NULL; /* Memory allocation failed. */
+	namespace->capacity = INITIAL_SLOTS;
+	namespace->count = 0;
+	namespace->pool = pool;
+	if ((namespace->slots = calloc(INITIAL_SLOTS, sizeof(struct name))) == NULL) {
+		free(namespace);
+		return NULL; /* Memory allocation failed. */
+	}
+
+	return namespace;
+}
+
+/**
+ * Searches the given namespace for the given name.
+ * Returns the kind of the name, and if it is a label sets the last
+ * parameter to the label it was added with.
+ */
+NameKind searchName(Namespace *namespace, const char *name, unsigned long int *label) {
+	struct name *slot = findSlot(namespace, name, hashBytes(name, strlen(name), 0));
+
+	if (slot->kind == UnknownName)
+		return UnknownName; /* The name is not in the namespace. */
+	*label = slot->label;
+	return slot->kind;
+}
+
+/**
+ * Checks if the given name is a reserved keyword, without a namespace.
+ * Returns the kind of the keyword, or UnknownName if it is not one.
+ */
+NameKind searchKeyword(const char *name) {
+	if (searchOperatorByString(name) != NULL)
+		return OperatorName;
+	if (searchInstructorByString(name) != NULL)
+		return InstructorName;
+	return UnknownName;
+}
+
+/**
+ * Adds the given label to the given namespace under the name at the given
+ * offset of the strings pool, which should not be in the namespace
+ * already.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addLabelName(Namespace *namespace, unsigned long int offset, unsigned long int label) {
+	return addName(namespace, offset, LabelName, label);
+}
+
+/**
+ * Adds a reserved keyword of the given kind to the given namespace under
+ * the name at the given offset of the strings pool, which should not be
+ * in the namespace already.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addKeywordName(Namespace *namespace, unsigned long int offset, NameKind kind) {
+	return addName(namespace, offset, kind, 0);
+}
+
+/**
+ * Frees all the memory used by the given namespace, the names in it are
+ * not freed.
+ */
+void freeNamespace(Namespace *namespace) {
+	free(namespace->slots);
+	free(namespace);
+}
+
+/**
+ * Probes the given namespace for the given name with the given hash.
+ * Returns the slot of the name, or the empty slot where it should be
+ * added if it is not in the namespace.
+ */
+struct name *findSlot(Namespace *namespace, const char *name, unsigned long int hash) {
+	const unsigned long int mask = namespace->capacity - 1; /* The capacity is a power of two. */
+	unsigned long int index = hash & mask;
+
+	/* The table is never full, so the probe always ends. */
+	while (namespace->slots[index].kind != UnknownName &&
+		(namespace->slots[index].hash != hash || strcmp(*namespace->pool + namespace->slots[index].offset, name) != 0))
+		index = (index + 1) & mask;
+
+	return &namespace->slots[index];
+}
+
+/**
+ * Adds a name of the given kind and the given label to the given
+ * namespace, under the name at the given offset of the strings pool,
+ * growing the namespace if it is half full.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addName(Namespace *namespace, unsigned long int offset, NameKind kind, unsigned long int label) {
+	const char *name = *namespace->pool + offset;
+	const unsigned long int hash = hashBytes(name, strlen(name), 0);
+	struct name *slot;
+
+	if ((namespace->count + 1) * 2 > namespace->capacity && growNamespace(namespace) == ERROR)
+		return ERROR; /* Memory allocation failed. */
+
+	slot = findSlot(namespace, name, hash);
+	slot->offset = offset;
+	slot->hash = hash;
+	slot->label = label;
+	slot->kind = kind;
+	namespace->count++;
+
+	return SUCCESS;
+}
+
+/**
+ * Doubles the number of slots of the given namespace and places every
+ * name again.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code growNamespace(Namespace *namespace) {
+	struct name *slots = namespace->slots; /* The old slots. */
+	const unsigned long int capacity = namespace->capacity;
+	unsigned long int index;
+
+	if ((namespace->slots = calloc(capacity * 2, sizeof(struct name))) == NULL) {
+		namespace->slots = slots;
+		return ERROR; /* Memory allocation failed. */
+	}
+	namespace->capacity = capacity * 2;
+
+	for (index = 0; index < capacity; index++)
+		if (slots[index].kind != UnknownName)
+			*findSlot(namespace, *namespace->pool + slots[index].offset, slots[index].hash) = slots[index];
+	free(slots);
+
+	return SUCCESS;
+}
@@ -0,0 +1,71 @@
+#ifndef NAMESPACE_H
+#define NAMESPACE_H
+
+#include "asmutils.h"
+
+/**
+ * An header file for the namespace translation unit.
+ */
+
+/**
+ * Defining the namespace data structure.
+ * A hash table of every name a source file can declare, the reserved
+ * keywords and the labels of the file together, so one probe tells what
+ * a name is.
+ */
+typedef struct names Namespace;
+
+/**
+ * The kinds of names in a namespace.
+ */
+typedef enum {
+	UnknownName, /* The name is not in the namespace. */
+	OperatorName, /* A reserved operator keyword. */
+	InstructorName, /* A reserved instructor keyword. */
+	LabelName /* A label of the source file. */
+} NameKind;
+
+/**
+ * Creates a new empty namespace. The names that are added to it are
+ * offsets into the strings pool the given pointer points to.
+ * Returns a pointer to the new namespace or a null pointer if the memory
+ * allocation had failed.
+ */
+Namespace *createNamespace(char *const *pool);
+
+/**
+ * Searches the given namespace for the given name.
+ * Returns the kind of the name, and if it is a label sets the last
+ * parameter to the label it was added with.
+ */
+NameKind searchName(Namespace *namespace, const char *name, unsigned long int *label);
+
+/**
+ * Checks if the given name is a reserved keyword, without a namespace.
+ * Returns the kind of the keyword, or UnknownName if it is not one.
+ */
+NameKind searchKeyword(const char *name);
+
+/**
+ * Adds the given label to the given namespace under the name at the given
+ * offset of the strings pool, which should not be in the namespace
+ * already.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addLabelName(Namespace *namespace, unsigned long int offset, unsigned long int label);
+
+/**
+ * Adds a reserved keyword of the given kind to the given namespace under
+ * the name at the given offset of the strings pool, which should not be
+ * in the namespace already.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addKeywordName(Namespace *namespace, unsigned long int offset, NameKind kind);
+
+/**
+ * Frees all the memory used by the given namespace, the names in it are
+ * not freed.
+ */
+void freeNamespace(Namespace *namespace);
+
+#endif
@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#if defined(__SSE2__) && !defined(NO_SIMD)
+#define READ_SSE2 /* Decoding a full line with a single load. */
+#include <emmintrin.h>
+#endif
+
+#include "obreader.h"
+#include "segment.h"
+#include "asmutils.h"
+
+/**
+ * The object reader translation unit reads object files back into the
+ * code and data segments they were written from. The file is mapped
+ * into memory instead of being read trough a stream, and every full
+ * line is checked and converted from hexadecimal digits with a single
+ * SSE2 load where the compiler offers it, a digit at a time otherwise,
+ * which is also what a build with NO_SIMD defined uses.
+ */
+
+#define LINE_BYTES 4 /* The number of bytes between two addresses. */
+#define LINE_TEXT (3 * LINE_BYTES + 1) /* The size of a full line after its address, new line character included. */
+#define MIN_BYTE_TEXT 3 /* The least number of characters of every byte in the file, a space and two digits. */
+#define DECIMAL 10 /* Decimal base, used for conversion from text to integer. */
+#define HEX_LETTERS 6 /* The number of hexadecimal digits that are letters. */
+#define SSE_BLOCK 16 /* The number of characters loaded at once. */
+#define HEX_MASK 0x0DB6 /* The positions of the digits of a full line after its address. */
+#define SPACE_MASK 0x0249 /* The positions of the spaces of a full line after its address. */
+
+/**
+ * Defining the hex object data structure.
+ * Holds the code segment and the data segment in one block, the data
+ * segment right after the code segment.
+ */
+struct hexobject {
+	unsigned char *code; /* The code segment, followed by the data segment. */
+	unsigned char *data; /* The data segment. */
+	unsigned long int ic, dc; /* The size of the code segment and the size of the data segment. */
+	unsigned long int address; /* The address of the first line. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+Code parseHexObject(HexObject *object, const char *position, const char *end);
+const char *parseDecimal(const char *position, const char *end, unsigned long int *value);
+const char *parseLineAddress(const char *position, const char *end, HexObject *object, unsigned long int offset);
+const char *decodeHexLine(const char *position, const char *end, unsigned char *bytes);
+const char *decodeHexBytes(const char *position, const char *end, unsigned char *bytes, unsigned long int count);
+int hexValue(char digit);
+
+/**
+ * Reads the object file of the given name, written by the assembler,
+ * into a new hex object. The file is mapped into memory and its lines
+ * are decoded a line at a time, with SSE2 where the compiler offers it.
+ * Returns a pointer to the new hex object or a null pointer if the file
+ * could not be read, is not a valid object file or the memory
+ * allocation had failed.
+ */
+HexObject *readHexObject(const char *fileName) {
+	FILE *file;
+	char *text; /* The mapped file. */
+	unsigned long int size; /* The size of the file. */
+	HexObject *object;
+
+	if ((file = fopen(fileName, "rb")) == NULL)
+		return NULL; /* The file could not be opened. */
+	text = mapInputFile(file, &size);
+	fclose(file); /* The mapping keeps the file until it is unmapped. */
+	if (text == NULL)
+		return NULL; /* An empty file is not a valid object file either. */
+
+	if ((object = calloc(1, sizeof(HexObject))) != NULL && parseHexObject(object, text, text + size) == ERROR) {
+		freeHexObject(object);
+		object = NULL;
+	}
+	unmapFile(text, size);
+
+	return object;
+}
+
+/**
+ * Returns the address of the first line of the given hex object, zero
+ * if it has no lines.
+ */
+unsigned long int getObjectAddress(HexObject *object) {
+	return object->address;
+}
+
+/**
+ * Returns the code segment of the given hex object.
+ */
+const unsigned char *getObjectCode(HexObject *object) {
+	return object->code;
+}
+
+/**
+ * Returns the size of the code segment of the given hex object (in
+ * bytes).
+ */
+unsigned long int getObjectCodeSize(HexObject *object) {
+	return object->ic;
+}
+
+/**
+ * Returns the data segment of the given hex object.
+ */
+const unsigned char *getObjectData(HexObject *object) {
+	return object->data;
+}
+
+/**
+ * Returns the size of the data segment of the given hex object (in
+ * bytes).
+ */
+unsigned long int getObjectDataSize(HexObject *object) {
+	return object->dc;
+}
+
+/**
+ * Frees all the memory used by the given hex object.
+ */
+void freeHexObject(HexObject *object) {
+	free(object->code);
+	free(object);
+}
+
+/**
+ * Parses the text of an object file between the given pointers into the
+ * given hex object: the header line, then the full lines of the code
+ * segment and of the data segment, which follow each other at
+ * consecutive addresses, then the last line of the data segment, which
+ * has no new line character and holds only the address when the size of
+ * the data segment is a multiple of 4.
+ * Returns SUCCESS if the text is a valid object file and ERROR otherwise.
+ */
+Code parseHexObject(HexObject *object, const char *position, const char *end) {
+	unsigned long int offset, size; /* To loop trough the lines, and the size of both segments. */
+	unsigned char *bytes; /* Where the bytes of the next line go. */
+
+	while (position < end && *position == ' ')
+		position++; /* The indentation of the header line. */
+	if ((position = parseDecimal(position, end, &object->ic)) == NULL || position == end || *position++ != ' ' ||
+		(position = parseDecimal(position, end, &object->dc)) == NULL || position == end || *position++ != '\n')
+		return ERROR; /* Invalid header line. */
+
+	size = object->ic + object->dc;
+	if (object->ic % LINE_BYTES != 0 || size < object->ic || size > (unsigned long int) (end - position) / MIN_BYTE_TEXT)
+		return ERROR; /* Sizes that do not match the rest of the file. */
+	if ((object->code = malloc(size + 1)) == NULL) /* +1 so an empty object is not a null pointer. */
+		return ERROR; /* Memory allocation failed. */
+	object->data = object->code + object->ic;
+
+	bytes = object->code;
+	for (offset = 0; offset + LINE_BYTES <= size; offset += LINE_BYTES, bytes += LINE_BYTES) {
+		if ((position = parseLineAddress(position, end, object, offset)) == NULL ||
+			(position = decodeHexLine(position, end, bytes)) == NULL)
+			return ERROR; /* Invalid full line. */
+	}
+
+	if (object->dc != 0) { /* The last line of the data segment. */
+		if ((position = parseLineAddress(position, end, object, offset)) == NULL ||
+			(position = decodeHexBytes(position, end, bytes, size - offset)) == NULL)
+			return ERROR; /* Invalid last line. */
+		if (position < end && *position == '\n')
+			position++; /* Tolerated, although the assembler does not write it. */
+	}
+
+	return position == end ? SUCCESS : ERROR;
+}
+
+/**
+ * Parses the decimal number at the given position into the given value.
+ * Returns the position after the number or a null pointer if there is
+ * no number there or it is too large.
+ */
+const char *parseDecimal(const char *position, const char *end, unsigned long int *value) {
+	const char *start = position; /* The first digit. */
+
+	for (*value = 0; position < end && *position >= '0' && *position <= '9'; position++) {
+		if (*value > (ULONG_MAX - (DECIMAL - 1)) / DECIMAL)
+			return NULL; /* The number is too large. */
+		*value = *value * DECIMAL + (*position - '0');
+	}
+	return position == start ? NULL : position;
+}
+
+/**
+ * Parses the address of the line at the given position, which should
+ * be the given offset (in bytes) after the address of the first line of
+ * the given hex object. The address of the first line is kept.
+ * Returns the position after the address or a null pointer if there is
+ * no address there or it is not the expected one.
+ */
+const char *parseLineAddress(const char *position, const char *end, HexObject *object, unsigned long int offset) {
+	unsigned long int address;
+
+	if ((position = parseDecimal(position, end, &address)) == NULL)
+		return NULL; /* No address. */
+	if (offset == 0)
+		object->address = address;
+	else if (address != object->address + offset)
+		return NULL; /* A missing or a repeated line. */
+	return position;
+}
+
+/**
+ * Decodes the 4 bytes of the full line at the given position, which is
+ * right after its address, into the given array.
+ * Returns the position of the next line or a null pointer if the line
+ * is not valid.
+ */
+const char *decodeHexLine(const char *position, const char *end, unsigned char *bytes) {
+#ifdef READ_SSE2
+	if (end - position >= SSE_BLOCK) { /* The whole line and the start of the next one, in one load. */
+		__m128i text = _mm_loadu_si128((const __m128i *) position);
+		__m128i digits = _mm_sub_epi8(text, _mm_set1_epi8('0'));
+		__m128i letters = _mm_sub_epi8(_mm_or_si128(text, _mm_set1_epi8(0x20)), _mm_set1_epi8('a')); /* Both cases. */
+		__m128i isDigit = _mm_andnot_si128(_mm_cmplt_epi8(digits, _mm_setzero_si128()), _mm_cmplt_epi8(digits, _mm_set1_epi8(DECIMAL)));
+		__m128i isLetter = _mm_andnot_si128(_mm_cmplt_epi8(letters, _mm_setzero_si128()), _mm_cmplt_epi8(letters, _mm_set1_epi8(HEX_LETTERS)));
+		__m128i nibbles = _mm_or_si128(_mm_and_si128(isDigit, digits), _mm_and_si128(isLetter, _mm_add_epi8(letters, _mm_set1_epi8(DECIMAL))));
+		unsigned char pairs[SSE_BLOCK]; /* Every digit with the digit after it, as a byte. */
+
+		if ((_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) & HEX_MASK) != HEX_MASK ||
+			(_mm_movemask_epi8(_mm_cmpeq_epi8(text, _mm_set1_epi8(' '))) & SPACE_MASK) != SPACE_MASK ||
+			position[LINE_TEXT - 1] != '\n')
+			return NULL; /* Not a full line. */
+
+		/* The digits are below 16, so shifting the 16 bit lanes does not move bits between bytes. */
+		_mm_storeu_si128((__m128i *) pairs, _mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_si128(nibbles, 1)));
+		bytes[0] = pairs[1];
+		bytes[1] = pairs[4];
+		bytes[2] = pairs[7];
+		bytes[3] = pairs[10];
+
+		return position + LINE_TEXT;
+	}
+#endif
+	if ((position = decodeHexBytes(position, end, bytes, LINE_BYTES)) == NULL || position == end || *position != '\n')
+		return NULL; /* Not a full line. */
+	return position + 1;
+}
+
+/**
+ * Decodes the given number of bytes at the given position, every one of
+ * them a space and two hexadecimal digits, into the given array.
+ * Returns the position after the last byte or a null pointer if they are
+ * not valid.
+ */
+const char *decodeHexBytes(const char *position, const char *end, unsigned char *bytes, unsigned long int count) {
+	int high, low; /* The values of the digits of a byte. */
+
+	if ((unsigned long int) (end - position) < count * MIN_BYTE_TEXT)
+		return NULL; /* The file ends too early. */
+	for (; count > 0; count--, position += MIN_BYTE_TEXT) {
+		if (position[0] != ' ' || (high = hexValue(position[1])) < 0 || (low = hexValue(position[2])) < 0)
+			return NULL; /* Not a byte. */
+		*bytes++ = (high << 4) | low;
+	}
+	return position;
+}
+
+/**
+ * Returns the value of the given hexadecimal digit, of either case, or
+ * -1 if it is not a hexadecimal digit.
+ */
+int hexValue(char digit) {
+	if (digit >= '0' && digit <= '9')
+		return digit - '0';
+	if (digit >= 'A' && digit <= 'F')
+		return digit - 'A' + DECIMAL;
+	if (digit >= 'a' && digit <= 'f')
+		return digit - 'a' + DECIMAL;
+	return -1;
+}
@@ -0,0 +1,60 @@
+#ifndef OBREADER_H
+#define OBREADER_H
+
+/**
+ * An header file for the object reader translation unit.
+ */
+
+/**
+ * Defining the hex object data structure.
+ * An object file read back into memory: the code segment and the data
+ * segment as arrays of bytes, in the order they appear in the file, so
+ * every code word is 4 bytes starting from the least significant one,
+ * and the address of the first line of the file.
+ */
+typedef struct hexobject HexObject;
+
+/**
+ * Reads the object file of the given name, written by the assembler,
+ * into a new hex object. The file is mapped into memory and its lines
+ * are decoded a line at a time, with SSE2 where the compiler offers it.
+ * Returns a pointer to the new hex object or a null pointer if the file
+ * could not be read, is not a valid object file or the memory
+ * allocation had failed.
+ */
+HexObject *readHexObject(const char *fileName);
+
+/**
+ * Returns the address of the first line of the given hex object, zero
+ * if it has no lines.
+ */
+unsigned long int getObjectAddress(HexObject *object);
+
+/**
+ * Returns the code segment of the given hex object.
+ */
+const unsigned char *getObjectCode(HexObject *object);
+
+/**
+ * Returns the size of the code segment of the given hex object (in
+ * bytes).
+ */
+unsigned long int getObjectCodeSize(HexObject *object);
+
+/**
+ * Returns the data segment of the given hex object.
+ */
+const unsigned char *getObjectData(HexObject *object);
+
+/**
+ * Returns the size of the data segment of the given hex object (in
+ * bytes).
+ */
+unsigned long int getObjectDataSize(HexObject *object);
+
+/**
+ * Frees all the memory used by the given hex object.
+ */
+void freeHexObject(HexObject *object);
+
+#endif
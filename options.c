@@ -0,0 +1,290 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "options.h"
+#include "asmutils.h"
+
+/**
+ * Contains the parsing of the command line options and the accessors
+ * for the settings they control.
+ */
+
+#define OPTION_PREFIX '-' /* Every option starts with that character. */
+#define OPTION_JOBS "--jobs" /* Sets the number of threads used for a single source file. */
+#define OPTION_PIPELINE "--pipeline" /* Runs the stages of the assembler on separate threads. */
+#define OPTION_INCREMENTAL "--incremental" /* Reuses the state of the previous run to assemble only the changed lines. */
+#define OPTION_CHECK "--check" /* Only looks for issues, no output files are created. */
+#define OPTION_MAX_ERRORS "--max-errors" /* Stops mapping a source file after that many errors. */
+#define OPTION_GROUPED_EXT "--grouped-ext" /* Writes a single record for every external label. */
+#define OPTION_MAP "--map" /* Writes the symbol map files. */
+#define OPTION_RESOLVE "--resolve" /* Checks the external labels of the batch against its entry labels. */
+#define OPTION_BINARY "--binary" /* Writes the binary object files. */
+#define OPTION_ELF "--elf" /* Writes the ELF relocatable object files. */
+#define OPTION_SPILL "--spill" /* Keeps the data segments, not the code segments, in temporary files mapped into memory. */
+#define OPTION_IN_PLACE "--in-place" /* Fills the object files in place, mapped into memory at their final size. */
+#define DEFAULT_JOBS 1 /* The assembler runs on a single thread unless told otherwise. */
+#define MAX_JOBS 256 /* An upper limit for the number of threads. */
+
+/**
+ * The following function should not be used outside of this translation unit.
+ */
+Code parseCount(const char *value, int max, int *count);
+
+/**
+ * Defining the options data structure.
+ * This structure holds the settings given on the command line, those
+ * settings apply to every source file assembled in the same run.
+ */
+struct opts {
+	int jobs; /* The number of threads the assembler may use for a single source file. */
+	char isPipelined; /* To run reading, parsing, encoding and writing as separate stages. */
+	char isIncremental; /* To reuse the state of the previous run of every source file. */
+	char isCheckOnly; /* To stop after looking for issues, without creating output files. */
+	int maxErrors; /* The number of errors after which a source file is no longer mapped, zero for no limit. */
+	char isGroupedExt; /* To write every external label once, with all the addresses that use it. */
+	char isMapped; /* To write the symbol map files of every source file. */
+	char isResolving; /* To check that every external label is an entry label of one source file in the batch. */
+	char isBinary; /* To write a binary object file along with the object file of every source file. */
+	char isElf; /* To write an ELF relocatable object file along with the object file of every source file. */
+	char isSpilled; /* To keep the data segment of every source file in a temporary file rather than on the heap. */
+	char isInPlace; /* To fill every object file mapped into memory rather than writing it trough a stream. */
+};
+
+/**
+ * Creates a new options object with every setting set to its default.
+ * Returns a pointer to the new object or a null pointer if the memory
+ * allocation had failed.
+ */
+Options *createOptions() {
+	Options *options = malloc(sizeof(Options));
+
+	if (options == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	options->jobs = DEFAULT_JOBS; /* Single threaded by default. */
+	options->isPipelined = 0; /* Every stage runs on the same thread by default. */
+	options->isIncremental = 0; /* Every source file is assembled from scratch by default. */
+	options->isCheckOnly = 0; /* Output files are created by default. */
+	options->maxErrors = 0; /* Every line is mapped by default. */
+	options->isGroupedExt = 0; /* Every use of an external label is a record of its own by default. */
+	options->isMapped = 0; /* No symbol map files by default. */
+	options->isResolving = 0; /* Every source file stands on its own by default. */
+	options->isBinary = 0; /* No binary object files by default. */
+	options->isElf = 0; /* No ELF object files by default. */
+	options->isSpilled = 0; /* The data segments are allocated on the heap by default. */
+	options->isInPlace = 0; /* The object files are written trough a stream by default. */
+
+	return options;
+}
+
+/**
+ * Checks if the given command line argument is an option rather than a
+ * source file name, meaning it starts with a dash.
+ * Returns SUCCESS if it is an option and ERROR otherwise.
+ */
+Code isOption(const char *argument) {
+	return argument[0] == OPTION_PREFIX ? SUCCESS : ERROR;
+}
+
+/**
+ * Parses the given string as a positive decimal count that is not
+ * larger than the second parameter, into the last parameter.
+ * Returns SUCCESS if the string is a valid count and ERROR otherwise,
+ * in that case the last parameter would be untouched.
+ */
+Code parseCount(const char *value, int max, int *count) {
+	const int decimal = 10; /* The base of the count. */
+	char *end; /* To check that the whole string was a number. */
+	long int result;
+
+	if (value == NULL)
+		return ERROR; /* The value is missing. */
+
+	result = strtol(value, &end, decimal);
+	if (*value == '\0' || *end != '\0' || result < 1 || result > max)
+		return ERROR; /* Not a number or out of range. */
+
+	*count = result;
+	return SUCCESS;
+}
+
+/**
+ * Parses the option found at the position pointed by the last parameter
+ * of the given arguments array into the given options object.
+ * Options that take a value consume the next argument as well, in that
+ * case the last parameter would point to that value after the call.
+ * Returns SUCCESS if the option was parsed and ERROR if the option is
+ * unknown or its value is invalid.
+ */
+Code parseOption(Options *options, int argc, char const *argv[], int *index) {
+	const char *option = argv[*index]; /* The option to parse. */
+	const char *value = (*index + 1 < argc) ? argv[*index + 1] : NULL; /* The value of the option, if there is one. */
+
+	if (strcmp(option, OPTION_JOBS) == 0) {
+		if (value != NULL)
+			(*index)++; /* The value belongs to this option. */
+		return parseCount(value, MAX_JOBS, &options->jobs);
+	}
+	if (strcmp(option, OPTION_MAX_ERRORS) == 0) {
+		if (value != NULL)
+			(*index)++; /* The value belongs to this option. */
+		return parseCount(value, INT_MAX, &options->maxErrors);
+	}
+	if (strcmp(option, OPTION_PIPELINE) == 0) {
+		options->isPipelined = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_INCREMENTAL) == 0) {
+		options->isIncremental = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_CHECK) == 0) {
+		options->isCheckOnly = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_GROUPED_EXT) == 0) {
+		options->isGroupedExt = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_MAP) == 0) {
+		options->isMapped = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_RESOLVE) == 0) {
+		options->isResolving = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_BINARY) == 0) {
+		options->isBinary = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_ELF) == 0) {
+		options->isElf = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_SPILL) == 0) {
+		options->isSpilled = 1;
+		return SUCCESS;
+	}
+	if (strcmp(option, OPTION_IN_PLACE) == 0) {
+		options->isInPlace = 1;
+		return SUCCESS;
+	}
+
+	return ERROR; /* Unknown option. */
+}
+
+/**
+ * Returns the number of threads the assembler may use for a single
+ * source file.
+ */
+int getJobs(Options *options) {
+	return options->jobs;
+}
+
+/**
+ * Checks if the stages of the assembler should run on separate threads.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isPipelined(Options *options) {
+	return options->isPipelined ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if the state of the previous run of every source file should be
+ * reused, so only the changed lines are assembled again.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isIncremental(Options *options) {
+	return options->isIncremental ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if the source files should only be checked for issues, without
+ * creating any output files.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isCheckOnly(Options *options) {
+	return options->isCheckOnly ? SUCCESS : ERROR;
+}
+
+/**
+ * Returns the number of errors after which a source file is no longer
+ * mapped, or zero if there is no limit.
+ */
+int getMaxErrors(Options *options) {
+	return options->maxErrors;
+}
+
+/**
+ * Checks if the externals file should hold a single record for every
+ * external label, listing all the addresses that use it.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isGroupedExt(Options *options) {
+	return options->isGroupedExt ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if a symbol map file and its binary index should be written for
+ * every assembled source file.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isMapped(Options *options) {
+	return options->isMapped ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if the external labels of every source file should be resolved
+ * against the entry labels of the other source files in the batch.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isResolving(Options *options) {
+	return options->isResolving ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if a binary object file should be written along with the
+ * object file of every assembled source file.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isBinary(Options *options) {
+	return options->isBinary ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if an ELF relocatable object file should be written along with
+ * the object file of every assembled source file.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isElf(Options *options) {
+	return options->isElf ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if the data segment of every source file should be kept in a
+ * temporary file mapped into memory, so the resident memory does not
+ * grow with its size. The code segment is kept on the heap either way,
+ * so only the memory of the data segment is bounded.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isSpilled(Options *options) {
+	return options->isSpilled ? SUCCESS : ERROR;
+}
+
+/**
+ * Checks if every object file should be created at its final size,
+ * mapped into memory and filled in place.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isInPlace(Options *options) {
+	return options->isInPlace ? SUCCESS : ERROR;
+}
+
+/**
+ * Frees all the memory used by the given options object.
+ */
+void freeOptions(Options *options) {
+	free(options);
+}
@@ -0,0 +1,129 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "asmutils.h"
+
+/**
+ * An header file for the command line options (options) translation unit.
+ */
+
+/**
+ * Defining the options data structure.
+ * This structure holds the settings given on the command line, those
+ * settings apply to every source file assembled in the same run.
+ */
+typedef struct opts Options;
+
+/**
+ * Creates a new options object with every setting set to its default.
+ * Returns a pointer to the new object or a null pointer if the memory
+ * allocation had failed.
+ */
+Options *createOptions();
+
+/**
+ * Checks if the given command line argument is an option rather than a
+ * source file name, meaning it starts with a dash.
+ * Returns SUCCESS if it is an option and ERROR otherwise.
+ */
+Code isOption(const char *argument);
+
+/**
+ * Parses the option found at the position pointed by the last parameter
+ * of the given arguments array into the given options object.
+ * Options that take a value consume the next argument as well, in that
+ * case the last parameter would point to that value after the call.
+ * Returns SUCCESS if the option was parsed and ERROR if the option is
+ * unknown or its value is invalid.
+ */
+Code parseOption(Options *options, int argc, char const *argv[], int *index);
+
+/**
+ * Returns the number of threads the assembler may use for a single
+ * source file.
+ */
+int getJobs(Options *options);
+
+/**
+ * Checks if the stages of the assembler should run on separate threads.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isPipelined(Options *options);
+
+/**
+ * Checks if the state of the previous run of every source file should be
+ * reused, so only the changed lines are assembled again.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isIncremental(Options *options);
+
+/**
+ * Checks if the source files should only be checked for issues, without
+ * creating any output files.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isCheckOnly(Options *options);
+
+/**
+ * Returns the number of errors after which a source file is no longer
+ * mapped, or zero if there is no limit.
+ */
+int getMaxErrors(Options *options);
+
+/**
+ * Checks if the externals file should hold a single record for every
+ * external label, listing all the addresses that use it.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isGroupedExt(Options *options);
+
+/**
+ * Checks if a symbol map file and its binary index should be written for
+ * every assembled source file.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isMapped(Options *options);
+
+/**
+ * Checks if the external labels of every source file should be resolved
+ * against the entry labels of the other source files in the batch.
+ * Returns SUCCESS if they should and ERROR otherwise.
+ */
+Code isResolving(Options *options);
+
+/**
+ * Checks if a binary object file should be written along with the
+ * object file of every assembled source file.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isBinary(Options *options);
+
+/**
+ * Checks if an ELF relocatable object file should be written along with
+ * the object file of every assembled source file.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isElf(Options *options);
+
+/**
+ * Checks if the data segment of every source file should be kept in a
+ * temporary file mapped into memory, so the resident memory does not
+ * grow with its size. The code segment is kept on the heap either way,
+ * so only the memory of the data segment is bounded.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isSpilled(Options *options);
+
+/**
+ * Checks if every object file should be created at its final size,
+ * mapped into memory and filled in place.
+ * Returns SUCCESS if it should and ERROR otherwise.
+ */
+Code isInPlace(Options *options);
+
+/**
+ * Frees all the memory used by the given options object.
+ */
+void freeOptions(Options *options);
+
+#endif
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "parallel.h"
+#include "converter.h"
+#include "asmutils.h"
+#include "errmsg.h"
+
+/**
+ * The parallel translation unit splits large source files into chunks
+ * of whole lines, so the assembler can work on every chunk on its own
+ * thread. The results of the chunks are then merged in their original
+ * order.
+ */
+
+#define MIN_CHUNK_SIZE 65536 /* Source files are not split into chunks smaller than that (in bytes). */
+#define COUNT_BUFFER_SIZE 65536 /* The size of the buffer used for counting lines. */
+#define NEW_LINE '\n'
+
+/**
+ * Defining the chunk data structure.
+ * A single range of whole lines in a source file, along with the
+ * results of the work done on it.
+ */
+struct chunk {
+	const char *fileName; /* The name of the source file, every chunk opens its own stream. */
+	long int start; /* The offset of the first character of the chunk. */
+	long int end; /* The offset after the last character of the chunk. */
+	unsigned long int firstLine; /* The line number of the first line of the chunk. */
+	unsigned long int lineCount; /* The number of lines in the chunk, zero for the last chunk which ends with the file. */
+	MapState *state; /* The first pass state of the chunk. */
+	FILE *messages; /* The messages printed while mapping the chunk. */
+	unsigned long int codeBase; /* The address of the first code line of the chunk. */
+	unsigned long int codeSize; /* The size of the code of the chunk (in bytes). */
+	unsigned long int dataBase; /* The index of the data of the chunk in the data segment. */
+	SymbolTable *symbolTable; /* The symbol table of the whole file, used while assembling. */
+	char *dataSegment; /* The data segment of the whole file. */
+	ConvertState *convertState; /* The second pass state of the chunk. */
+};
+
+/**
+ * Defining the chunks data structure.
+ * This structure splits a source file into ranges of whole lines, so
+ * every range can be handled on its own thread.
+ */
+struct chunkset {
+	struct chunk *chunks; /* The chunks, in the order of the file. */
+	int count; /* The number of chunks. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+void runOnChunks(Chunks *chunks, void *(*routine)(void *));
+void *countChunkLines(void *chunk);
+void *mapChunk(void *chunk);
+void *convertChunk(void *chunk);
+FILE *openChunk(struct chunk *chunk);
+
+/**
+ * Splits the given source file into at most the given number of chunks
+ * of whole lines, and counts the lines of every chunk.
+ * Returns a pointer to the chunks, or a null pointer if the file is too
+ * small to be worth splitting. Either way the given stream is rewound.
+ */
+Chunks *splitSource(FILE *file, const char *fileName, int jobs) {
+	long int size; /* The size of the file. */
+	long int boundary, previous = 0; /* The end of every chunk and the end of the one before it. */
+	int count; /* The number of chunks to aim for. */
+	int index; /* To loop trough the chunks. */
+	int c; /* To find the ends of lines. */
+	unsigned long int line = 1; /* The line number of the first line of every chunk. */
+	Chunks *chunks; /* The result. */
+
+	fseek(file, 0, SEEK_END);
+	size = ftell(file);
+	count = size / MIN_CHUNK_SIZE;
+	if (count > jobs)
+		count = jobs; /* One chunk per thread. */
+	if (count < 2) {
+		rewind(file);
+		return NULL; /* Not worth splitting. */
+	}
+
+	if ((chunks = malloc(sizeof(Chunks))) == NULL || (chunks->chunks = calloc(count, sizeof(struct chunk))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+	chunks->count = 0;
+
+	for (index = 0; index < count; index++) {
+		boundary = size; /* The last chunk ends with the file. */
+		if (index < count - 1) {
+			/* Moving the boundary forward to the beginning of the next line. */
+			fseek(file, size / count * (index + 1), SEEK_SET);
+			while ((c = fgetc(file)) != NEW_LINE && c != EOF)
+				;
+			boundary = ftell(file);
+		}
+		if (boundary <= previous)
+			continue; /* A very long line swallowed this chunk. */
+
+		chunks->chunks[chunks->count].fileName = fileName;
+		chunks->chunks[chunks->count].start = previous;
+		chunks->chunks[chunks->count].end = boundary;
+		chunks->count++;
+		previous = boundary;
+	}
+	rewind(file);
+
+	if (chunks->count < 2) {
+		freeChunks(chunks);
+		return NULL; /* Not worth splitting. */
+	}
+
+	/* Numbering the lines of every chunk. */
+	runOnChunks(chunks, countChunkLines);
+	for (index = 0; index < chunks->count; index++) {
+		chunks->chunks[index].firstLine = line;
+		line += chunks->chunks[index].lineCount;
+	}
+	chunks->chunks[chunks->count - 1].lineCount = 0; /* The last chunk is mapped until the end of the file. */
+
+	return chunks;
+}
+
+/**
+ * Maps every chunk on its own thread and replays the results into the
+ * given first pass state in the order of the chunks, so the symbol table,
+ * the counters and the printed messages are the same as if the whole
+ * file was mapped on a single thread.
+ */
+void mapChunks(Chunks *chunks, MapState *state) {
+	int index;
+
+	runOnChunks(chunks, mapChunk);
+
+	for (index = 0; index < chunks->count; index++) {
+		/* Keeping where the chunk begins for the second pass. */
+		chunks->chunks[index].codeBase = getInstructionCounter(state);
+		chunks->chunks[index].dataBase = getDataCounter(state);
+		chunks->chunks[index].codeSize = getInstructionCounter(chunks->chunks[index].state);
+		replayMapState(state, chunks->chunks[index].state);
+		/* The chunk is no longer needed. */
+		freeMapState(chunks->chunks[index].state);
+		fclose(chunks->chunks[index].messages);
+		chunks->chunks[index].state = NULL;
+		chunks->chunks[index].messages = NULL;
+	}
+}
+
+/**
+ * Assembles every chunk on its own thread, each into its own part of
+ * the given data segment, and adds the encoded code lines and label
+ * references of the chunks into the given second pass state in the
+ * order of the chunks. Expects the chunks to be mapped by mapChunks.
+ */
+void convertChunks(Chunks *chunks, SymbolTable *symbolTable, char *dataSegment, ConvertState *state) {
+	int index;
+
+	for (index = 0; index < chunks->count; index++) {
+		chunks->chunks[index].symbolTable = symbolTable;
+		chunks->chunks[index].dataSegment = dataSegment;
+	}
+
+	runOnChunks(chunks, convertChunk);
+
+	for (index = 0; index < chunks->count; index++) {
+		writeConvertState(state, chunks->chunks[index].convertState);
+		/* The chunk is no longer needed. */
+		freeConvertState(chunks->chunks[index].convertState);
+		chunks->chunks[index].convertState = NULL;
+	}
+}
+
+/**
+ * Runs the given routine on every chunk, each on its own thread, and
+ * waits for all of them to finish.
+ */
+void runOnChunks(Chunks *chunks, void *(*routine)(void *)) {
+	pthread_t *threads; /* A thread for every chunk. */
+	int index;
+
+	if ((threads = malloc(chunks->count * sizeof(pthread_t))) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	for (index = 0; index < chunks->count; index++)
+		if (pthread_create(threads + index, NULL, routine, chunks->chunks + index) != 0)
+			errFatal(); /* Cannot continue without the thread. */
+	for (index = 0; index < chunks->count; index++)
+		pthread_join(threads[index], NULL);
+
+	free(threads);
+}
+
+/**
+ * Opens a new stream for the source file of the given chunk, positioned
+ * at the beginning of the chunk.
+ */
+FILE *openChunk(struct chunk *chunk) {
+	FILE *file = fopen(chunk->fileName, "r");
+
+	if (file == NULL || fseek(file, chunk->start, SEEK_SET) != 0)
+		errFatal(); /* The file was accessible a moment ago. */
+	return file;
+}
+
+/**
+ * Counts the new line characters in the given chunk into its line count.
+ * Used as a thread routine.
+ */
+void *countChunkLines(void *argument) {
+	struct chunk *chunk = argument;
+	char buffer[COUNT_BUFFER_SIZE]; /* The chunk is read in blocks. */
+	long int remaining = chunk->end - chunk->start; /* The number of bytes left to read. */
+	size_t size; /* The size of every block. */
+	char *c, *end; /* To find the new line characters in every block. */
+	FILE *file = openChunk(chunk);
+
+	chunk->lineCount = 0;
+	while (remaining > 0 && (size = fread(buffer, 1, remaining < COUNT_BUFFER_SIZE ? remaining : COUNT_BUFFER_SIZE, file)) > 0) {
+		remaining -= size;
+		end = buffer + size;
+		for (c = buffer; (c = memchr(c, NEW_LINE, end - c)) != NULL; c++)
+			chunk->lineCount++;
+	}
+
+	fclose(file);
+	return NULL;
+}
+
+/**
+ * Maps the lines of the given chunk into a new deferring first pass
+ * state, while keeping the printed messages in a temporary stream.
+ * Used as a thread routine.
+ */
+void *mapChunk(void *argument) {
+	struct chunk *chunk = argument;
+	char *sourceLine = malloc(SOURCE_LINE_LENGTH + 1); /* A buffer for every source line. */
+	FILE *file = openChunk(chunk);
+
+	if (sourceLine == NULL || (chunk->messages = tmpfile()) == NULL ||
+		(chunk->state = createMapState(chunk->fileName, chunk->messages)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	setMessageStream(chunk->messages); /* Messages are printed later, in line order. */
+	mapLines(chunk->state, file, sourceLine, chunk->firstLine, chunk->lineCount);
+
+	free(sourceLine);
+	fclose(file);
+	return NULL;
+}
+
+/**
+ * Assembles the lines of the given chunk into a new second pass state
+ * that keeps the encoded code lines, while the data goes straight into
+ * the part of the data segment that belongs to the chunk.
+ * Used as a thread routine.
+ */
+void *convertChunk(void *argument) {
+	struct chunk *chunk = argument;
+	char *sourceLine = malloc(SOURCE_LINE_LENGTH + 1); /* A buffer for every source line. */
+	FILE *file = openChunk(chunk);
+
+	if (sourceLine == NULL || (chunk->convertState = createConvertState(chunk->symbolTable, chunk->dataSegment,
+		chunk->codeBase, chunk->dataBase, chunk->codeSize)) == NULL)
+		errFatal(); /* Cannot continue without memory. */
+
+	convertLines(chunk->convertState, file, sourceLine, chunk->lineCount);
+
+	free(sourceLine);
+	fclose(file);
+	return NULL;
+}
+
+/**
+ * Frees all the memory used by the given chunks.
+ */
+void freeChunks(Chunks *chunks) {
+	int index;
+
+	for (index = 0; index < chunks->count; index++) {
+		if (chunks->chunks[index].state != NULL)
+			freeMapState(chunks->chunks[index].state);
+		if (chunks->chunks[index].messages != NULL)
+			fclose(chunks->chunks[index].messages);
+		if (chunks->chunks[index].convertState != NULL)
+			freeConvertState(chunks->chunks[index].convertState);
+	}
+	free(chunks->chunks);
+	free(chunks);
+}
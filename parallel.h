@@ -0,0 +1,48 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdio.h>
+
+#include "converter.h"
+
+/**
+ * An header file for the parallel translation unit.
+ */
+
+/**
+ * Defining the chunks data structure.
+ * This structure splits a source file into ranges of whole lines, so
+ * every range can be handled on its own thread.
+ */
+typedef struct chunkset Chunks;
+
+/**
+ * Splits the given source file into at most the given number of chunks
+ * of whole lines, and counts the lines of every chunk.
+ * Returns a pointer to the chunks, or a null pointer if the file is too
+ * small to be worth splitting. Either way the given stream is rewound.
+ */
+Chunks *splitSource(FILE *file, const char *fileName, int jobs);
+
+/**
+ * Maps every chunk on its own thread and replays the results into the
+ * given first pass state in the order of the chunks, so the symbol table,
+ * the counters and the printed messages are the same as if the whole
+ * file was mapped on a single thread.
+ */
+void mapChunks(Chunks *chunks, MapState *state);
+
+/**
+ * Assembles every chunk on its own thread, each into its own part of
+ * the given data segment, and adds the encoded code lines and label
+ * references of the chunks into the given second pass state in the
+ * order of the chunks. Expects the chunks to be mapped by mapChunks.
+ */
+void convertChunks(Chunks *chunks, SymbolTable *symbolTable, char *dataSegment, ConvertState *state);
+
+/**
+ * Frees all the memory used by the given chunks.
+ */
+void freeChunks(Chunks *chunks);
+
+#endif
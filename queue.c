@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "queue.h"
+
+/**
+ * The queue translation unit implements a bounded lock free queue for a
+ * single producer and a single consumer. The producer is the only one to
+ * write the tail and the consumer is the only one to write the head, so
+ * a memory barrier between the copy of an item and the update of its
+ * index is all the synchronization needed. The head and the tail are
+ * kept on separate cache lines, so pushing does not take the line of
+ * the consumer away from it and popping does not take the line of the
+ * producer, and a waiting thread spins for a while before it gives up
+ * its time.
+ */
+
+#define CACHE_LINE 64 /* The size of a cache line (in bytes). */
+#define SPIN_LIMIT 1024 /* The number of times a waiting thread checks the queue before it starts yielding. */
+
+/**
+ * Defining the queue data structure.
+ * A bounded single producer single consumer queue of fixed size items,
+ * used to pass work between two threads without locking. Only one
+ * thread may push into a queue and only one thread may pop from it.
+ */
+struct spscq {
+	char *items; /* The ring of items. */
+	size_t itemSize; /* The size of every item (in bytes). */
+	unsigned long int capacity; /* The number of items in the ring. */
+	char headPadding[CACHE_LINE]; /* Keeps the head off the line of the fields above. */
+	volatile unsigned long int head; /* The number of items that were popped, written by the consumer only. */
+	char tailPadding[CACHE_LINE]; /* Keeps the tail off the line of the head. */
+	volatile unsigned long int tail; /* The number of items that were pushed, written by the producer only. */
+	char endPadding[CACHE_LINE]; /* Keeps the tail off the line of whatever follows the queue. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+void waitQueue(unsigned long int spins);
+
+/**
+ * Creates a new empty queue that holds up to the given number of items
+ * of the given size (in bytes).
+ * Returns a pointer to the new queue or a null pointer if the memory
+ * allocation had failed.
+ */
+Queue *createQueue(unsigned long int capacity, size_t itemSize) {
+	Queue *queue = malloc(sizeof(Queue));
+
+	if (queue == NULL)
+		return NULL; /* Memory allocation failed. */
+	if ((queue->items = malloc(capacity * itemSize)) == NULL) {
+		free(queue);
+		return NULL; /* Memory allocation failed. */
+	}
+
+	queue->itemSize = itemSize;
+	queue->capacity = capacity;
+	queue->head = 0;
+	queue->tail = 0;
+
+	return queue;
+}
+
+/**
+ * Copies the given item into the end of the given queue, waiting for
+ * room if the queue is full. Should be called by the producer only.
+ */
+void pushQueue(Queue *queue, const void *item) {
+	const unsigned long int tail = queue->tail; /* Only this thread writes the tail. */
+	unsigned long int spins;
+
+	for (spins = 0; tail - queue->head == queue->capacity; spins++)
+		waitQueue(spins); /* The queue is full, letting the consumer catch up. */
+	__sync_synchronize(); /* The slot is read by the consumer before the head moved past it. */
+
+	memcpy(queue->items + (tail % queue->capacity) * queue->itemSize, item, queue->itemSize);
+	__sync_synchronize(); /* The item should be visible before the tail. */
+	queue->tail = tail + 1;
+}
+
+/**
+ * Copies the item at the beginning of the given queue into the second
+ * parameter and removes it, waiting for an item if the queue is empty.
+ * Should be called by the consumer only.
+ */
+void popQueue(Queue *queue, void *item) {
+	const unsigned long int head = queue->head; /* Only this thread writes the head. */
+	unsigned long int spins;
+
+	for (spins = 0; queue->tail == head; spins++)
+		waitQueue(spins); /* The queue is empty, letting the producer catch up. */
+	__sync_synchronize(); /* The item was written before the tail moved past it. */
+
+	memcpy(item, queue->items + (head % queue->capacity) * queue->itemSize, queue->itemSize);
+	__sync_synchronize(); /* The item should be copied before the slot is given back. */
+	queue->head = head + 1;
+}
+
+/**
+ * Frees all the memory used by the given queue.
+ */
+void freeQueue(Queue *queue) {
+	free(queue->items);
+	free(queue);
+}
+
+/**
+ * Waits once for the other thread of a queue, after the given number of
+ * waits in a row. The first waits only spin, since the other thread is
+ * usually a moment away, and the later ones yield the processor.
+ */
+void waitQueue(unsigned long int spins) {
+	if (spins >= SPIN_LIMIT)
+		sched_yield();
+#ifdef __SSE2__
+	else
+		_mm_pause(); /* Spinning without flooding the memory system. */
+#endif
+}
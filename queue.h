@@ -0,0 +1,44 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stddef.h>
+
+/**
+ * An header file for the queue translation unit.
+ */
+
+/**
+ * Defining the queue data structure.
+ * A bounded single producer single consumer queue of fixed size items,
+ * used to pass work between two threads without locking. Only one
+ * thread may push into a queue and only one thread may pop from it.
+ */
+typedef struct spscq Queue;
+
+/**
+ * Creates a new empty queue that holds up to the given number of items
+ * of the given size (in bytes).
+ * Returns a pointer to the new queue or a null pointer if the memory
+ * allocation had failed.
+ */
+Queue *createQueue(unsigned long int capacity, size_t itemSize);
+
+/**
+ * Copies the given item into the end of the given queue, waiting for
+ * room if the queue is full. Should be called by the producer only.
+ */
+void pushQueue(Queue *queue, const void *item);
+
+/**
+ * Copies the item at the beginning of the given queue into the second
+ * parameter and removes it, waiting for an item if the queue is empty.
+ * Should be called by the consumer only.
+ */
+void popQueue(Queue *queue, void *item);
+
+/**
+ * Frees all the memory used by the given queue.
+ */
+void freeQueue(Queue *queue);
+
+#endif
@@ -0,0 +1,104 @@
+#define _POSIX_C_SOURCE 200809L /* For mapping files into memory and creating unique files. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "segment.h"
+
+/**
+ * The segment translation unit allocates data segments, either on the
+ * heap or in a spill file mapped into memory, maps output files into
+ * memory so they can be filled in place and maps input files into
+ * memory so they can be read without copying.
+ */
+
+/**
+ * Allocates a data segment of the given size (in bytes). If the last
+ * parameter is not zero the segment is spilled: it is kept in a new
+ * file named after the given template, whose last six characters should
+ * be X and are replaced so no existing file is touched. The file is
+ * removed as soon as it is mapped into memory, so the system can write
+ * its pages out and drop them instead of swapping, and the resident
+ * memory does not grow with the size of the segment. The file should be
+ * on the same disk as the output files, not on a temporary file system
+ * that lives in memory.
+ * Returns a pointer to the segment or a null pointer if it could not be
+ * allocated.
+ */
+char *createSegment(unsigned long int size, char *spillTemplate, char isSpilled) {
+	FILE *file; /* The spill file. */
+	char *segment;
+	int descriptor; /* The spill file, before it has a stream. */
+
+	if (!isSpilled || size == 0)
+		return malloc(size + 1); /* +1 so an empty segment is not a null pointer. */
+
+	if ((descriptor = mkstemp(spillTemplate)) == -1)
+		return NULL; /* The file could not be created. */
+	if ((file = fdopen(descriptor, "wb+")) == NULL) {
+		close(descriptor);
+		remove(spillTemplate);
+		return NULL; /* The file could not be opened as a stream. */
+	}
+	segment = mapFile(file, size);
+	fclose(file); /* The mapping keeps the file until it is unmapped. */
+	remove(spillTemplate);
+
+	return segment;
+}
+
+/**
+ * Frees the given data segment of the given size (in bytes), the last
+ * parameter should be the one the segment was created with.
+ */
+void freeSegment(char *segment, unsigned long int size, char isSpilled) {
+	if (!isSpilled || size == 0)
+		free(segment);
+	else
+		unmapFile(segment, size);
+}
+
+/**
+ * Sets the size of the given file, which should not have been written
+ * trough its stream, to the given size (in bytes) and maps the whole
+ * file into memory, so writing to the memory writes the file.
+ * Returns a pointer to the mapped file or a null pointer if it could not
+ * be mapped.
+ */
+char *mapFile(FILE *file, unsigned long int size) {
+	void *mapped;
+
+	if (ftruncate(fileno(file), size) != 0 ||
+		(mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(file), 0)) == MAP_FAILED)
+		return NULL; /* The file could not be mapped. */
+	return mapped;
+}
+
+/**
+ * Maps the whole of the given file, which is open for reading, into
+ * memory for reading only and sets the last parameter to its size (in
+ * bytes). Returns a pointer to the mapped file or a null pointer if it
+ * is empty or could not be mapped.
+ */
+char *mapInputFile(FILE *file, unsigned long int *size) {
+	struct stat status; /* The status of the file, for its size. */
+	void *mapped;
+
+	if (fstat(fileno(file), &status) != 0 || status.st_size <= 0 ||
+		(mapped = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0)) == MAP_FAILED)
+		return NULL; /* The file could not be mapped. */
+	*size = status.st_size;
+	return mapped;
+}
+
+/**
+ * Unmaps the given file of the given size (in bytes), which was mapped
+ * by mapFile or by mapInputFile. The file itself is not closed.
+ */
+void unmapFile(char *mapped, unsigned long int size) {
+	munmap(mapped, size);
+}
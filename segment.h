@@ -0,0 +1,54 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stdio.h>
+
+/**
+ * An header file for the segment translation unit.
+ */
+
+/**
+ * Allocates a data segment of the given size (in bytes). If the last
+ * parameter is not zero the segment is spilled: it is kept in a new
+ * file named after the given template, whose last six characters should
+ * be X and are replaced so no existing file is touched. The file is
+ * removed as soon as it is mapped into memory, so the system can write
+ * its pages out and drop them instead of swapping, and the resident
+ * memory does not grow with the size of the segment. The file should be
+ * on the same disk as the output files, not on a temporary file system
+ * that lives in memory.
+ * Returns a pointer to the segment or a null pointer if it could not be
+ * allocated.
+ */
+char *createSegment(unsigned long int size, char *spillTemplate, char isSpilled);
+
+/**
+ * Frees the given data segment of the given size (in bytes), the last
+ * parameter should be the one the segment was created with.
+ */
+void freeSegment(char *segment, unsigned long int size, char isSpilled);
+
+/**
+ * Sets the size of the given file, which should not have been written
+ * trough its stream, to the given size (in bytes) and maps the whole
+ * file into memory, so writing to the memory writes the file.
+ * Returns a pointer to the mapped file or a null pointer if it could not
+ * be mapped.
+ */
+char *mapFile(FILE *file, unsigned long int size);
+
+/**
+ * Maps the whole of the given file, which is open for reading, into
+ * memory for reading only and sets the last parameter to its size (in
+ * bytes). Returns a pointer to the mapped file or a null pointer if it
+ * is empty or could not be mapped.
+ */
+char *mapInputFile(FILE *file, unsigned long int *size);
+
+/**
+ * Unmaps the given file of the given size (in bytes), which was mapped
+ * by mapFile or by mapInputFile. The file itself is not closed.
+ */
+void unmapFile(char *mapped, unsigned long int size);
+
+#endif
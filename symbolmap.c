@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "symbolmap.h"
+#include "symboltable.h"
+#include "converter.h"
+#include "errmsg.h"
+#include "utils.h"
+
+/**
+ * The symbol map translation unit writes the optional map files, which
+ * turn addresses back into labels.
+ */
+
+/**
+ * Defining the map entry data structure.
+ * A declared label with its place in memory, for sorting.
+ */
+struct mapentry {
+	unsigned long int address; /* The address of the label. */
+	unsigned long int size; /* The number of bytes until the next label or the end of the segment. */
+	Label label; /* The label. */
+	unsigned char attributes; /* The attribute bits of the label. */
+};
+
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+int compareMapEntries(const void *first, const void *second);
+
+/**
+ * Writes the code and data labels of the given symbol table, sorted by
+ * their addresses, into the given map file and the given map index file.
+ * The size of a label reaches the next label or the end of its segment,
+ * the ic and dc parameters are expected to equal the size of the code
+ * segment and the size of the data segment respectively.
+ * Every line of the map file holds the address, the size, the
+ * attributes and the symbol of a label. The map index file is meant to
+ * be binary searched without parsing: a header of the magic, the
+ * version, the number of records and the size of a record, then the
+ * fixed size records of the address, the size, the attribute bits and
+ * the symbol padded with zeros. Every number is a 32 bit little endian
+ * word.
+ */
+void writeSymbolMap(const char *mapFileName, const char *indexFileName, SymbolTable *symbolTable, const unsigned long int ic, const unsigned long int dc) {
+	const unsigned long int codeEnd = MEMORY_START_ADDRESS + ic; /* The end of the code segment, where the data segment starts. */
+	const unsigned long int dataEnd = codeEnd + dc; /* The end of the data segment. */
+	struct mapentry *entries, *entry; /* The declared labels. */
+	unsigned long int count = 0, index, next; /* The number of declared labels. */
+	char name[MAP_INDEX_NAME_SIZE]; /* The padded symbol of every record. */
+	FILE *map, *mapIndex; /* The output files. */
+	Label label; /* To loop trough the labels. */
+
+	for (label = getFirst(symbolTable); label != NO_LABEL; label = getNext(symbolTable, label))
+		if (isDeclared(symbolTable, label) == SUCCESS)
+			count++;
+
+	if ((entries = malloc((count + 1) * sizeof(struct mapentry))) == NULL) /* +1 so an empty map is not a special case. */
+		errFatal(); /* Cannot continue without memory. */
+	for (label = getFirst(symbolTable), entry = entries; label != NO_LABEL; label = getNext(symbolTable, label)) {
+		if (isDeclared(symbolTable, label) == ERROR)
+			continue; /* External labels have no place in memory. */
+		entry->address = getAddress(symbolTable, label);
+		entry->label = label;
+		entry->attributes = entry->address < codeEnd ? MAP_CODE_BIT : MAP_DATA_BIT; /* The segment tells, a label may be declared twice. */
+		if (hasAttribute(symbolTable, label, EntryLabel) == SUCCESS)
+			entry->attributes |= MAP_ENTRY_BIT;
+		entry++;
+	}
+	qsort(entries, count, sizeof(struct mapentry), compareMapEntries);
+
+	/* Every label reaches the next address that has a label, within its own segment. */
+	for (index = count, next = dataEnd; index-- > 0;) {
+		entry = entries + index;
+		if (entry->address < codeEnd && next > codeEnd)
+			next = codeEnd; /* The last code label. */
+		entry->size = next - entry->address;
+		if (index == 0 || entries[index - 1].address != entry->address)
+			next = entry->address; /* Labels at the same address share the size. */
+	}
+
+	if ((map = fopen(mapFileName, "w+")) == NULL || (mapIndex = fopen(indexFileName, "wb+")) == NULL)
+		errFatal(); /* should not happen but, just in case. */
+
+	fwrite(MAP_INDEX_MAGIC, 1, strlen(MAP_INDEX_MAGIC), mapIndex);
+	writeWord(mapIndex, MAP_INDEX_VERSION);
+	writeWord(mapIndex, count);
+	writeWord(mapIndex, MAP_INDEX_RECORD_SIZE);
+
+	for (index = 0, entry = entries; index < count; index++, entry++) {
+		fprintf(map, "%04ld %ld %s%s %s\n", entry->address, entry->size, (entry->attributes & MAP_CODE_BIT) ? "code" : "data",
+			(entry->attributes & MAP_ENTRY_BIT) ? ",entry" : "", getSymbol(symbolTable, entry->label));
+
+		memset(name, 0, MAP_INDEX_NAME_SIZE);
+		strncpy(name, getSymbol(symbolTable, entry->label), MAP_INDEX_NAME_SIZE - 1); /* A symbol is never longer than that. */
+		writeWord(mapIndex, entry->address);
+		writeWord(mapIndex, entry->size);
+		writeWord(mapIndex, entry->attributes);
+		fwrite(name, 1, MAP_INDEX_NAME_SIZE, mapIndex);
+	}
+
+	fclose(map);
+	fclose(mapIndex);
+	free(entries);
+}
+
+/**
+ * Compares two map entries by their addresses, entries with the same
+ * address keep the order of the symbol table. Used for sorting.
+ */
+int compareMapEntries(const void *first, const void *second) {
+	const struct mapentry *firstEntry = first, *secondEntry = second;
+
+	if (firstEntry->address != secondEntry->address)
+		return firstEntry->address < secondEntry->address ? -1 : 1;
+	return firstEntry->label < secondEntry->label ? -1 : firstEntry->label > secondEntry->label;
+}
@@ -0,0 +1,35 @@
+#ifndef SYMBOLMAP_H
+#define SYMBOLMAP_H
+
+#include "symboltable.h"
+
+/**
+ * An header file for the symbol map translation unit.
+ */
+
+#define MAP_INDEX_MAGIC "SMAP" /* The first four bytes of a map index file. */
+#define MAP_INDEX_VERSION 1 /* The version of the map index layout. */
+#define MAP_INDEX_NAME_SIZE 32 /* The size of the symbol field of a map index record (in bytes). */
+#define MAP_INDEX_HEADER_SIZE 16 /* The size of the header of a map index file (in bytes). */
+#define MAP_INDEX_RECORD_SIZE (12 + MAP_INDEX_NAME_SIZE) /* The size of every map index record (in bytes). */
+#define MAP_CODE_BIT 1 /* A code label, in the attributes field of a map index record. */
+#define MAP_DATA_BIT 2 /* A data label, in the attributes field of a map index record. */
+#define MAP_ENTRY_BIT 4 /* An entry label, in the attributes field of a map index record. */
+
+/**
+ * Writes the code and data labels of the given symbol table, sorted by
+ * their addresses, into the given map file and the given map index file.
+ * The size of a label reaches the next label or the end of its segment,
+ * the ic and dc parameters are expected to equal the size of the code
+ * segment and the size of the data segment respectively.
+ * Every line of the map file holds the address, the size, the
+ * attributes and the symbol of a label. The map index file is meant to
+ * be binary searched without parsing: a header of the magic, the
+ * version, the number of records and the size of a record, then the
+ * fixed size records of the address, the size, the attribute bits and
+ * the symbol padded with zeros. Every number is a 32 bit little endian
+ * word.
+ */
+void writeSymbolMap(const char *mapFileName, const char *indexFileName, SymbolTable *symbolTable, const unsigned long int ic, const unsigned long int dc);
+
+#endif
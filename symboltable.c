@@ -2,78 +2,162 @@
 #include <string.h>
 
 #include "symboltable.h"
+#include "namespace.h"
+#include "keywords.h"
+#include "arena.h"
 #include "asmutils.h"
+#include "utils.h"
 
 /**
  * Contains a collection of utility functions for the symbol
- * table data structure.
+ * table data structure. The labels are stored as a structure of arrays,
+ * in pages that are allocated from an arena of the symbol table, so
+ * adding a label never moves the others and the whole table is freed at
+ * once. The symbols are kept together in one strings pool, after the
+ * reserved keywords, and every label stores the offset of its symbol.
+ * Numeric local labels are only
+ * carried along in an index of their own.
  */
 
-#define ATTRS_PER_LABEL 2 /* Maximum number of attributes per label. */
+#define LABELS_PER_PAGE 256 /* The number of labels allocated together. */
+#define INITIAL_PAGES 16 /* The initial capacity of the pages array. */
+#define INITIAL_POOL 4096 /* The initial capacity of the strings pool. */
+#define ARENA_BLOCK_SIZE 16384 /* The size of the blocks of the arena (in bytes). */
+#define PAGE(symbolTable, label) ((symbolTable)->pages[((label) - 1) / LABELS_PER_PAGE]) /* The page of the given label. */
+#define SLOT(label) (((label) - 1) % LABELS_PER_PAGE) /* The index of the given label in its page. */
+#define ATTRIBUTE_BIT(attribute) (1 << (attribute)) /* The bit of the given attribute in an attributes mask. */
+#define DECLARED_BITS (ATTRIBUTE_BIT(CodeLabel) | ATTRIBUTE_BIT(DataLabel)) /* The attributes of a declared label. */
 
 /**
- * The following function should not be used outside of this translation unit.
+ * Defining the page data structure.
+ * The labels of a symbol table, LABELS_PER_PAGE labels at a time, every
+ * field of the labels in an array of its own.
  */
-SymbolTable *createSymbol(char *symbol, unsigned address);
+struct page {
+	Word symbols[LABELS_PER_PAGE]; /* The offsets of the symbols of the labels in the strings pool. */
+	Word addresses[LABELS_PER_PAGE]; /* The memory addresses of the labels. */
+	unsigned char attributes[LABELS_PER_PAGE]; /* The attributes of the labels, a bit for every attribute. */
+};
 
 /**
  * Defining the symbol table data structure.
  * This structure is used to map all labels in the assembly code,
  * with every label having its assigned address and attributes.
- * A pointer to this structure points to a single label.
+ * The labels are found by their symbol trough a hash table that holds
+ * the reserved keywords as well.
  */
 struct symbolt {
-	char *symbol; /* Stores the symbol of that label. */
-	unsigned long int address; /* Stores the memory address of that label. */
-	unsigned char attributes[ATTRS_PER_LABEL]; /* Stores the attributes codes of that label. */
-	struct symbolt *next; /* A pointer to the next label. */
+	struct page **pages; /* The labels in the order they were added, label n is at index n - 1. */
+	unsigned long int count; /* The number of labels. */
+	unsigned long int pageCount; /* The size of the pages array. */
+	char *pool; /* The symbols of the labels. */
+	unsigned long int poolSize; /* The used part of the strings pool. */
+	unsigned long int poolCapacity; /* The capacity of the strings pool. */
+	Namespace *names; /* Finds the labels by their symbol. */
+	Arena *arena; /* Holds the pages. */
+	LocalLabels *locals; /* The numeric local labels, not in the namespace. */
 };
 
+/**
+ * The following functions should not be used outside this translation unit.
+ */
+Code addKeywords(SymbolTable *symbolTable);
+Code addKeyword(SymbolTable *symbolTable, const char *keyword, NameKind kind);
+Code poolSymbol(SymbolTable *symbolTable, const char *symbol, unsigned long int length);
+
+/**
+ * Creates a new empty symbol table.
+ * Returns a pointer to the new symbol table or a null pointer if the
+ * memory allocation had failed.
+ */
+SymbolTable *createSymbolTable() {
+	SymbolTable *symbolTable = malloc(sizeof(SymbolTable));
+
+	if (symbolTable == NULL)
+		return NULL; /* Memory allocation failed. */
+
+	symbolTable->count = 0;
+	symbolTable->pageCount = INITIAL_PAGES;
+	symbolTable->poolSize = 0;
+	symbolTable->poolCapacity = INITIAL_POOL;
+	symbolTable->pool = NULL;
+	symbolTable->names = NULL;
+	symbolTable->arena = NULL;
+	symbolTable->locals = NULL;
+	if ((symbolTable->pages = malloc(INITIAL_PAGES * sizeof(struct page *))) == NULL ||
+		(symbolTable->pool = malloc(INITIAL_POOL)) == NULL ||
+		(symbolTable->names = createNamespace(&symbolTable->pool)) == NULL ||
+		addKeywords(symbolTable) == ERROR ||
+		(symbolTable->arena = createArena(ARENA_BLOCK_SIZE)) == NULL ||
+		(symbolTable->locals = createLocalLabels()) == NULL) {
+		freeSymbolTable(symbolTable);
+		return NULL; /* Memory allocation failed. */
+	}
+
+	return symbolTable;
+}
+
 /**
  * Returns the address of the given label.
  */
-unsigned long int getAddress(SymbolTable *symbolTable) {
-	return symbolTable->address;
+unsigned long int getAddress(SymbolTable *symbolTable, Label label) {
+	return PAGE(symbolTable, label)->addresses[SLOT(label)];
 }
 
 /**
- * Returns the string representation of the given label.
+ * Returns the string representation of the given label, the string
+ * may move when a label is added.
  */
-char *getSymbol(SymbolTable *symbolTable) {
-	return symbolTable->symbol;
+char *getSymbol(SymbolTable *symbolTable, Label label) {
+	return symbolTable->pool + PAGE(symbolTable, label)->symbols[SLOT(label)];
 }
 
 /**
  * Sets the address field of the given label to the
- * given second parameter.
+ * given third parameter.
  */
-void setAddress(SymbolTable *symbolTable, unsigned long int address) {
-	symbolTable->address = address;
+void setAddress(SymbolTable *symbolTable, Label label, unsigned long int address) {
+	PAGE(symbolTable, label)->addresses[SLOT(label)] = address;
 }
 
 /**
- * Returns a pointer to the next label after the given label.
- * The labels are sorted the way they were added.
+ * Returns the first label of the given symbol table, or NO_LABEL if it
+ * is empty.
  */
-SymbolTable *getNext(SymbolTable *symbolTable) {
-	return symbolTable->next;
+Label getFirst(SymbolTable *symbolTable) {
+	return symbolTable->count == 0 ? NO_LABEL : 1;
 }
 
 /**
- * Searches through the given symbol table for the label that
- * has the same symbol as the given string.
- * Returns a pointer to that label if there is one with a
- * matching symbol, null if otherwise.
+ * Returns the next label after the given label, or NO_LABEL if it is the
+ * last one. The labels are sorted the way they were added.
  */
-SymbolTable *searchLabel(SymbolTable *symbolTable, const char *symbol) {
-	/* Looping through the elements in the data structure. */
-	while (symbolTable != NULL) {
-		if (strcmp(symbolTable->symbol, symbol) == 0)
-			/* If a label with an identical symbol was found a pointer to it would be returned. */
-			return symbolTable;
-		symbolTable = symbolTable->next; /* Continuing to the next element. */
-	}
-	return NULL; /* No matching label was found, a null pointer is returned. */
+Label getNext(SymbolTable *symbolTable, Label label) {
+	return label < symbolTable->count ? label + 1 : NO_LABEL;
+}
+
+/**
+ * Searches the given symbol table for the label that has the
+ * same symbol as the given string.
+ * Returns that label if there is one with a matching symbol,
+ * NO_LABEL if otherwise.
+ */
+Label searchLabel(SymbolTable *symbolTable, const char *symbol) {
+	Label label;
+
+	if (searchSymbol(symbolTable, symbol, &label) == LabelName)
+		return label;
+	return NO_LABEL; /* No matching label was found. */
+}
+
+/**
+ * Searches the given symbol table for the given symbol, which may be a
+ * label or a reserved keyword.
+ * Returns the kind of the symbol, and if it is a label sets the last
+ * parameter to it.
+ */
+NameKind searchSymbol(SymbolTable *symbolTable, const char *symbol, Label *label) {
+	return searchName(symbolTable->names, symbol, label);
 }
 
 /**
@@ -82,16 +166,8 @@ SymbolTable *searchLabel(SymbolTable *symbolTable, const char *symbol) {
  * the given attribute assign to it then ERROR would be returned
  * instead.
  */
-Code hasAttribute(SymbolTable *symbolTable, LabelAttribute labelAttribute) {
-	int index;
-
-	/* Searching trough the attributes array of the given label. */
-	for (index = 0; index < ATTRS_PER_LABEL; index++)
-		if (symbolTable->attributes[index] == labelAttribute)
-			/* A matching attribute was found. */
-			return SUCCESS;
-	/* No matching attribute was found. */
-	return ERROR;
+Code hasAttribute(SymbolTable *symbolTable, Label label, LabelAttribute labelAttribute) {
+	return (PAGE(symbolTable, label)->attributes[SLOT(label)] & ATTRIBUTE_BIT(labelAttribute)) ? SUCCESS : ERROR;
 }
 
 /**
@@ -99,141 +175,139 @@ Code hasAttribute(SymbolTable *symbolTable, LabelAttribute labelAttribute) {
  * SUCCESS code would be returned and ERROR if otherwise. Used
  * for checking if a label is declared.
  */
-Code isDeclared(SymbolTable *symbolTable) {
-	int index;
-
-	/* Searching trough the attributes array of the given label. */
-	for (index = 0; index < ATTRS_PER_LABEL; index++)
-		if (symbolTable->attributes[index] == CodeLabel || symbolTable->attributes[index] == DataLabel)
-			/* A code or data attribute was found. */
-			return SUCCESS;
-
-	/* The label is not declared. */
-	return ERROR;
+Code isDeclared(SymbolTable *symbolTable, Label label) {
+	return (PAGE(symbolTable, label)->attributes[SLOT(label)] & DECLARED_BITS) ? SUCCESS : ERROR;
 }
 
 /**
- * Adds a new label to the given symbol table and assigns it the given
- * symbol and the given address.
- * In case the given symbol table is null the newly created label can
- * still be accessed via the returned pointer.
- * Returns a pointer to the newly created label if the label was
- * created successfully, and a null pointer if otherwise.
+ * Adds a new label to the end of the given symbol table and assigns it
+ * the given symbol and the given address. The symbol should not be in
+ * the symbol table already. Labels are never removed, a label that
+ * should be ignored is left without a code or a data attribute.
+ * Returns the newly created label if the label was created successfully,
+ * and NO_LABEL if otherwise.
  */
-SymbolTable *addSymbol(SymbolTable *symbolTable, char *symbol, unsigned long int address) {
-	char *labelSymbol = malloc(strlen(symbol) + 1); /* Allocating memory for the symbol field */
-	SymbolTable *newLabel; /* To store the new label. */
-	
-	if (labelSymbol == NULL)
-		return NULL; /* Memory allocation failed. */
+Label addSymbol(SymbolTable *symbolTable, const char *symbol, unsigned long int address) {
+	const unsigned long int page = symbolTable->count / LABELS_PER_PAGE; /* The page of the new label. */
+	const unsigned long int slot = symbolTable->count % LABELS_PER_PAGE; /* The index of the new label in its page. */
+	const unsigned long int length = strlen(symbol) + 1; /* +1 for a terminating character. */
+	struct page **pages; /* To grow the pages array. */
 
-	strcpy(labelSymbol, symbol); /* Copying the given string to the symbol field. */
-	newLabel = createSymbol(labelSymbol, address); /* Storing the newly created label. */
+	if (slot == 0) { /* Making room for the new label. */
+		if (page == symbolTable->pageCount) {
+			if ((pages = realloc(symbolTable->pages, symbolTable->pageCount * 2 * sizeof(struct page *))) == NULL)
+				return NO_LABEL; /* Memory allocation failed. */
+			symbolTable->pages = pages;
+			symbolTable->pageCount *= 2;
+		}
+		if ((symbolTable->pages[page] = allocArena(symbolTable->arena, sizeof(struct page))) == NULL)
+			return NO_LABEL; /* Memory allocation failed. */
+	}
+	if (poolSymbol(symbolTable, symbol, length) == ERROR)
+		return NO_LABEL; /* The symbol does not fit in the strings pool. */
 
-	/* If the given label is a null pointer then there is nothing to skip to. */
-	if (symbolTable != NULL) {
-		/* Skipping to the end of the list. */
-		while (symbolTable->next != NULL)
-			symbolTable = symbolTable->next;
+	symbolTable->pages[page]->symbols[slot] = symbolTable->poolSize;
+	symbolTable->pages[page]->addresses[slot] = address; /* Initializing the address. */
+	symbolTable->pages[page]->attributes[slot] = 0; /* No attributes yet. */
 
-		/*
-		 * Adding the new label with the given parameters to the end of the
-		 * given list.
-		 */
-		symbolTable->next = newLabel;
-	}
+	if (addLabelName(symbolTable->names, symbolTable->poolSize, symbolTable->count + 1) == ERROR)
+		return NO_LABEL; /* Memory allocation failed, the symbol is overwritten by the next one. */
+	symbolTable->poolSize += length;
 
-	/* Returning a pointer to the new label. */
-	return newLabel;
+	return ++symbolTable->count; /* Returning the new label. */
 }
 
 /**
- * Creates a new symbol table node with the given symbol and address.
- * The pointer to the next node is initialized to null while every index
- * of the attributes array is marked as empty.
- * This function returns a pointer to the new symbol table node or a null
- * pointer if it failed to create it.
- * Used internally by the addSymbol function.
+ * Adds the given attribute code to the given label.
+ * Returns a code to determine if the operation was successful or not.
  */
-SymbolTable *createSymbol(char *symbol, unsigned address) {
-	int i;
-	SymbolTable *symbolTable = malloc(sizeof(SymbolTable));
-	/*
-	In case no memory could be allocated a null pointer will be returned
-	instead.
-	*/
-	if (symbolTable == NULL) {
-		return NULL;
-	}
+Code addAttribute(SymbolTable *symbolTable, Label label, LabelAttribute labelAttribute) {
+	unsigned char *attributes = &PAGE(symbolTable, label)->attributes[SLOT(label)];
 
-	symbolTable->symbol = symbol; /* Initializing the symbol. */
-	symbolTable->address = address; /* Initializing the address. */
-	symbolTable->next = NULL; /* Initializing the pointer to the next node. */
+	/* A label holds up to two different attributes, clearing the lowest bit tells if there are two already. */
+	if (!(*attributes & ATTRIBUTE_BIT(labelAttribute)) && (*attributes & (*attributes - 1)) != 0)
+		return ERROR; /* The attribute code was not added, the operation failed. */
 
-	/* Setting every index of the attributes array to null. */
-	for (i = 0; i < ATTRS_PER_LABEL; i++) {
-		symbolTable->attributes[i] = EmptyLabel;
-	}
+	*attributes |= ATTRIBUTE_BIT(labelAttribute); /* Adding the attribute code, the operation was successful. */
+	return SUCCESS;
+}
 
-	return symbolTable; /* Returning the address of the new symbol table node. */
+/**
+ * Returns the numeric local labels of the given symbol table. They are
+ * kept apart from the labels, so they are never found by their symbol.
+ */
+LocalLabels *getLocalLabels(SymbolTable *symbolTable) {
+	return symbolTable->locals;
 }
 
 /**
- * Removes the given label on the second parameter from the given
- * symbol table on the first parameter.
+ * Frees all the memory used by the symbol table data structure.
  */
-void removeSymbol(SymbolTable **symbolTable, SymbolTable *label) {
-	if (*symbolTable != NULL)
-		return; /* Given symbol table is empty. */
+void freeSymbolTable(SymbolTable *symbolTable) {
+	free(symbolTable->pages);
+	free(symbolTable->pool);
+	if (symbolTable->names != NULL)
+		freeNamespace(symbolTable->names);
+	if (symbolTable->arena != NULL)
+		freeArena(symbolTable->arena);
+	if (symbolTable->locals != NULL)
+		freeLocalLabels(symbolTable->locals);
+	free(symbolTable);
+}
 
-	if (*symbolTable == label) {
-		*symbolTable = (*symbolTable)->next; /* Removing the first node from the chain. */
-			/* Releasing the memory used by it. */
-		free(label->symbol);
-		free(label);
-	}
-	while ((*symbolTable)->next != NULL) {
-		if ((*symbolTable)->next == label) {
-			(*symbolTable)->next = label->next; /* Removing the label from the chain. */
-			/* Releasing the memory used by it. */
-			free(label->symbol);
-			free(label);
-		}
-	}
+/**
+ * Adds every reserved keyword to the strings pool and to the namespace
+ * of the given symbol table, so no label can take its name.
+ * Returns a code to determine if the operation was successful or not.
+ */
+Code addKeywords(SymbolTable *symbolTable) {
+	unsigned int index;
+
+	for (index = 0; index < getOperatorCount(); index++)
+		if (addKeyword(symbolTable, getOperatorKeyword(getOperator(index)), OperatorName) == ERROR)
+			return ERROR; /* Memory allocation failed. */
+	for (index = 0; index < getInstructorCount(); index++)
+		if (addKeyword(symbolTable, getInstructorKeyword(getInstructor(index)), InstructorName) == ERROR)
+			return ERROR; /* Memory allocation failed. */
+
+	return SUCCESS;
 }
 
 /**
- * Adds the given attribute code to the given label.
+ * Adds the given keyword of the given kind to the strings pool and to
+ * the namespace of the given symbol table.
  * Returns a code to determine if the operation was successful or not.
  */
-Code addAttribute(SymbolTable *symbolTable, LabelAttribute labelAttribute) {
-	int index;
+Code addKeyword(SymbolTable *symbolTable, const char *keyword, NameKind kind) {
+	const unsigned long int length = strlen(keyword) + 1; /* +1 for a terminating character. */
 
-	for (index = 0; index < ATTRS_PER_LABEL; index++) {
-		/* Checks if a new attribute code can be inserted or if that attribute is already there. */
-		if (symbolTable->attributes[index] == EmptyLabel || symbolTable->attributes[index] == labelAttribute) {
-			/* Adding the attribute code, the operation was successful. */
-			symbolTable->attributes[index] = labelAttribute;
-			return SUCCESS;
-		}
-	}
-	/* The attribute code was not added, the operation failed. */
-	return ERROR;
+	if (poolSymbol(symbolTable, keyword, length) == ERROR ||
+		addKeywordName(symbolTable->names, symbolTable->poolSize, kind) == ERROR)
+		return ERROR; /* Memory allocation failed. */
+	symbolTable->poolSize += length;
+
+	return SUCCESS;
 }
 
 /**
- * Frees all the memory used by the symbol table data structure.
+ * Copies the given symbol of the given length, terminating character
+ * included, to the end of the used part of the strings pool of the given
+ * symbol table, growing the pool if needed. The symbol is not counted as
+ * used, so it is overwritten by the next one unless the caller does.
+ * Returns a code to determine if the operation was successful or not.
  */
-void freeSymbolTable(SymbolTable *symbolTable) {
-	SymbolTable *temp; /* Temporary pointer. */
-	while (symbolTable != NULL) {
-		/*
-		Using the temporary pointer to free every node without loosing the
-		next one.
-		*/
-		temp = symbolTable;
-		symbolTable = symbolTable->next;
-		free(temp->symbol);
-		free(temp);
+Code poolSymbol(SymbolTable *symbolTable, const char *symbol, unsigned long int length) {
+	char *pool; /* To grow the strings pool. */
+
+	if (symbolTable->poolSize + length > WORD_MAX)
+		return ERROR; /* The offset of the symbol would not fit. */
+	while (symbolTable->poolSize + length > symbolTable->poolCapacity) { /* Making room for the symbol. */
+		if ((pool = realloc(symbolTable->pool, symbolTable->poolCapacity * 2)) == NULL)
+			return ERROR; /* Memory allocation failed. */
+		symbolTable->pool = pool;
+		symbolTable->poolCapacity *= 2;
 	}
+	memcpy(symbolTable->pool + symbolTable->poolSize, symbol, length); /* Copying the given string to the strings pool. */
+
+	return SUCCESS;
 }
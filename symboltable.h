@@ -2,19 +2,30 @@
 #define SYMBOLTABLE_H
 
 #include "asmutils.h"
+#include "namespace.h"
+#include "locallabels.h"
 
 /**
  * An header file for the symbol table translation unit.
  */
 
+#define NO_LABEL 0 /* Not a label, the labels of a symbol table start at 1. */
+
 /**
  * Defining the symbol table data structure.
  * This structure is used to map all labels in the assembly code,
  * with every label having its assigned address and attributes.
- * A pointer to this structure points to a single label.
+ * The labels are found by their symbol trough a hash table that holds
+ * the reserved keywords as well.
  */
 typedef struct symbolt SymbolTable;
 
+/**
+ * A label of a symbol table. The labels are numbered by the order they
+ * were added, starting at 1, so NO_LABEL is never a label.
+ */
+typedef unsigned long int Label;
+
 /**
  * Attributes for labels.
  * used for distinguishing different types of labels.
@@ -27,35 +38,57 @@ typedef enum {
     ExternLabel /* External attribute. */
 } LabelAttribute;
 
+/**
+ * Creates a new empty symbol table.
+ * Returns a pointer to the new symbol table or a null pointer if the
+ * memory allocation had failed.
+ */
+SymbolTable *createSymbolTable();
+
 /**
  * Returns the address of the given label.
  */
-unsigned long int getAddress(SymbolTable *symbolTable);
+unsigned long int getAddress(SymbolTable *symbolTable, Label label);
 
 /**
- * Returns the string representation of the given label.
+ * Returns the string representation of the given label, the string
+ * may move when a label is added.
  */
-char *getSymbol(SymbolTable *symbolTable);
+char *getSymbol(SymbolTable *symbolTable, Label label);
 
 /**
  * Sets the address field of the given label to the
- * given second parameter.
+ * given third parameter.
  */
-void setAddress(SymbolTable *symbolTable, unsigned long int address);
+void setAddress(SymbolTable *symbolTable, Label label, unsigned long int address);
 
 /**
- * Returns a pointer to the next label after the given label.
- * The labels are sorted the way they were added.
+ * Returns the first label of the given symbol table, or NO_LABEL if it
+ * is empty.
  */
-SymbolTable *getNext(SymbolTable *symbolTable);
+Label getFirst(SymbolTable *symbolTable);
 
 /**
- * Searches through the given symbol table for the label that
- * has the same symbol as the given string.
- * Returns a pointer to that label if there is one with a
- * matching symbol, null if otherwise.
+ * Returns the next label after the given label, or NO_LABEL if it is the
+ * last one. The labels are sorted the way they were added.
  */
-SymbolTable *searchLabel(SymbolTable *symbolTable, const char *symbol);
+Label getNext(SymbolTable *symbolTable, Label label);
+
+/**
+ * Searches the given symbol table for the label that has the
+ * same symbol as the given string.
+ * Returns that label if there is one with a matching symbol,
+ * NO_LABEL if otherwise.
+ */
+Label searchLabel(SymbolTable *symbolTable, const char *symbol);
+
+/**
+ * Searches the given symbol table for the given symbol, which may be a
+ * label or a reserved keyword.
+ * Returns the kind of the symbol, and if it is a label sets the last
+ * parameter to it.
+ */
+NameKind searchSymbol(SymbolTable *symbolTable, const char *symbol, Label *label);
 
 /**
  * Checks if the given label has the given attribute, if it does then
@@ -63,36 +96,36 @@ SymbolTable *searchLabel(SymbolTable *symbolTable, const char *symbol);
  * the given attribute assign to it then ERROR would be returned
  * instead.
  */
-Code hasAttribute(SymbolTable *symbolTable, LabelAttribute labelAttribute);
+Code hasAttribute(SymbolTable *symbolTable, Label label, LabelAttribute labelAttribute);
 
 /**
  * Checks if the given label has code or data attribute, if it does then a
  * SUCCESS code would be returned and ERROR if otherwise. Used
  * for checking if a label is declared.
  */
-Code isDeclared(SymbolTable *symbolTable);
+Code isDeclared(SymbolTable *symbolTable, Label label);
 
 /**
- * Adds a new label to the given symbol table and assigns it the given
- * symbol and the given address.
- * In case the given symbol table is null the newly created label can
- * still be accessed via the returned pointer.
- * Returns a pointer to the newly created label if the label was
- * created successfully, and a null pointer if otherwise.
+ * Adds a new label to the end of the given symbol table and assigns it
+ * the given symbol and the given address. The symbol should not be in
+ * the symbol table already. Labels are never removed, a label that
+ * should be ignored is left without a code or a data attribute.
+ * Returns the newly created label if the label was created successfully,
+ * and NO_LABEL if otherwise.
  */
-SymbolTable *addSymbol(SymbolTable *symbolTable, char *symbol, unsigned long int address);
+Label addSymbol(SymbolTable *symbolTable, const char *symbol, unsigned long int address);
 
 /**
- * Removes the given label on the second parameter from the given
- * symbol table on the first parameter.
+ * Adds the given attribute code to the given label.
+ * Returns a code to determine if the operation was successful or not.
  */
-void removeSymbol(SymbolTable **symbolTable, SymbolTable *label);
+Code addAttribute(SymbolTable *symbolTable, Label label, LabelAttribute labelAttribute);
 
 /**
- * Adds the given attribute code to the given label.
- * Returns a code to determine if the operation was successful or not.
+ * Returns the numeric local labels of the given symbol table. They are
+ * kept apart from the labels, so they are never found by their symbol.
  */
-Code addAttribute(SymbolTable *symbolTable , LabelAttribute labelAttribute);
+LocalLabels *getLocalLabels(SymbolTable *symbolTable);
 
 /**
  * Frees all the memory used by the symbol table data structure.
@@ -1,7 +1,14 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "utils.h"
 
+#define COPY_BUFFER_SIZE 4096 /* The size of the buffer used for copying streams. */
+#define NEW_LINE '\n'
+#define HASH_OFFSET 2166136261UL /* The initial value of the hash (32 bit FNV-1a). */
+#define HASH_PRIME 16777619UL /* The multiplier of the hash (32 bit FNV-1a). */
+#define HASH_MASK 0xFFFFFFFFUL /* The hash is kept 32 bits long on every platform. */
+
 /**
  * Contains a collection of general utility functions that can be
  * used anywhere in the program.
@@ -19,3 +26,87 @@ void subString(char *dest, const char *src, int start, int end) {
 		dest[i++] = src[start++];
 	}
 }
+
+/**
+ * Copies the given number of bytes from the current position of the
+ * source stream into the destination stream. If the given count is
+ * negative the source stream is copied until its end.
+ * Returns the number of bytes that were copied.
+ */
+long int copyStream(FILE *dest, FILE *src, long int count) {
+	char buffer[COPY_BUFFER_SIZE]; /* To move the bytes in blocks. */
+	long int copied = 0; /* The number of bytes that were copied so far. */
+	size_t size; /* The size of every block. */
+
+	while (count < 0 || copied < count) {
+		size = COPY_BUFFER_SIZE;
+		if (count >= 0 && count - copied < COPY_BUFFER_SIZE)
+			size = count - copied; /* The last block is smaller. */
+		if ((size = fread(buffer, 1, size, src)) == 0)
+			break; /* The source stream has ended. */
+		fwrite(buffer, 1, size, dest);
+		copied += size;
+	}
+
+	return copied;
+}
+
+/**
+ * Hashes the given number of bytes starting from the given pointer,
+ * continuing from the given hash value. The first hash value of a
+ * sequence should be zero.
+ * Returns a 32 bit hash value.
+ */
+unsigned long int hashBytes(const void *bytes, unsigned long int size, unsigned long int hash) {
+	const unsigned char *byte = bytes; /* To loop trough the bytes. */
+
+	if (hash == 0)
+		hash = HASH_OFFSET; /* The beginning of a sequence. */
+	while (size-- > 0) {
+		hash ^= *byte++;
+		hash = (hash * HASH_PRIME) & HASH_MASK;
+	}
+
+	return hash;
+}
+
+/**
+ * Counts the lines of the given stream from its current position until
+ * its end, without reading them as source lines. The part after the last
+ * new line character is a line as well, even if it is empty.
+ * Returns the number of lines.
+ */
+unsigned long int countLines(FILE *file) {
+	char buffer[COPY_BUFFER_SIZE]; /* The stream is read in blocks. */
+	unsigned long int count = 1; /* The last line has no new line character. */
+	size_t size; /* The size of every block. */
+	char *c, *end; /* To find the new line characters in every block. */
+
+	while ((size = fread(buffer, 1, COPY_BUFFER_SIZE, file)) > 0) {
+		end = buffer + size;
+		for (c = buffer; (c = memchr(c, NEW_LINE, end - c)) != NULL; c++)
+			count++;
+	}
+
+	return count;
+}
+
+/**
+ * Writes the given number into the given stream as a 32 bit little
+ * endian word.
+ */
+void writeWord(FILE *output, unsigned long int word) {
+	int index;
+
+	for (index = 0; index < 4; index++, word >>= 8)
+		fputc((int)(word & 0xFF), output);
+}
+
+/**
+ * Writes the given number into the given stream as a 16 bit little
+ * endian half word.
+ */
+void writeHalfWord(FILE *output, unsigned int halfWord) {
+	fputc((int)(halfWord & 0xFF), output);
+	fputc((int)((halfWord >> 8) & 0xFF), output);
+}
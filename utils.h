@@ -2,15 +2,60 @@
 #define UTILS_H
 
 #include <stdio.h>
+#include <limits.h>
 
 /**
  * An header file for the utilities (utils) translation unit.
  */
 
+#if UINT_MAX >= 0xFFFFFFFFUL
+typedef unsigned int Word; /* A 32 bit word. */
+#else
+typedef unsigned long int Word; /* A 32 bit word. */
+#endif
+
+#define WORD_MAX 0xFFFFFFFFUL /* The largest value of a word. */
+
 /**
  * Copies a sub-string from the source parameter into the destination parameter,
  * starting from the given start index until the given end index (included).
  */
 void subString(char *dest, const char *src, int start, int end);
 
+/**
+ * Copies the given number of bytes from the current position of the
+ * source stream into the destination stream. If the given count is
+ * negative the source stream is copied until its end.
+ * Returns the number of bytes that were copied.
+ */
+long int copyStream(FILE *dest, FILE *src, long int count);
+
+/**
+ * Hashes the given number of bytes starting from the given pointer,
+ * continuing from the given hash value. The first hash value of a
+ * sequence should be zero.
+ * Returns a 32 bit hash value.
+ */
+unsigned long int hashBytes(const void *bytes, unsigned long int size, unsigned long int hash);
+
+/**
+ * Counts the lines of the given stream from its current position until
+ * its end, without reading them as source lines. The part after the last
+ * new line character is a line as well, even if it is empty.
+ * Returns the number of lines.
+ */
+unsigned long int countLines(FILE *file);
+
+/**
+ * Writes the given number into the given stream as a 32 bit little
+ * endian word.
+ */
+void writeWord(FILE *output, unsigned long int word);
+
+/**
+ * Writes the given number into the given stream as a 16 bit little
+ * endian half word.
+ */
+void writeHalfWord(FILE *output, unsigned int halfWord);
+
 #endif